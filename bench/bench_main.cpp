@@ -0,0 +1,470 @@
+// Host microbenchmarks for the parse, format and render kernels
+// ([env:bench] in platformio.ini):
+//
+//   pio run -e bench
+//   .pio/build/bench/program --out bench.json
+//
+// Each case is one call of the firmware code as the loop makes it. Calls
+// run in batches sized to take about --batch-ms; --warmup untimed batches
+// come first, then --reps timed ones, reported as min/median/mean/max
+// nanoseconds per call. The JSON goes to --out (or stdout), a table to
+// stderr. --filter TEXT only runs cases whose name contains TEXT; --list
+// prints the names.
+//
+// Times are real (steady_clock). The simulator's virtual clock (host/sim.h)
+// only drives the firmware's own idea of time, e.g. the minute rollover.
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "sim.h"
+#include "payloads.h"
+#include "display_manager.h"
+#include "flight_data_manager.h"
+#include "weather_manager.h"
+#include "ft_wifi_manager.h"
+#include "time_service.h"
+#include "json_arena.h"
+#include "ft_log.h"
+#include "DSEG14Modern_Bold18pt7b.h"
+#include "DSEG14Modern_Bold20pt7b.h"
+#include "DSEGWeather18pt7b.h"
+
+// Same zone as main.cpp: the DST rules are part of the time cost
+static const char *LOCAL_TIMEZONE = "GMT0BST,M3.5.0/1,M10.5.0";
+
+// Results are folded in here so the calls can't be optimised away
+static volatile uint32_t sink;
+
+struct BenchOptions
+{
+    uint32_t reps = 15;
+    uint32_t warmup = 3;
+    uint32_t batchMs = 20;
+    const char *filter = nullptr;
+    const char *out = nullptr;
+    bool list = false;
+};
+
+struct Case
+{
+    const char *name;
+    void (*run)(const void *arg);
+    const void *arg;
+};
+
+struct Result
+{
+    const char *name;
+    uint32_t calls; // per batch
+    double minNs;
+    double medianNs;
+    double meanNs;
+    double maxNs;
+};
+
+// A response body read through Stream, as deserializeJson() gets it from
+// HTTPClient on the device
+class MemoryStream : public Stream
+{
+public:
+    explicit MemoryStream(const char *text) : data(text), size(strlen(text)), pos(0) {}
+
+    int available() override { return (int)(size - pos); }
+    int read() override { return pos < size ? (uint8_t)data[pos++] : -1; }
+    int peek() override { return pos < size ? (uint8_t)data[pos] : -1; }
+    size_t readBytes(char *buffer, size_t length) override
+    {
+        size_t n = std::min(length, size - pos);
+        memcpy(buffer, data + pos, n);
+        pos += n;
+        return n;
+    }
+    void write(uint8_t) override {}
+
+private:
+    const char *data;
+    size_t size;
+    size_t pos;
+};
+
+// JSON: filter and document on the arena, parsed from a stream, as the
+// managers' fetchData() does it
+
+typedef void (*FilterBuilder)(JsonDocument &filter);
+
+struct JsonCase
+{
+    FilterBuilder buildFilter;
+    const char *payload;
+};
+
+static const JsonCase FLIGHT_JSON = {FlightDataManager::buildFilter, FLIGHT_PAYLOAD};
+static const JsonCase NO_FLIGHT_JSON = {FlightDataManager::buildFilter, NO_FLIGHT_PAYLOAD};
+static const JsonCase WEATHER_JSON = {WeatherManager::buildFilter, WEATHER_PAYLOAD};
+
+static DeserializationError parse(const JsonCase &c, JsonDocument &doc)
+{
+    JsonDocument filter(JsonArena::allocator());
+    c.buildFilter(filter);
+    MemoryStream body(c.payload);
+    return deserializeJson(doc, body, DeserializationOption::Filter(filter));
+}
+
+static void benchJson(const void *arg)
+{
+    JsonArena::reset();
+    JsonDocument doc(JsonArena::allocator());
+    sink += parse(*(const JsonCase *)arg, doc) ? 1 : 0;
+}
+
+// Flight fields into the display record, from a document parsed once
+static JsonDocument flightDoc;
+
+static void benchFlightRecord(const void *)
+{
+    FlightRecord record;
+    FlightDataManager::parseRecord(flightDoc, record);
+    sink += (uint8_t)record.callsign[0];
+}
+
+// The path parseRecord() replaced: the display looked each field up by key
+// in the document (the callsign twice), "?" for missing ones
+static void lookupField(const char *key, FieldText &out)
+{
+    const char *value = flightDoc[key].as<const char *>();
+    if (!value || *value == '\0' || strcmp(value, "null") == 0)
+    {
+        out = "?";
+        return;
+    }
+    out = value;
+}
+
+static void benchFlightLookups(const void *)
+{
+    const char *callsign = flightDoc["callsign"].as<const char *>();
+    FieldText flightNumber;
+    FieldText origin;
+    FieldText destination;
+    FieldText aircraftCode;
+    if (callsign && *callsign && strcmp(callsign, "null") != 0)
+    {
+        lookupField("callsign", flightNumber);
+        lookupField("originAirportIata", origin);
+        lookupField("destinationAirportIata", destination);
+        lookupField("aircraftCode", aircraftCode);
+    }
+    sink += (uint8_t)flightNumber.c_str()[0];
+}
+
+// Local time: the per-tick check, a minute rollover, and the full
+// localtime_r() recompute after a clock step
+
+static void benchTimeSameMinute(const void *)
+{
+    sink += TimeService::update();
+}
+
+static void benchTimeNextMinute(const void *)
+{
+    Sim::adjustDevice(60000000);
+    sink += TimeService::update();
+}
+
+static void benchTimeRecompute(const void *)
+{
+    TimeService::invalidate();
+    sink += TimeService::update();
+}
+
+// WiFi bars: the RSSI mapping, and drawing plus flushing the icon with the
+// bar count changing every call
+
+static void benchWiFiCalculate(const void *)
+{
+    static long rssi = -90;
+    sink += DisplayManager::calculateWiFiBars(rssi);
+    if (++rssi > -40)
+    {
+        rssi = -90;
+    }
+}
+
+static void benchWiFiDraw(const void *)
+{
+    Sim::options.rssi = Sim::options.rssi == -50 ? -80 : -50;
+    DisplayManager::displayWiFiStrength();
+}
+
+// Text rasterization into a canvas like the display's, one string per font
+
+struct TextCase
+{
+    const GFXfont *font; // nullptr: the built-in 5x7 font
+    const char *text;
+    int16_t x;
+    int16_t y;
+};
+
+static const TextCase CLASSIC_TEXT = {nullptr, "192.168.4.1", 2, 10};
+static const TextCase MONO_TEXT = {&FreeMonoBold12pt7b, "IBB8121", Layout::FLIGHT_NUMBER.x,
+                                   Layout::FLIGHT_NUMBER.baseline};
+static const TextCase DSEG_MINI_TEXT = {&DSEG14ModernMini_Bold18pt7b, "12:34", Layout::TIME.x, Layout::TIME.baseline};
+static const TextCase DSEG_18_TEXT = {&DSEG14Modern_Bold18pt7b, "12:34", Layout::TIME.x, Layout::TIME.baseline};
+static const TextCase DSEG_20_TEXT = {&DSEG14Modern_Bold20pt7b, "12:34", Layout::TIME.x, Layout::TIME.baseline};
+static const TextCase WEATHER_TEXT = {&DSEGWeather18pt7b, "ABC", Layout::TIME.x, Layout::TIME.baseline};
+
+static IndexedCanvas textCanvas(SCREEN_WIDTH, SCREEN_HEIGHT);
+
+static void benchText(const void *arg)
+{
+    const TextCase &t = *(const TextCase *)arg;
+    textCanvas.setFont(t.font);
+    textCanvas.setTextColor(ST77XX_GREEN);
+    textCanvas.setCursor(t.x, t.y);
+    textCanvas.print(t.text);
+}
+
+static const Case CASES[] = {
+    {"json/flight", benchJson, &FLIGHT_JSON},
+    {"json/no-flight", benchJson, &NO_FLIGHT_JSON},
+    {"json/weather", benchJson, &WEATHER_JSON},
+    {"record/flight", benchFlightRecord, nullptr},
+    {"record/key-lookups", benchFlightLookups, nullptr},
+    {"time/same-minute", benchTimeSameMinute, nullptr},
+    {"time/next-minute", benchTimeNextMinute, nullptr},
+    {"time/recompute", benchTimeRecompute, nullptr},
+    {"wifi/calculate-bars", benchWiFiCalculate, nullptr},
+    {"wifi/draw-bars", benchWiFiDraw, nullptr},
+    {"text/classic", benchText, &CLASSIC_TEXT},
+    {"text/FreeMonoBold12pt7b", benchText, &MONO_TEXT},
+    {"text/DSEG14ModernMini_Bold18pt7b", benchText, &DSEG_MINI_TEXT},
+    {"text/DSEG14Modern_Bold18pt7b", benchText, &DSEG_18_TEXT},
+    {"text/DSEG14Modern_Bold20pt7b", benchText, &DSEG_20_TEXT},
+    {"text/DSEGWeather18pt7b", benchText, &WEATHER_TEXT},
+};
+static const size_t CASE_COUNT = sizeof(CASES) / sizeof(CASES[0]);
+
+static double batchNs(const Case &c, uint32_t calls)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < calls; i++)
+    {
+        c.run(c.arg);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static Result measure(const Case &c, const BenchOptions &o)
+{
+    // Grow the batch until it takes batchMs
+    double target = o.batchMs * 1e6;
+    uint32_t calls = 1;
+    double ns = batchNs(c, calls);
+    while (ns < target && calls < (1u << 26))
+    {
+        calls = ns > 0 && ns * 2 < target ? (uint32_t)std::min(calls * target / ns, calls * 16.0) : calls * 2;
+        ns = batchNs(c, calls);
+    }
+    for (uint32_t i = 0; i < o.warmup; i++)
+    {
+        batchNs(c, calls);
+    }
+
+    std::vector<double> perCall;
+    for (uint32_t i = 0; i < o.reps; i++)
+    {
+        perCall.push_back(batchNs(c, calls) / calls);
+    }
+    std::sort(perCall.begin(), perCall.end());
+    double total = 0;
+    for (double v : perCall)
+    {
+        total += v;
+    }
+    size_t mid = perCall.size() / 2;
+    double median = perCall.size() % 2 ? perCall[mid] : (perCall[mid - 1] + perCall[mid]) / 2;
+    return {c.name, calls, perCall.front(), median, total / perCall.size(), perCall.back()};
+}
+
+static void writeJson(FILE *file, const std::vector<Result> &results, const BenchOptions &o)
+{
+    fprintf(file, "{\n  \"suite\": \"flight-tracker\",\n  \"compiler\": \"%s\",\n", __VERSION__);
+#ifdef __OPTIMIZE__
+    fprintf(file, "  \"optimized\": true,\n");
+#else
+    fprintf(file, "  \"optimized\": false,\n");
+#endif
+    fprintf(file, "  \"reps\": %u,\n  \"warmup\": %u,\n  \"batch_ms\": %u,\n  \"results\": [\n", (unsigned)o.reps,
+            (unsigned)o.warmup, (unsigned)o.batchMs);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result &r = results[i];
+        fprintf(file,
+                "    {\"name\": \"%s\", \"calls\": %u, \"ns_min\": %.2f, \"ns_median\": %.2f, \"ns_mean\": %.2f, "
+                "\"ns_max\": %.2f}%s\n",
+                r.name, (unsigned)r.calls, r.minNs, r.medianNs, r.meanNs, r.maxNs,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr, "usage: %s [--reps N] [--warmup N] [--batch-ms MS] [--filter TEXT] [--out FILE] [--list]\n",
+            program);
+    exit(2);
+}
+
+static void parseArgs(int argc, char **argv, BenchOptions &o)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *name = argv[i];
+        if (strcmp(name, "--list") == 0)
+        {
+            o.list = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+        }
+        const char *value = argv[++i];
+        if (strcmp(name, "--reps") == 0)
+        {
+            o.reps = std::max(1ul, strtoul(value, nullptr, 10));
+        }
+        else if (strcmp(name, "--warmup") == 0)
+        {
+            o.warmup = (uint32_t)strtoul(value, nullptr, 10);
+        }
+        else if (strcmp(name, "--batch-ms") == 0)
+        {
+            o.batchMs = std::max(1ul, strtoul(value, nullptr, 10));
+        }
+        else if (strcmp(name, "--filter") == 0)
+        {
+            o.filter = value;
+        }
+        else if (strcmp(name, "--out") == 0)
+        {
+            o.out = value;
+        }
+        else
+        {
+            usage(argv[0]);
+        }
+    }
+}
+
+// Logging goes to stderr so stdout stays valid JSON
+static void stderrSink(const char *text, size_t len)
+{
+    fwrite(text, 1, len, stderr);
+}
+
+// Bring up what the cases call into, and check the payloads parse to what
+// the display expects: a benchmark of a failing parse measures nothing
+static bool prepare()
+{
+    static char nvs[] = "/tmp/ft-bench-nvs-XXXXXX";
+    if (!mkdtemp(nvs))
+    {
+        fprintf(stderr, "bench: can't create an NVS directory\n");
+        return false;
+    }
+    Sim::options.nvsDir = nvs;
+    Sim::options.framesDir = nullptr;
+    // Device clock already set, at the default start time
+    Sim::boot(0, 0, false);
+    Log::begin(stderrSink);
+
+    FtWiFiManager::begin(true);
+    while (!FtWiFiManager::isConnected() && millis() < 30000)
+    {
+        FtWiFiManager::update();
+        delay(100);
+    }
+    DisplayManager::initDisplay();
+    TimeService::begin(LOCAL_TIMEZONE);
+    Log::flush();
+
+    JsonDocument weather;
+    if (parse(FLIGHT_JSON, flightDoc) || parse(WEATHER_JSON, weather))
+    {
+        fprintf(stderr, "bench: payload doesn't parse\n");
+        return false;
+    }
+    FlightRecord record;
+    FlightDataManager::parseRecord(flightDoc, record);
+    if (!record.available || strcmp(record.callsign, "IBB8121") != 0 || !weather["current"]["temperature_2m"].is<float>())
+    {
+        fprintf(stderr, "bench: payload parsed to unexpected values\n");
+        return false;
+    }
+    if (!FtWiFiManager::isConnected() || !TimeService::isSet())
+    {
+        fprintf(stderr, "bench: simulated WiFi or clock not up\n");
+        return false;
+    }
+    return true;
+}
+
+// Nothing here sleeps; esp_deep_sleep_start() still needs a definition
+void Sim::deepSleep()
+{
+    fprintf(stderr, "bench: deep sleep requested\n");
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    parseArgs(argc, argv, options);
+    if (options.list)
+    {
+        for (size_t i = 0; i < CASE_COUNT; i++)
+        {
+            printf("%s\n", CASES[i].name);
+        }
+        return 0;
+    }
+    if (!prepare())
+    {
+        return 1;
+    }
+
+    std::vector<Result> results;
+    fprintf(stderr, "%-34s %10s %10s %10s %10s\n", "case", "min ns", "median", "mean", "max");
+    for (size_t i = 0; i < CASE_COUNT; i++)
+    {
+        if (options.filter && !strstr(CASES[i].name, options.filter))
+        {
+            continue;
+        }
+        Result r = measure(CASES[i], options);
+        fprintf(stderr, "%-34s %10.1f %10.1f %10.1f %10.1f\n", r.name, r.minNs, r.medianNs, r.meanNs, r.maxNs);
+        results.push_back(r);
+    }
+    Log::flush();
+
+    FILE *file = options.out ? fopen(options.out, "w") : stdout;
+    if (!file)
+    {
+        fprintf(stderr, "bench: can't write %s\n", options.out);
+        return 1;
+    }
+    writeJson(file, results, options);
+    if (file != stdout)
+    {
+        fclose(file);
+    }
+    return 0;
+}
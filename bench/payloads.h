@@ -0,0 +1,27 @@
+#ifndef BENCH_PAYLOADS_H
+#define BENCH_PAYLOADS_H
+
+// Response bodies for the JSON cases, in the shape the two endpoints return
+// them. They carry the fields the filters drop as well, since skipping
+// those is part of the parse cost on the device.
+
+static const char FLIGHT_PAYLOAD[] =
+    "{\"flightDataAvailable\":true,\"callsign\":\"IBB8121\",\"flightNumber\":\"NT8121\","
+    "\"originAirportIata\":\"TFN\",\"originAirportIcao\":\"GCXO\","
+    "\"destinationAirportIata\":\"SPC\",\"destinationAirportIcao\":\"GCLA\","
+    "\"aircraftCode\":\"AT76\",\"registration\":\"EC-MJI\",\"latitude\":28.5412,\"longitude\":-17.6931,"
+    "\"altitude\":9500,\"groundSpeed\":245,\"track\":287,\"verticalSpeed\":-1408,\"squawk\":\"3041\","
+    "\"distanceKm\":12.4,\"updated\":\"2025-07-01T12:00:05Z\"}";
+
+static const char NO_FLIGHT_PAYLOAD[] = "{\"flightDataAvailable\":false}";
+
+// Open-Meteo, current=temperature_2m,relative_humidity_2m
+static const char WEATHER_PAYLOAD[] =
+    "{\"latitude\":28.625,\"longitude\":-17.75,\"generationtime_ms\":0.0209808349609375,"
+    "\"utc_offset_seconds\":0,\"timezone\":\"GMT\",\"timezone_abbreviation\":\"GMT\",\"elevation\":412.0,"
+    "\"current_units\":{\"time\":\"iso8601\",\"interval\":\"seconds\",\"temperature_2m\":\"\xC2\xB0" "C\","
+    "\"relative_humidity_2m\":\"%\"},"
+    "\"current\":{\"time\":\"2025-07-01T12:00\",\"interval\":900,\"temperature_2m\":23.4,"
+    "\"relative_humidity_2m\":61}}";
+
+#endif // BENCH_PAYLOADS_H
@@ -0,0 +1,7 @@
+#ifndef HOST_ADAFRUIT_I2CDEVICE_H
+#define HOST_ADAFRUIT_I2CDEVICE_H
+
+// Adafruit_GFX.h includes this Adafruit BusIO header; the simulator builds
+// without BusIO (lib_ignore in [env:native]) and nothing uses it
+
+#endif // HOST_ADAFRUIT_I2CDEVICE_H
@@ -0,0 +1,84 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// The part of the arduino-esp32 API the firmware uses outside its
+// `#ifdef ARDUINO` branches, implemented for the desktop simulator. Time is
+// virtual (see sim.h): it only moves while the firmware waits.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "IPAddress.h"
+
+using std::max;
+using std::min;
+
+#define PROGMEM
+#define DEC 10
+#define HEX 16
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void yield();
+
+// Console on stdout; input comes from --console lines (sim_main.cpp)
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void write(uint8_t c) override;
+    void write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush();
+};
+
+extern HardwareSerial Serial;
+
+// The host has no heap figures to give
+class EspClass
+{
+public:
+    uint32_t getFreeHeap() { return 0; }
+    uint32_t getMinFreeHeap() { return 0; }
+    uint32_t getMaxAllocHeap() { return 0; }
+};
+
+extern EspClass ESP;
+
+// FreeRTOS, as far as the loop task goes. loop() is the only task that
+// runs: xTaskCreate() accepts a task and never starts it.
+typedef void *TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stack, void *param, UBaseType_t priority,
+                       TaskHandle_t *handle);
+void xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+void vTaskDelay(TickType_t ticks);
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,36 @@
+#ifndef HOST_HTTPCLIENT_H
+#define HOST_HTTPCLIENT_H
+
+#include "WiFiClient.h"
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NO_HTTP_SERVER (-7)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+// GET over a client that HttpFetch has already connected. Sends an
+// HTTP/1.0 request, reads the status line and headers, and leaves the body
+// on the client for getStream().
+class HTTPClient
+{
+public:
+    HTTPClient() : client(nullptr), http10(false) {}
+
+    bool begin(WiFiClient &connected, const char *url);
+    void useHTTP10(bool enable) { http10 = enable; }
+    int GET();
+    WiFiClient &getStream() { return *client; }
+    void end() { client = nullptr; }
+
+    static String errorToString(int error);
+
+private:
+    WiFiClient *client;
+    bool http10;
+    char host[64];
+    const char *path;
+};
+
+#endif // HOST_HTTPCLIENT_H
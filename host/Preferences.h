@@ -0,0 +1,30 @@
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <stddef.h>
+#include <string>
+
+// NVS as one file per key under SimOptions::nvsDir, so it survives the
+// restart that emulates deep sleep, and across runs if the directory is
+// given on the command line
+class Preferences
+{
+public:
+    Preferences() : opened(false), readOnly(true) {}
+
+    bool begin(const char *name, bool readOnly = false);
+    void end() { opened = false; }
+
+    size_t getBytes(const char *key, void *buffer, size_t size);
+    size_t putBytes(const char *key, const void *value, size_t size);
+    bool remove(const char *key);
+
+private:
+    std::string path(const char *key) const;
+
+    bool opened;
+    bool readOnly;
+    std::string space;
+};
+
+#endif // HOST_PREFERENCES_H
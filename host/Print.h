@@ -0,0 +1,40 @@
+#ifndef HOST_PRINT_H
+#define HOST_PRINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "WString.h"
+
+// Adafruit GFX declares write(uint8_t) returning void when ARDUINO isn't
+// defined (the pre-1.0 Print), so this Print does the same and nothing
+// here reports a byte count.
+class Print
+{
+public:
+    virtual ~Print() {}
+
+    virtual void write(uint8_t c) = 0;
+    virtual void write(const uint8_t *buffer, size_t size);
+    void write(const char *text);
+
+    void print(const char *text) { write(text); }
+    void print(const String &text) { write(text.c_str()); }
+    void print(char c) { write((uint8_t)c); }
+    void print(long value, int base = 10);
+    void print(unsigned long value, int base = 10);
+    void print(int value, int base = 10) { print((long)value, base); }
+    void print(unsigned value, int base = 10) { print((unsigned long)value, base); }
+    void print(double value, int digits = 2);
+
+    void println() { write("\r\n"); }
+    template <typename T>
+    void println(const T &value)
+    {
+        print(value);
+        println();
+    }
+
+    void printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+#endif // HOST_PRINT_H
@@ -0,0 +1,22 @@
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <stdint.h>
+
+// The simulator's panel bus doesn't go through SPI (sim_panel.h); this only
+// takes the pin setup in DisplayManager::initDisplay()
+class SPIClass
+{
+public:
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1)
+    {
+        (void)sck;
+        (void)miso;
+        (void)mosi;
+        (void)ss;
+    }
+};
+
+extern SPIClass SPI;
+
+#endif // HOST_SPI_H
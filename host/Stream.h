@@ -0,0 +1,20 @@
+#ifndef HOST_STREAM_H
+#define HOST_STREAM_H
+
+#include "Print.h"
+
+// read() blocks until data arrives or the source is exhausted (-1), so
+// readBytes() needs no timeout: millis() doesn't move while code runs.
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    virtual size_t readBytes(char *buffer, size_t length);
+    size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+    void setTimeout(unsigned long ms) { (void)ms; }
+};
+
+#endif // HOST_STREAM_H
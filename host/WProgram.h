@@ -0,0 +1,7 @@
+#ifndef HOST_WPROGRAM_H
+#define HOST_WPROGRAM_H
+
+// Adafruit GFX includes this instead of Arduino.h when ARDUINO isn't defined
+#include "Arduino.h"
+
+#endif // HOST_WPROGRAM_H
@@ -0,0 +1,45 @@
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+#include <string>
+
+// Arduino String on std::string; only WiFiManager, IPAddress and the
+// setup screen use it
+class String
+{
+public:
+    String(const char *text = "") : text(text ? text : "") {}
+    String(const std::string &text) : text(text) {}
+    explicit String(int value) : text(std::to_string(value)) {}
+    explicit String(unsigned value) : text(std::to_string(value)) {}
+    explicit String(long value) : text(std::to_string(value)) {}
+    explicit String(unsigned long value) : text(std::to_string(value)) {}
+
+    const char *c_str() const { return text.c_str(); }
+    unsigned length() const { return (unsigned)text.size(); }
+    bool isEmpty() const { return text.empty(); }
+
+    bool concat(const char *more)
+    {
+        text += more ? more : "";
+        return true;
+    }
+    String &operator+=(const char *more)
+    {
+        concat(more);
+        return *this;
+    }
+    String &operator+=(const String &more) { return *this += more.c_str(); }
+    String operator+(const char *more) const { return String(text + (more ? more : "")); }
+    String operator+(const String &more) const { return String(text + more.text); }
+
+    bool operator==(const String &other) const { return text == other.text; }
+    bool operator!=(const String &other) const { return text != other.text; }
+    bool operator==(const char *other) const { return text == (other ? other : ""); }
+    bool operator!=(const char *other) const { return !(*this == other); }
+
+private:
+    std::string text;
+};
+
+#endif // HOST_WSTRING_H
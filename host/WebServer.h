@@ -0,0 +1,66 @@
+#ifndef HOST_WEBSERVER_H
+#define HOST_WEBSERVER_H
+
+#include <stddef.h>
+#include "Arduino.h"
+
+typedef enum
+{
+    HTTP_ANY,
+    HTTP_GET
+} HTTPMethod;
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+
+// The /diag routes, served without the diag task (it never runs here, see
+// xTaskCreate() in Arduino.h). Once begin() has run:
+//   - with SimOptions::httpPort set, GETs on 127.0.0.1:httpPort are answered
+//     whenever the firmware waits (one request per wait, HTTP/1.0);
+//   - get() runs a route in-process and hands back the page, for tests and
+//     the simulator's --get option.
+// Pages are built in a fixed buffer, so neither allocates.
+class WebServer
+{
+public:
+    typedef void (*Handler)();
+
+    static const uint8_t MAX_ROUTES = 4;
+    static const size_t PAGE_SIZE = 16384;
+
+    explicit WebServer(int port);
+
+    void on(const char *uri, HTTPMethod method, Handler handler);
+    void begin();
+    void handleClient();
+    void setContentLength(size_t length) { (void)length; }
+    void send(int code, const char *contentType, const char *content);
+    void sendContent(const char *content, size_t length);
+
+    // Runs the route for `uri` on the started server. Returns the status
+    // (404 for no route, 0 before begin()); the page stays valid until the
+    // next request.
+    static int get(const char *uri, const char **body, size_t *length);
+
+private:
+    struct Route
+    {
+        const char *uri;
+        Handler handler;
+    };
+
+    int run(const char *uri);
+    static void poll();
+
+    static WebServer *started;
+
+    Route routes[MAX_ROUTES];
+    uint8_t routeCount;
+    int listener;
+    int status;
+    const char *type;
+    char page[PAGE_SIZE];
+    size_t pageLen;
+    bool truncated;
+};
+
+#endif // HOST_WEBSERVER_H
@@ -0,0 +1,87 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <stdint.h>
+#include "Arduino.h"
+#include "WiFiClient.h"
+
+typedef enum
+{
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum
+{
+    WIFI_OFF,
+    WIFI_STA,
+    WIFI_AP,
+    WIFI_AP_STA
+} wifi_mode_t;
+
+typedef enum
+{
+    WIFI_PS_NONE,
+    WIFI_PS_MIN_MODEM,
+    WIFI_PS_MAX_MODEM
+} wifi_ps_type_t;
+
+typedef enum
+{
+    ARDUINO_EVENT_WIFI_STA_CONNECTED = 4,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED = 5,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP = 7,
+    ARDUINO_EVENT_MAX = 40
+} arduino_event_id_t;
+
+typedef void (*WiFiEventCb)(arduino_event_id_t event);
+
+// Fake station driven by SimOptions (sim.h): an attempt succeeds after the
+// configured connect time (shorter on the fast path, with channel and
+// BSSID given), RSSI is fixed, and the link drops at the configured times.
+// Names resolve to made-up addresses; traffic goes to the stand-in server
+// (WiFiClient) or the built-in NTP responder (WiFiUDP).
+class WiFiClass
+{
+public:
+    wifi_mode_t getMode() const { return currentMode; }
+    bool mode(wifi_mode_t mode);
+    bool persistent(bool enable)
+    {
+        (void)enable;
+        return true;
+    }
+    bool config(IPAddress localIP, IPAddress gateway, IPAddress subnet, IPAddress dns1 = (uint32_t)0,
+                IPAddress dns2 = (uint32_t)0);
+    wl_status_t begin(const char *ssid = nullptr, const char *passphrase = nullptr, int32_t channel = 0,
+                      const uint8_t *bssid = nullptr, bool connect = true);
+    bool disconnect(bool wifiOff = false, bool eraseAp = false);
+    bool setSleep(wifi_ps_type_t type)
+    {
+        (void)type;
+        return true;
+    }
+    void onEvent(WiFiEventCb callback, arduino_event_id_t event = ARDUINO_EVENT_MAX);
+
+    wl_status_t status();
+    int8_t RSSI();
+    uint8_t *BSSID();
+    int32_t channel();
+    IPAddress localIP();
+    IPAddress gatewayIP();
+    IPAddress subnetMask();
+    IPAddress dnsIP(uint8_t index = 0);
+    IPAddress softAPIP();
+
+    int hostByName(const char *host, IPAddress &result);
+
+private:
+    wifi_mode_t currentMode = WIFI_OFF;
+};
+
+extern WiFiClass WiFi;
+
+#endif // HOST_WIFI_H
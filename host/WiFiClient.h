@@ -0,0 +1,49 @@
+#ifndef HOST_WIFICLIENT_H
+#define HOST_WIFICLIENT_H
+
+#include <stdint.h>
+#include "Arduino.h"
+
+// TCP client on a real socket. Whatever host it is asked for, it connects
+// to the stand-in server (SimOptions::serverHost/serverPort), so fetches go
+// through the network stack, HTTP parsing and JSON streaming for real.
+// With SimOptions::respond set (tests) there is no socket: the request is
+// answered in-process and read back through the same buffer.
+class WiFiClient : public Stream
+{
+public:
+    WiFiClient() : fd(-1), used(0), pos(0), local(false), body(nullptr), bodyLen(0), bodyPos(0) {}
+    virtual ~WiFiClient() { stop(); }
+
+    virtual int connect(const char *host, uint16_t port);
+    uint8_t connected();
+    void stop();
+
+    void write(uint8_t c) override { write(&c, 1); }
+    void write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t readBytes(char *buffer, size_t length) override;
+
+private:
+    WiFiClient(const WiFiClient &) = delete;
+    WiFiClient &operator=(const WiFiClient &) = delete;
+
+    bool fill();
+    void respondLocally(const uint8_t *request, size_t size);
+
+    int fd;
+    // Receive buffer: ArduinoJson reads a byte at a time
+    uint8_t buffer[1460];
+    size_t used;
+    size_t pos;
+    // In-process reply: headers in `buffer`, then the responder's body
+    bool local;
+    const char *body;
+    size_t bodyLen;
+    size_t bodyPos;
+};
+
+#endif // HOST_WIFICLIENT_H
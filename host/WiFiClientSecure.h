@@ -0,0 +1,14 @@
+#ifndef HOST_WIFICLIENTSECURE_H
+#define HOST_WIFICLIENTSECURE_H
+
+#include "WiFiClient.h"
+
+// No TLS in the simulator: the stand-in server speaks plain HTTP on every
+// port, so https:// URLs take the same path without a handshake
+class WiFiClientSecure : public WiFiClient
+{
+public:
+    void setInsecure() {}
+};
+
+#endif // HOST_WIFICLIENTSECURE_H
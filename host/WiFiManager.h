@@ -0,0 +1,37 @@
+#ifndef HOST_WIFIMANAGER_H
+#define HOST_WIFIMANAGER_H
+
+#include <functional>
+#include "Arduino.h"
+
+// Saved credentials and the config portal. Credentials are "saved" unless
+// the simulator runs with --no-credentials; the portal shows its screen
+// and closes at its timeout, as when nobody connects to it.
+class WiFiManager
+{
+public:
+    WiFiManager() : blocking(true), timeoutS(0), active(false), openedMs(0) {}
+
+    void setConfigPortalBlocking(bool enable) { blocking = enable; }
+    void setConfigPortalTimeout(unsigned long seconds) { timeoutS = seconds; }
+    void setAPCallback(std::function<void(WiFiManager *)> callback) { apCallback = callback; }
+    bool startConfigPortal(const char *apName, const char *apPassword = nullptr);
+    bool process();
+    bool getConfigPortalActive() const { return active; }
+    String getConfigPortalSSID() const { return portalName; }
+
+    bool getWiFiIsSaved();
+    String getWiFiSSID() { return "sim"; }
+    String getWiFiPass() { return "password"; }
+    void resetSettings();
+
+private:
+    bool blocking;
+    unsigned long timeoutS;
+    bool active;
+    unsigned long openedMs;
+    String portalName;
+    std::function<void(WiFiManager *)> apCallback;
+};
+
+#endif // HOST_WIFIMANAGER_H
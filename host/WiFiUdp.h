@@ -0,0 +1,53 @@
+#ifndef HOST_WIFIUDP_H
+#define HOST_WIFIUDP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "IPAddress.h"
+
+// Datagrams never leave the process: a request to port 123 is answered by
+// a built-in NTP server on the simulator's true clock, one round trip
+// (SimOptions::ntpRttMs) later in virtual time. Anything else is dropped.
+class WiFiUDP
+{
+public:
+    WiFiUDP() : open(false), toPort(0), outLen(0), queued(0), current(-1), readPos(0) {}
+
+    uint8_t begin(uint16_t port);
+    void stop();
+
+    int beginPacket(IPAddress ip, uint16_t port);
+    size_t write(const uint8_t *buffer, size_t size);
+    int endPacket();
+
+    // Size of the next datagram that has arrived, 0 if none
+    int parsePacket();
+    int read(uint8_t *buffer, size_t size);
+    IPAddress remoteIP() const;
+
+private:
+    static constexpr size_t PACKET_MAX = 48;
+    // One reply per SNTP server in flight
+    static constexpr uint8_t QUEUE = 4;
+
+    struct Datagram
+    {
+        IPAddress from;
+        uint64_t arrivesUs; // boot-relative
+        uint8_t data[PACKET_MAX];
+        size_t len;
+    };
+
+    bool open;
+    IPAddress to;
+    uint16_t toPort;
+    uint8_t out[PACKET_MAX];
+    size_t outLen;
+
+    Datagram inbox[QUEUE];
+    uint8_t queued;
+    int current; // inbox index being read, -1 for none
+    size_t readPos;
+};
+
+#endif // HOST_WIFIUDP_H
@@ -0,0 +1,72 @@
+#include <stdarg.h>
+#include "Arduino.h"
+
+void Print::write(const uint8_t *buffer, size_t size)
+{
+    while (size--)
+    {
+        write(*buffer++);
+    }
+}
+
+void Print::write(const char *text)
+{
+    write((const uint8_t *)text, strlen(text));
+}
+
+void Print::print(long value, int base)
+{
+    if (base == 10)
+    {
+        printf("%ld", value);
+    }
+    else
+    {
+        print((unsigned long)value, base);
+    }
+}
+
+void Print::print(unsigned long value, int base)
+{
+    printf(base == 16 ? "%lx" : base == 8 ? "%lo" : "%lu", value);
+}
+
+void Print::print(double value, int digits)
+{
+    printf("%.*f", digits, value);
+}
+
+void Print::printf(const char *format, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (n > 0)
+    {
+        write((const uint8_t *)line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+    }
+}
+
+size_t Stream::readBytes(char *buffer, size_t length)
+{
+    size_t count = 0;
+    while (count < length)
+    {
+        int c = read();
+        if (c < 0)
+        {
+            break;
+        }
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
+
+String IPAddress::toString() const
+{
+    char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(text);
+}
@@ -0,0 +1,9 @@
+#ifndef HOST_ESP_ATTR_H
+#define HOST_ESP_ATTR_H
+
+// RTC memory is a section of its own, which the simulator carries through
+// an emulated deep sleep (sim.cpp) while everything else starts over
+#define RTC_DATA_ATTR __attribute__((section("ft_rtc_data")))
+#define IRAM_ATTR
+
+#endif // HOST_ESP_ATTR_H
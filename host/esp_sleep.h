@@ -0,0 +1,20 @@
+#ifndef HOST_ESP_SLEEP_H
+#define HOST_ESP_SLEEP_H
+
+#include <stdint.h>
+
+typedef enum
+{
+    ESP_SLEEP_WAKEUP_UNDEFINED,
+    ESP_SLEEP_WAKEUP_TIMER = 4
+} esp_sleep_wakeup_cause_t;
+
+// TIMER after an emulated deep sleep, UNDEFINED on a fresh start
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause();
+void esp_sleep_enable_timer_wakeup(uint64_t us);
+// Restarts the simulator with RTC memory, the panel and the clocks kept
+[[noreturn]] void esp_deep_sleep_start();
+// Lets the timer's time pass; nothing but the timer wakes it
+int esp_light_sleep_start();
+
+#endif // HOST_ESP_SLEEP_H
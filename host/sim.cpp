@@ -0,0 +1,288 @@
+#include <sys/time.h>
+#include <time.h>
+#include <string>
+#include "Arduino.h"
+#include "SPI.h"
+#include "esp_sleep.h"
+#include "sim.h"
+
+SimOptions Sim::options;
+uint64_t Sim::bootUs = 0;
+uint64_t Sim::runStartUs = 0;
+int64_t Sim::deviceOffsetUs = 0;
+bool Sim::notified = false;
+bool Sim::resumed = false;
+uint64_t Sim::sleepUs = 0;
+Sim::Event Sim::events[Sim::MAX_EVENTS];
+uint8_t Sim::eventCount = 0;
+Sim::Callback Sim::idle[Sim::MAX_IDLE];
+uint8_t Sim::idleCount = 0;
+
+void Sim::boot(uint64_t runStart, int64_t deviceOffset, bool fromDeepSleep)
+{
+    bootUs = 0;
+    runStartUs = runStart;
+    deviceOffsetUs = deviceOffset;
+    resumed = fromDeepSleep;
+}
+
+bool Sim::wait(uint32_t ms, bool wakeOnNotify)
+{
+    runIdle();
+    uint64_t deadline = bootUs + (uint64_t)ms * 1000;
+    while (!(wakeOnNotify && notified))
+    {
+        // Earliest event due by the deadline; ties go in scheduling order
+        int8_t next = -1;
+        for (uint8_t i = 0; i < eventCount; i++)
+        {
+            if (events[i].atUs <= deadline && (next < 0 || events[i].atUs < events[next].atUs))
+            {
+                next = (int8_t)i;
+            }
+        }
+        if (next < 0)
+        {
+            bootUs = deadline;
+            break;
+        }
+        Event due = events[next];
+        memmove(&events[next], &events[next + 1], (eventCount - next - 1) * sizeof(Event));
+        eventCount--;
+        if (due.atUs > bootUs)
+        {
+            bootUs = due.atUs;
+        }
+        due.fn();
+    }
+    return wakeOnNotify && notified;
+}
+
+bool Sim::takeNotification()
+{
+    bool was = notified;
+    notified = false;
+    return was;
+}
+
+void Sim::after(uint32_t delayMs, Callback fn)
+{
+    if (eventCount == MAX_EVENTS)
+    {
+        fprintf(stderr, "sim: event table full, raise Sim::MAX_EVENTS\n");
+        return;
+    }
+    events[eventCount++] = {bootUs + (uint64_t)delayMs * 1000, fn};
+}
+
+void Sim::onIdle(Callback fn)
+{
+    if (idleCount < MAX_IDLE)
+    {
+        idle[idleCount++] = fn;
+    }
+}
+
+void Sim::runIdle()
+{
+    for (uint8_t i = 0; i < idleCount; i++)
+    {
+        idle[i]();
+    }
+}
+
+// Arduino time and the loop task
+
+unsigned long millis()
+{
+    return (unsigned long)(Sim::nowUs() / 1000);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)Sim::nowUs();
+}
+
+void delay(uint32_t ms)
+{
+    Sim::wait(ms, false);
+}
+
+void yield()
+{
+}
+
+static int loopTask;
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return &loopTask;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stack, void *param, UBaseType_t priority,
+                       TaskHandle_t *handle)
+{
+    (void)task;
+    (void)stack;
+    (void)param;
+    (void)priority;
+    fprintf(stderr, "sim: task \"%s\" not started (only loop() runs here)\n", name);
+    if (handle)
+    {
+        *handle = nullptr;
+    }
+    return pdPASS;
+}
+
+void xTaskNotifyGive(TaskHandle_t task)
+{
+    if (task == &loopTask)
+    {
+        Sim::notify();
+    }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    (void)clear;
+    if (!Sim::takeNotification())
+    {
+        Sim::wait(ticks, true);
+        if (!Sim::takeNotification())
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    Sim::wait(ticks, false);
+}
+
+// Console: stdout, and input typed at the --console times
+
+HardwareSerial Serial;
+EspClass ESP;
+SPIClass SPI;
+
+static std::string consoleInput;
+static uint8_t consoleNext = 0;
+
+static void takeConsoleLines()
+{
+    const SimOptions &o = Sim::options;
+    while (consoleNext < o.consoleLines && (uint64_t)o.consoleAtS[consoleNext] * 1000000 <= Sim::runUs())
+    {
+        // Typed while the chip was in deep sleep: lost, as on the device
+        if ((uint64_t)o.consoleAtS[consoleNext] * 1000000 >= Sim::runUs() - Sim::nowUs())
+        {
+            consoleInput += o.console[consoleNext];
+            consoleInput += '\n';
+        }
+        consoleNext++;
+    }
+}
+
+void HardwareSerial::write(uint8_t c)
+{
+    fputc(c, stdout);
+}
+
+void HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    fwrite(buffer, 1, size, stdout);
+}
+
+int HardwareSerial::available()
+{
+    takeConsoleLines();
+    return (int)consoleInput.size();
+}
+
+int HardwareSerial::read()
+{
+    takeConsoleLines();
+    if (consoleInput.empty())
+    {
+        return -1;
+    }
+    int c = (uint8_t)consoleInput[0];
+    consoleInput.erase(0, 1);
+    return c;
+}
+
+int HardwareSerial::peek()
+{
+    takeConsoleLines();
+    return consoleInput.empty() ? -1 : (uint8_t)consoleInput[0];
+}
+
+void HardwareSerial::flush()
+{
+    fflush(stdout);
+}
+
+// Deep and light sleep (the restart itself is in sim_main.cpp)
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause()
+{
+    return Sim::wokeFromDeepSleep() ? ESP_SLEEP_WAKEUP_TIMER : ESP_SLEEP_WAKEUP_UNDEFINED;
+}
+
+void esp_sleep_enable_timer_wakeup(uint64_t us)
+{
+    Sim::setSleepTimer(us);
+}
+
+void esp_deep_sleep_start()
+{
+    Sim::deepSleep();
+}
+
+int esp_light_sleep_start()
+{
+    Sim::lightSleep();
+    return 0;
+}
+
+// The device's wall clock, for firmware code only (-Wl,--wrap=...)
+
+extern "C" time_t __wrap_time(time_t *out)
+{
+    time_t now = (time_t)(Sim::deviceUs() / 1000000);
+    if (out)
+    {
+        *out = now;
+    }
+    return now;
+}
+
+extern "C" int __wrap_gettimeofday(struct timeval *tv, void *tz)
+{
+    (void)tz;
+    int64_t us = Sim::deviceUs();
+    tv->tv_sec = (time_t)(us / 1000000);
+    tv->tv_usec = (suseconds_t)(us % 1000000);
+    return 0;
+}
+
+extern "C" int __wrap_settimeofday(const struct timeval *tv, const void *tz)
+{
+    (void)tz;
+    Sim::setDeviceUs((int64_t)tv->tv_sec * 1000000 + tv->tv_usec);
+    return 0;
+}
+
+// Applied at once rather than slewed
+extern "C" int __wrap_adjtime(const struct timeval *delta, struct timeval *olddelta)
+{
+    Sim::adjustDevice((int64_t)delta->tv_sec * 1000000 + delta->tv_usec);
+    if (olddelta)
+    {
+        olddelta->tv_sec = 0;
+        olddelta->tv_usec = 0;
+    }
+    return 0;
+}
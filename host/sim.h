@@ -0,0 +1,126 @@
+#ifndef HOST_SIM_H
+#define HOST_SIM_H
+
+#include <stdint.h>
+
+// Desktop simulator: the firmware's setup() and loop() run on the host
+// against the Arduino API in this directory ([env:native] in
+// platformio.ini, usage in sim_main.cpp).
+//
+// Time is virtual. millis() and micros() only move when the firmware waits
+// (delay(), vTaskDelay(), ulTaskNotifyTake()), and a wait jumps straight to
+// its deadline or to the next scheduled event (a WiFi connect, say),
+// whichever is first. Runs are deterministic, a day of firmware time takes
+// as long as the code takes to execute, and micros() differences measure
+// waits, not work: time real work with perf, valgrind or the profile
+// build's zones.
+//
+// There are two wall clocks. The true one starts at SimOptions::startUtc;
+// the device's reads 1970 at power-on until SNTP sets it from the built-in
+// NTP server, which answers on the true one. time(), gettimeofday(),
+// settimeofday() and adjtime() are wrapped (-Wl,--wrap) onto the device's.
+
+struct SimOptions
+{
+    uint32_t durationS = 3600;     // virtual run time, deep sleeps included
+    int64_t startUtc = 1751371200; // 2025-07-01 12:00 UTC
+    const char *framesDir = "sim-frames";
+    const char *nvsDir = nullptr;  // temporary when not given
+    // Stand-in HTTP server (tools/sim_server.py) for every fetch
+    const char *serverHost = "127.0.0.1";
+    uint16_t serverPort = 8080;
+    // Local port for the diag server's /diag and /metrics (0: not served)
+    uint16_t httpPort = 0;
+    // Fake radio
+    bool credentials = true;
+    uint32_t connectMs = 2500;
+    uint32_t fastConnectMs = 400;
+    int8_t rssi = -62;
+    int32_t apChannel = 6;         // move it mid-run to make cached joins miss
+    uint32_t dropAtS[4] = {};      // link drops, seconds after power-on
+    uint8_t drops = 0;
+    uint32_t ntpRttMs = 30;
+    // Console lines typed at these times (seconds after power-on)
+    const char *console[8] = {};
+    uint32_t consoleAtS[8] = {};
+    uint8_t consoleLines = 0;
+    // Tests (test/, pio test -e native). respond answers fetches in-process
+    // instead of the stand-in server: the body for host and path, or nullptr
+    // for a 404. onDeepSleep replaces the restart and must not return.
+    const char *(*respond)(const char *host, const char *path) = nullptr;
+    void (*onDeepSleep)() = nullptr;
+};
+
+// What the fake radio was asked to do, for tests
+struct SimRadio
+{
+    uint32_t scans;       // begin() without a BSSID: full scan
+    uint32_t directJoins; // begin() with the AP's channel and BSSID
+    uint32_t missedJoins; // begin() with a channel or BSSID the AP isn't on
+    uint32_t dhcpLeases;  // joins that asked DHCP for an address
+};
+
+class Sim
+{
+public:
+    typedef void (*Callback)();
+
+    static SimOptions options;
+    static SimRadio radio;
+
+    // Microseconds since this boot
+    static uint64_t nowUs() { return bootUs; }
+    // Since the first power-on: boots plus deep sleeps
+    static uint64_t runUs() { return runStartUs + bootUs; }
+
+    // Let `ms` pass, running due events; with wakeOnNotify the wait ends
+    // at a task notification. Returns true if it was notified.
+    static bool wait(uint32_t ms, bool wakeOnNotify);
+    static void notify() { notified = true; }
+    static bool takeNotification();
+
+    // Run `fn` once `delayMs` from now (fixed table, see MAX_EVENTS)
+    static void after(uint32_t delayMs, Callback fn);
+    // Called whenever the firmware is about to wait: the moment the log
+    // task and the panel would catch up on a real device
+    static void onIdle(Callback fn);
+    static void runIdle();
+
+    // Wall clocks, microseconds since 1970
+    static int64_t trueUs() { return options.startUtc * 1000000 + (int64_t)runUs(); }
+    static int64_t deviceUs() { return trueUs() + deviceOffsetUs; }
+    static void setDeviceUs(int64_t us) { deviceOffsetUs = us - trueUs(); }
+    static void adjustDevice(int64_t deltaUs) { deviceOffsetUs += deltaUs; }
+
+    // Boot state, set by sim_main.cpp before setup()
+    static void boot(uint64_t runStart, int64_t deviceOffset, bool fromDeepSleep);
+    static bool wokeFromDeepSleep() { return resumed; }
+    static void setSleepTimer(uint64_t us) { sleepUs = us; }
+    // Emulated deep sleep: save RTC memory and the panel, restart
+    [[noreturn]] static void deepSleep();
+    // Emulated light sleep: the sleep timer's time passes, events included
+    static void lightSleep() { wait((uint32_t)(sleepUs / 1000), false); }
+
+private:
+    static const uint8_t MAX_EVENTS = 8;
+    static const uint8_t MAX_IDLE = 4;
+
+    struct Event
+    {
+        uint64_t atUs;
+        Callback fn;
+    };
+
+    static uint64_t bootUs;
+    static uint64_t runStartUs;
+    static int64_t deviceOffsetUs;
+    static bool notified;
+    static bool resumed;
+    static uint64_t sleepUs;
+    static Event events[MAX_EVENTS];
+    static uint8_t eventCount;
+    static Callback idle[MAX_IDLE];
+    static uint8_t idleCount;
+};
+
+#endif // HOST_SIM_H
@@ -0,0 +1,342 @@
+// Desktop simulator entry point: runs the firmware's setup() and loop() in
+// virtual time (sim.h). With the stand-in server running
+// (python tools/sim_server.py):
+//
+//   pio run -e native
+//   .pio/build/native/program --duration 7200 --frames frames
+//
+// Frames land in frames/frame-NNNNN.ppm, the firmware's log and console on
+// stdout, the simulator's own notes on stderr. Options:
+//
+//   --duration S        virtual seconds to run, deep sleeps included (3600)
+//   --start UTC         true time at power-on, Unix seconds (1751371200)
+//   --frames DIR        snapshot directory ("" for none; sim-frames)
+//   --server HOST:PORT  stand-in HTTP server (127.0.0.1:8080)
+//   --nvs DIR           NVS contents (default: a new temporary directory)
+//   --no-credentials    nothing saved, so the config portal opens
+//   --connect-ms MS     full connect time (2500)
+//   --fast-connect-ms MS  connect time with the cached channel/BSSID (400)
+//   --rssi DBM          signal strength (-62)
+//   --drop S            drop the link S seconds after power-on (up to 4)
+//   --ntp-rtt MS        round trip to the NTP server (30)
+//   --console S:LINE    type LINE on the console at S seconds (up to 8)
+//   --http-port PORT    serve /diag and /metrics on 127.0.0.1:PORT while running
+//   --get URI           print that diag page (/diag, /metrics) at the end (up to 4)
+//
+// Deep sleep restarts the process (execv) with RTC memory, the panel and
+// the clocks carried in a resume file, so every other static starts over
+// as it would on the chip.
+//
+// Unit tests (pio test -e native) link the same host/ code with their own
+// main(): test/sim_test.h boots the simulator and runs loop() in-process.
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "Arduino.h"
+#include "WebServer.h"
+#include "ft_log.h"
+#include "sim.h"
+#include "sim_panel.h"
+
+void setup();
+void loop();
+
+// RTC_DATA_ATTR variables (esp_attr.h); the linker provides the bounds
+extern "C" char __start_ft_rtc_data[] __attribute__((weak));
+extern "C" char __stop_ft_rtc_data[] __attribute__((weak));
+
+static const uint32_t RESUME_MAGIC = 0x46545253; // "FTRS"
+
+static int argCount;
+static char **args;
+static const char *pages[4];
+static uint8_t pageCount = 0;
+
+static size_t rtcSize()
+{
+    return __start_ft_rtc_data ? (size_t)(__stop_ft_rtc_data - __start_ft_rtc_data) : 0;
+}
+
+// The --get pages, as the diag server would serve them now
+static void printPages()
+{
+    for (uint8_t i = 0; i < pageCount; i++)
+    {
+        const char *body;
+        size_t length;
+        int status = WebServer::get(pages[i], &body, &length);
+        if (status == 0)
+        {
+            fprintf(stderr, "sim: no %s, the diag server hadn't started\n", pages[i]);
+            continue;
+        }
+        fprintf(stderr, "sim: GET %s -> %d, %u bytes\n", pages[i], status, (unsigned)length);
+        fwrite(body, 1, length, stdout);
+    }
+    fflush(stdout);
+}
+
+void Sim::deepSleep()
+{
+    runIdle();
+    if (options.onDeepSleep)
+    {
+        options.onDeepSleep();
+    }
+    uint64_t wakeAt = runUs() + sleepUs;
+    if (wakeAt >= (uint64_t)options.durationS * 1000000)
+    {
+        fprintf(stderr, "sim: run ends in deep sleep\n");
+        printPages();
+        exit(0);
+    }
+
+    static char path[64];
+    snprintf(path, sizeof(path), "/tmp/ft-sim-%d.resume", (int)getpid());
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "sim: can't write %s\n", path);
+        exit(1);
+    }
+    // The device clock keeps running through the sleep; so does the true one
+    uint64_t size = rtcSize();
+    fwrite(&RESUME_MAGIC, sizeof(RESUME_MAGIC), 1, file);
+    fwrite(&wakeAt, sizeof(wakeAt), 1, file);
+    fwrite(&deviceOffsetUs, sizeof(deviceOffsetUs), 1, file);
+    fwrite(&size, sizeof(size), 1, file);
+    fwrite(__start_ft_rtc_data, 1, size, file);
+    if (SimPanelBus::instance())
+    {
+        SimPanelBus::instance()->saveState(file);
+    }
+    fclose(file);
+
+    // Same arguments, minus an old --resume and --nvs, plus where to resume
+    // from and the NVS directory in case it was a temporary one
+    static char *next[256];
+    int n = 0;
+    for (int i = 0; i < argCount && n < 250; i++)
+    {
+        if ((strcmp(args[i], "--resume") == 0 || strcmp(args[i], "--nvs") == 0) && i + 1 < argCount)
+        {
+            i++;
+            continue;
+        }
+        next[n++] = args[i];
+    }
+    next[n++] = (char *)"--nvs";
+    next[n++] = (char *)options.nvsDir;
+    next[n++] = (char *)"--resume";
+    next[n++] = path;
+    next[n] = nullptr;
+    fflush(stdout);
+    fflush(stderr);
+    execv("/proc/self/exe", next);
+    fprintf(stderr, "sim: restart failed\n");
+    exit(1);
+}
+
+#ifndef PIO_UNIT_TESTING
+
+static const char *resumePath = nullptr;
+static struct timespec realStart;
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [--duration S] [--start UTC] [--frames DIR] [--server HOST:PORT] [--nvs DIR]\n"
+            "          [--no-credentials] [--connect-ms MS] [--fast-connect-ms MS] [--rssi DBM]\n"
+            "          [--drop S]... [--ntp-rtt MS] [--console S:LINE]... [--http-port PORT] [--get URI]...\n",
+            program);
+    exit(2);
+}
+
+static void parseArgs(int argc, char **argv)
+{
+    SimOptions &o = Sim::options;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *name = argv[i];
+        if (strcmp(name, "--no-credentials") == 0)
+        {
+            o.credentials = false;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+        }
+        const char *value = argv[++i];
+        if (strcmp(name, "--duration") == 0)
+        {
+            o.durationS = (uint32_t)strtoul(value, nullptr, 10);
+        }
+        else if (strcmp(name, "--start") == 0)
+        {
+            o.startUtc = strtoll(value, nullptr, 10);
+        }
+        else if (strcmp(name, "--frames") == 0)
+        {
+            o.framesDir = *value ? value : nullptr;
+        }
+        else if (strcmp(name, "--server") == 0)
+        {
+            // argv outlives the run, so the host can stay in place
+            char *colon = strrchr(argv[i], ':');
+            if (!colon)
+            {
+                usage(argv[0]);
+            }
+            *colon = '\0';
+            o.serverHost = value;
+            o.serverPort = (uint16_t)strtoul(colon + 1, nullptr, 10);
+        }
+        else if (strcmp(name, "--nvs") == 0)
+        {
+            o.nvsDir = value;
+        }
+        else if (strcmp(name, "--connect-ms") == 0)
+        {
+            o.connectMs = (uint32_t)strtoul(value, nullptr, 10);
+        }
+        else if (strcmp(name, "--fast-connect-ms") == 0)
+        {
+            o.fastConnectMs = (uint32_t)strtoul(value, nullptr, 10);
+        }
+        else if (strcmp(name, "--rssi") == 0)
+        {
+            o.rssi = (int8_t)strtol(value, nullptr, 10);
+        }
+        else if (strcmp(name, "--drop") == 0 && o.drops < 4)
+        {
+            o.dropAtS[o.drops++] = (uint32_t)strtoul(value, nullptr, 10);
+        }
+        else if (strcmp(name, "--ntp-rtt") == 0)
+        {
+            o.ntpRttMs = (uint32_t)strtoul(value, nullptr, 10);
+        }
+        else if (strcmp(name, "--console") == 0 && o.consoleLines < 8)
+        {
+            char *end;
+            uint32_t at = (uint32_t)strtoul(value, &end, 10);
+            if (*end != ':')
+            {
+                usage(argv[0]);
+            }
+            o.consoleAtS[o.consoleLines] = at;
+            o.console[o.consoleLines++] = end + 1;
+        }
+        else if (strcmp(name, "--http-port") == 0)
+        {
+            o.httpPort = (uint16_t)strtoul(value, nullptr, 10);
+        }
+        else if (strcmp(name, "--get") == 0 && pageCount < 4)
+        {
+            pages[pageCount++] = value;
+        }
+        else if (strcmp(name, "--resume") == 0)
+        {
+            resumePath = value;
+        }
+        else
+        {
+            usage(argv[0]);
+        }
+    }
+    // Lines are taken in order
+    for (uint8_t i = 1; i < o.consoleLines; i++)
+    {
+        for (uint8_t j = i; j > 0 && o.consoleAtS[j - 1] > o.consoleAtS[j]; j--)
+        {
+            std::swap(o.consoleAtS[j - 1], o.consoleAtS[j]);
+            std::swap(o.console[j - 1], o.console[j]);
+        }
+    }
+}
+
+// Pick up where the last boot went into deep sleep
+static bool resume(uint64_t &runStart, int64_t &deviceOffset)
+{
+    FILE *file = fopen(resumePath, "rb");
+    if (!file)
+    {
+        return false;
+    }
+    uint32_t magic = 0;
+    uint64_t size = 0;
+    bool ok = fread(&magic, sizeof(magic), 1, file) == 1 && magic == RESUME_MAGIC &&
+              fread(&runStart, sizeof(runStart), 1, file) == 1 &&
+              fread(&deviceOffset, sizeof(deviceOffset), 1, file) == 1 && fread(&size, sizeof(size), 1, file) == 1 &&
+              size == rtcSize() && fread(__start_ft_rtc_data, 1, size, file) == size &&
+              SimPanelBus::instance() && SimPanelBus::instance()->loadState(file);
+    fclose(file);
+    unlink(resumePath);
+    return ok;
+}
+
+static void drainLog()
+{
+    Log::drain();
+}
+
+int main(int argc, char **argv)
+{
+    argCount = argc;
+    args = argv;
+    parseArgs(argc, argv);
+    clock_gettime(CLOCK_MONOTONIC, &realStart);
+
+    if (!Sim::options.nvsDir)
+    {
+        static char dir[] = "/tmp/ft-sim-nvs-XXXXXX";
+        if (!mkdtemp(dir))
+        {
+            fprintf(stderr, "sim: can't create an NVS directory\n");
+            return 1;
+        }
+        Sim::options.nvsDir = dir;
+    }
+    mkdir(Sim::options.nvsDir, 0755);
+
+    uint64_t runStart = 0;
+    // Power-on: the device clock reads 1970
+    int64_t deviceOffset = -Sim::options.startUtc * 1000000;
+    bool resumed = resumePath && resume(runStart, deviceOffset);
+    if (resumePath && !resumed)
+    {
+        fprintf(stderr, "sim: couldn't resume from %s, starting cold\n", resumePath);
+        memset(__start_ft_rtc_data, 0, rtcSize());
+        runStart = 0;
+        deviceOffset = -Sim::options.startUtc * 1000000;
+    }
+    Sim::boot(runStart, deviceOffset, resumed);
+    // The log task runs whenever the loop waits
+    Sim::onIdle(drainLog);
+    if (resumed)
+    {
+        fprintf(stderr, "sim: woke from deep sleep at %.3f s\n", Sim::runUs() / 1e6);
+    }
+
+    uint64_t end = (uint64_t)Sim::options.durationS * 1000000;
+    setup();
+    while (Sim::runUs() < end)
+    {
+        loop();
+    }
+    Sim::runIdle();
+    Log::flush();
+    printPages();
+
+    struct timespec realEnd;
+    clock_gettime(CLOCK_MONOTONIC, &realEnd);
+    double realS = (realEnd.tv_sec - realStart.tv_sec) + (realEnd.tv_nsec - realStart.tv_nsec) / 1e9;
+    fprintf(stderr, "sim: %.0f s simulated, this boot took %.3f s, %u frames saved\n", Sim::runUs() / 1e6, realS,
+            SimPanelBus::instance() ? (unsigned)SimPanelBus::instance()->framesSaved() : 0u);
+    return 0;
+}
+
+#endif // PIO_UNIT_TESTING
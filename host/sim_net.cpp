@@ -0,0 +1,912 @@
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "Arduino.h"
+#include "HTTPClient.h"
+#include "Preferences.h"
+#include "WiFi.h"
+#include "WiFiManager.h"
+#include "WebServer.h"
+#include "WiFiUdp.h"
+#include "sim.h"
+
+// Station
+
+WiFiClass WiFi;
+SimRadio Sim::radio;
+
+static const uint8_t FAKE_BSSID[6] = {0x02, 0x51, 0x4D, 0x00, 0x00, 0x01};
+
+static bool connected = false;
+// Station config from the last begin() with credentials; begin() without
+// them reuses it, BSSID and channel included, as the driver does
+static int32_t configChannel = 0;
+static uint8_t configBssid[6];
+static bool configBssidSet = false;
+static bool connecting = false;
+static uint64_t connectDueUs = 0;
+static IPAddress staticIP;
+static IPAddress staticGateway;
+static IPAddress staticSubnet;
+static IPAddress staticDns;
+
+struct EventHandler
+{
+    WiFiEventCb callback;
+    arduino_event_id_t event;
+};
+static EventHandler handlers[8];
+static uint8_t handlerCount = 0;
+
+static void raise(arduino_event_id_t event)
+{
+    for (uint8_t i = 0; i < handlerCount; i++)
+    {
+        if (handlers[i].event == event || handlers[i].event == ARDUINO_EVENT_MAX)
+        {
+            handlers[i].callback(event);
+        }
+    }
+}
+
+static void connectDone()
+{
+    // Superseded by a disconnect or a later begin()
+    if (!connecting || Sim::nowUs() < connectDueUs)
+    {
+        return;
+    }
+    connecting = false;
+    connected = true;
+    if (!(uint32_t)staticIP)
+    {
+        Sim::radio.dhcpLeases++;
+    }
+    raise(ARDUINO_EVENT_WIFI_STA_CONNECTED);
+    raise(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+}
+
+static void linkDropped()
+{
+    if (!connected)
+    {
+        return;
+    }
+    fprintf(stderr, "sim: WiFi link dropped at %.3f s\n", Sim::runUs() / 1e6);
+    connected = false;
+    raise(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+}
+
+// Drops that fall in this boot
+static void scheduleDrops()
+{
+    static bool scheduled = false;
+    if (scheduled)
+    {
+        return;
+    }
+    scheduled = true;
+    uint64_t bootStart = Sim::runUs() - Sim::nowUs();
+    for (uint8_t i = 0; i < Sim::options.drops; i++)
+    {
+        uint64_t at = (uint64_t)Sim::options.dropAtS[i] * 1000000;
+        if (at >= Sim::runUs())
+        {
+            Sim::after((uint32_t)((at - bootStart) / 1000 - Sim::nowUs() / 1000), linkDropped);
+        }
+    }
+}
+
+bool WiFiClass::mode(wifi_mode_t mode)
+{
+    currentMode = mode;
+    scheduleDrops();
+    return true;
+}
+
+bool WiFiClass::config(IPAddress localIP, IPAddress gateway, IPAddress subnet, IPAddress dns1, IPAddress dns2)
+{
+    (void)dns2;
+    staticIP = localIP;
+    staticGateway = gateway;
+    staticSubnet = subnet;
+    staticDns = dns1;
+    return true;
+}
+
+wl_status_t WiFiClass::begin(const char *ssid, const char *passphrase, int32_t channel, const uint8_t *bssid,
+                             bool connect)
+{
+    (void)passphrase;
+    if (currentMode == WIFI_OFF)
+    {
+        mode(WIFI_STA);
+    }
+    if (ssid)
+    {
+        configChannel = channel;
+        configBssidSet = bssid != nullptr;
+        if (bssid)
+        {
+            memcpy(configBssid, bssid, sizeof(configBssid));
+        }
+    }
+    // Nothing to join without saved or given credentials
+    if (!connect || (!ssid && !Sim::options.credentials))
+    {
+        return WL_DISCONNECTED;
+    }
+    connected = false;
+    connecting = false;
+    // A known channel and BSSID skip the scan; if the AP isn't there the
+    // join never completes
+    uint32_t ms = Sim::options.connectMs;
+    if (configBssidSet)
+    {
+        if (configChannel != Sim::options.apChannel || memcmp(configBssid, FAKE_BSSID, sizeof(FAKE_BSSID)) != 0)
+        {
+            Sim::radio.missedJoins++;
+            return WL_DISCONNECTED;
+        }
+        Sim::radio.directJoins++;
+        ms = Sim::options.fastConnectMs;
+    }
+    else
+    {
+        Sim::radio.scans++;
+    }
+    connecting = true;
+    connectDueUs = Sim::nowUs() + (uint64_t)ms * 1000;
+    Sim::after(ms, connectDone);
+    return WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect(bool wifiOff, bool eraseAp)
+{
+    (void)eraseAp;
+    connecting = false;
+    if (wifiOff)
+    {
+        currentMode = WIFI_OFF;
+    }
+    if (connected)
+    {
+        connected = false;
+        raise(ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    }
+    return true;
+}
+
+void WiFiClass::onEvent(WiFiEventCb callback, arduino_event_id_t event)
+{
+    if (handlerCount < sizeof(handlers) / sizeof(handlers[0]))
+    {
+        handlers[handlerCount++] = {callback, event};
+    }
+}
+
+wl_status_t WiFiClass::status()
+{
+    return connected ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+int8_t WiFiClass::RSSI()
+{
+    return connected ? Sim::options.rssi : 0;
+}
+
+uint8_t *WiFiClass::BSSID()
+{
+    static uint8_t bssid[6];
+    memcpy(bssid, FAKE_BSSID, sizeof(bssid));
+    return connected ? bssid : nullptr;
+}
+
+int32_t WiFiClass::channel()
+{
+    return connected ? Sim::options.apChannel : 0;
+}
+
+IPAddress WiFiClass::localIP()
+{
+    if (!connected)
+    {
+        return IPAddress();
+    }
+    return (uint32_t)staticIP ? staticIP : IPAddress(192, 168, 1, 50);
+}
+
+IPAddress WiFiClass::gatewayIP()
+{
+    return (uint32_t)staticGateway ? staticGateway : IPAddress(192, 168, 1, 1);
+}
+
+IPAddress WiFiClass::subnetMask()
+{
+    return (uint32_t)staticSubnet ? staticSubnet : IPAddress(255, 255, 255, 0);
+}
+
+IPAddress WiFiClass::dnsIP(uint8_t index)
+{
+    if (index > 0)
+    {
+        return IPAddress();
+    }
+    return (uint32_t)staticDns ? staticDns : IPAddress(192, 168, 1, 1);
+}
+
+IPAddress WiFiClass::softAPIP()
+{
+    return IPAddress(192, 168, 4, 1);
+}
+
+// Every name gets its own made-up address, 10.0.0.1 up
+int WiFiClass::hostByName(const char *host, IPAddress &result)
+{
+    static const char *names[32];
+    static char storage[32][64];
+    static uint8_t count = 0;
+    if (!connected)
+    {
+        return 0;
+    }
+    uint8_t i = 0;
+    while (i < count && strcmp(names[i], host) != 0)
+    {
+        i++;
+    }
+    if (i == count)
+    {
+        if (count == 32)
+        {
+            return 0;
+        }
+        snprintf(storage[count], sizeof(storage[count]), "%s", host);
+        names[count++] = storage[i];
+    }
+    result = IPAddress(10, 0, 0, (uint8_t)(i + 1));
+    return 1;
+}
+
+// Config portal and saved credentials
+
+bool WiFiManager::startConfigPortal(const char *apName, const char *apPassword)
+{
+    (void)apPassword;
+    active = true;
+    openedMs = millis();
+    portalName = apName;
+    fprintf(stderr, "sim: config portal \"%s\" open, nobody will join it\n", apName);
+    if (apCallback)
+    {
+        apCallback(this);
+    }
+    // Non-blocking: the firmware polls process()
+    return false;
+}
+
+bool WiFiManager::process()
+{
+    if (active && timeoutS && millis() - openedMs >= timeoutS * 1000)
+    {
+        active = false;
+        fprintf(stderr, "sim: config portal timed out\n");
+    }
+    return false;
+}
+
+bool WiFiManager::getWiFiIsSaved()
+{
+    return Sim::options.credentials;
+}
+
+void WiFiManager::resetSettings()
+{
+    Sim::options.credentials = false;
+}
+
+// NVS
+
+bool Preferences::begin(const char *name, bool readOnly)
+{
+    space = name;
+    this->readOnly = readOnly;
+    opened = true;
+    return true;
+}
+
+std::string Preferences::path(const char *key) const
+{
+    return std::string(Sim::options.nvsDir) + "/" + space + "." + key;
+}
+
+size_t Preferences::getBytes(const char *key, void *buffer, size_t size)
+{
+    if (!opened)
+    {
+        return 0;
+    }
+    FILE *file = fopen(path(key).c_str(), "rb");
+    if (!file)
+    {
+        return 0;
+    }
+    // As on the device, a value larger than the buffer isn't read at all
+    uint8_t value[512];
+    size_t len = fread(value, 1, sizeof(value), file);
+    fclose(file);
+    if (len > size)
+    {
+        return 0;
+    }
+    memcpy(buffer, value, len);
+    return len;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t size)
+{
+    if (!opened || readOnly)
+    {
+        return 0;
+    }
+    FILE *file = fopen(path(key).c_str(), "wb");
+    if (!file)
+    {
+        return 0;
+    }
+    size_t written = fwrite(value, 1, size, file);
+    fclose(file);
+    return written;
+}
+
+bool Preferences::remove(const char *key)
+{
+    return opened && !readOnly && unlink(path(key).c_str()) == 0;
+}
+
+// TCP to the stand-in server
+
+int WiFiClient::connect(const char *host, uint16_t port)
+{
+    (void)host;
+    (void)port;
+    stop();
+    if (WiFi.status() != WL_CONNECTED)
+    {
+        return 0;
+    }
+    if (Sim::options.respond)
+    {
+        local = true;
+        return 1;
+    }
+    char service[8];
+    snprintf(service, sizeof(service), "%u", (unsigned)Sim::options.serverPort);
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo *address = nullptr;
+    if (getaddrinfo(Sim::options.serverHost, service, &hints, &address) != 0)
+    {
+        return 0;
+    }
+    fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (fd >= 0 && ::connect(fd, address->ai_addr, address->ai_addrlen) != 0)
+    {
+        fprintf(stderr, "sim: can't reach the stand-in server at %s:%s (%s)\n", Sim::options.serverHost, service,
+                strerror(errno));
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(address);
+    if (fd < 0)
+    {
+        return 0;
+    }
+    // A wedged server shouldn't hang the run
+    struct timeval timeout = {5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    used = pos = 0;
+    return 1;
+}
+
+uint8_t WiFiClient::connected()
+{
+    return fd >= 0 || local;
+}
+
+void WiFiClient::stop()
+{
+    if (fd >= 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+    used = pos = 0;
+    local = false;
+    body = nullptr;
+    bodyLen = bodyPos = 0;
+}
+
+// HTTPClient::GET() writes its request in one piece: take the path and the
+// Host header from it and queue the reply
+void WiFiClient::respondLocally(const uint8_t *request, size_t size)
+{
+    char text[512];
+    snprintf(text, sizeof(text), "%.*s", (int)size, (const char *)request);
+    char path[256] = "";
+    char host[64] = "";
+    sscanf(text, "GET %255s", path);
+    const char *header = strstr(text, "\r\nHost: ");
+    if (header)
+    {
+        sscanf(header + 8, "%63[^\r]", host);
+    }
+    body = Sim::options.respond(host, path);
+    bodyLen = body ? strlen(body) : 0;
+    bodyPos = 0;
+    int n = body ? snprintf((char *)buffer, sizeof(buffer),
+                            "HTTP/1.0 200 OK\r\nContent-Type: application/json\r\nContent-Length: %u\r\n\r\n",
+                            (unsigned)bodyLen)
+                 : snprintf((char *)buffer, sizeof(buffer), "HTTP/1.0 404 Not Found\r\n\r\n");
+    used = (size_t)n;
+    pos = 0;
+}
+
+void WiFiClient::write(const uint8_t *data, size_t size)
+{
+    if (local)
+    {
+        respondLocally(data, size);
+        return;
+    }
+    while (fd >= 0 && size > 0)
+    {
+        ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+        if (n <= 0)
+        {
+            stop();
+            return;
+        }
+        data += n;
+        size -= (size_t)n;
+    }
+}
+
+bool WiFiClient::fill()
+{
+    if (pos < used)
+    {
+        return true;
+    }
+    if (local)
+    {
+        size_t n = std::min(sizeof(buffer), bodyLen - bodyPos);
+        if (n == 0)
+        {
+            return false;
+        }
+        memcpy(buffer, body + bodyPos, n);
+        bodyPos += n;
+        used = n;
+        pos = 0;
+        return true;
+    }
+    if (fd < 0)
+    {
+        return false;
+    }
+    ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+    if (n <= 0)
+    {
+        return false;
+    }
+    used = (size_t)n;
+    pos = 0;
+    return true;
+}
+
+int WiFiClient::available()
+{
+    int pending = local ? (int)(bodyLen - bodyPos) : 0;
+    if (fd >= 0)
+    {
+        ioctl(fd, FIONREAD, &pending);
+    }
+    return (int)(used - pos) + pending;
+}
+
+int WiFiClient::read()
+{
+    return fill() ? buffer[pos++] : -1;
+}
+
+int WiFiClient::peek()
+{
+    return fill() ? buffer[pos] : -1;
+}
+
+size_t WiFiClient::readBytes(char *out, size_t length)
+{
+    size_t count = 0;
+    while (count < length && fill())
+    {
+        size_t n = std::min(length - count, used - pos);
+        memcpy(out + count, buffer + pos, n);
+        pos += n;
+        count += n;
+    }
+    return count;
+}
+
+// HTTP
+
+bool HTTPClient::begin(WiFiClient &connected, const char *url)
+{
+    client = &connected;
+    const char *start = strstr(url, "://");
+    start = start ? start + 3 : url;
+    size_t len = strcspn(start, ":/?");
+    snprintf(host, sizeof(host), "%.*s", (int)len, start);
+    path = start + strcspn(start, "/?");
+    return true;
+}
+
+int HTTPClient::GET()
+{
+    if (!client || !client->connected())
+    {
+        return HTTPC_ERROR_NOT_CONNECTED;
+    }
+    char request[512];
+    int n = snprintf(request, sizeof(request),
+                     "GET %s%s HTTP/1.%c\r\nHost: %s\r\nUser-Agent: ESP32HTTPClient\r\nConnection: close\r\n\r\n",
+                     *path == '/' ? "" : "/", path, http10 ? '0' : '1', host);
+    if (n < 0 || (size_t)n >= sizeof(request))
+    {
+        return HTTPC_ERROR_SEND_HEADER_FAILED;
+    }
+    client->write((const uint8_t *)request, (size_t)n);
+    if (!client->connected())
+    {
+        return HTTPC_ERROR_SEND_HEADER_FAILED;
+    }
+
+    // Status line, then headers up to the blank line
+    char line[256];
+    int code = 0;
+    bool first = true;
+    while (true)
+    {
+        size_t len = 0;
+        int c;
+        while ((c = client->read()) >= 0 && c != '\n')
+        {
+            if (c != '\r' && len + 1 < sizeof(line))
+            {
+                line[len++] = (char)c;
+            }
+        }
+        line[len] = '\0';
+        if (c < 0)
+        {
+            return first ? HTTPC_ERROR_READ_TIMEOUT : HTTPC_ERROR_CONNECTION_LOST;
+        }
+        if (first)
+        {
+            if (strncmp(line, "HTTP/1.", 7) != 0 || sscanf(line + 8, " %d", &code) != 1 || code <= 0)
+            {
+                return HTTPC_ERROR_NO_HTTP_SERVER;
+            }
+            first = false;
+        }
+        else if (len == 0)
+        {
+            return code;
+        }
+    }
+}
+
+String HTTPClient::errorToString(int error)
+{
+    switch (error)
+    {
+    case HTTPC_ERROR_CONNECTION_REFUSED:
+        return "connection refused";
+    case HTTPC_ERROR_SEND_HEADER_FAILED:
+        return "send header failed";
+    case HTTPC_ERROR_NOT_CONNECTED:
+        return "not connected";
+    case HTTPC_ERROR_CONNECTION_LOST:
+        return "connection lost";
+    case HTTPC_ERROR_NO_HTTP_SERVER:
+        return "no HTTP server";
+    case HTTPC_ERROR_READ_TIMEOUT:
+        return "read Timeout";
+    default:
+        return String();
+    }
+}
+
+// UDP: the built-in NTP server
+
+static const uint16_t NTP_PORT = 123;
+static const uint64_t NTP_UNIX_OFFSET = 2208988800ULL;
+
+static void putNtpTime(uint8_t *out, int64_t unixUs)
+{
+    uint64_t seconds = (uint64_t)(unixUs / 1000000) + NTP_UNIX_OFFSET;
+    uint64_t fraction = ((uint64_t)(unixUs % 1000000) << 32) / 1000000;
+    uint64_t value = seconds << 32 | fraction;
+    for (int i = 7; i >= 0; i--)
+    {
+        out[i] = (uint8_t)value;
+        value >>= 8;
+    }
+}
+
+uint8_t WiFiUDP::begin(uint16_t port)
+{
+    (void)port;
+    open = true;
+    queued = 0;
+    current = -1;
+    return 1;
+}
+
+void WiFiUDP::stop()
+{
+    open = false;
+    queued = 0;
+    current = -1;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+    to = ip;
+    toPort = port;
+    outLen = 0;
+    return open ? 1 : 0;
+}
+
+size_t WiFiUDP::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = std::min(size, PACKET_MAX - outLen);
+    memcpy(out + outLen, buffer, n);
+    outLen += n;
+    return n;
+}
+
+int WiFiUDP::endPacket()
+{
+    if (!open || WiFi.status() != WL_CONNECTED)
+    {
+        return 0;
+    }
+    // Only well-formed client requests (mode 3) get an answer
+    if (toPort != NTP_PORT || outLen < PACKET_MAX || (out[0] & 0x07) != 3 || queued == QUEUE)
+    {
+        return 1;
+    }
+    Datagram &reply = inbox[queued++];
+    reply.from = to;
+    reply.arrivesUs = Sim::nowUs() + (uint64_t)Sim::options.ntpRttMs * 1000;
+    reply.len = PACKET_MAX;
+    memset(reply.data, 0, sizeof(reply.data));
+    reply.data[0] = (0 << 6) | (4 << 3) | 4; // LI 0, version 4, mode 4 (server)
+    reply.data[1] = 1;                       // stratum 1
+    reply.data[2] = out[2];
+    reply.data[3] = (uint8_t)-20;            // ~1 us precision
+    memcpy(reply.data + 12, "SIM", 3);
+    // Stamped halfway along a symmetric path, on the true clock
+    int64_t at = Sim::trueUs() + (int64_t)Sim::options.ntpRttMs * 500;
+    putNtpTime(reply.data + 16, at);
+    memcpy(reply.data + 24, out + 40, 8); // originate = the request's transmit time
+    putNtpTime(reply.data + 32, at);
+    putNtpTime(reply.data + 40, at);
+    return 1;
+}
+
+int WiFiUDP::parsePacket()
+{
+    if (current >= 0)
+    {
+        // Done with the last one
+        memmove(&inbox[current], &inbox[current + 1], (queued - current - 1) * sizeof(Datagram));
+        queued--;
+        current = -1;
+    }
+    for (uint8_t i = 0; i < queued; i++)
+    {
+        if (inbox[i].arrivesUs <= Sim::nowUs() && (current < 0 || inbox[i].arrivesUs < inbox[current].arrivesUs))
+        {
+            current = i;
+        }
+    }
+    readPos = 0;
+    return current >= 0 ? (int)inbox[current].len : 0;
+}
+
+int WiFiUDP::read(uint8_t *buffer, size_t size)
+{
+    if (current < 0)
+    {
+        return 0;
+    }
+    size_t n = std::min(size, inbox[current].len - readPos);
+    memcpy(buffer, inbox[current].data + readPos, n);
+    readPos += n;
+    return (int)n;
+}
+
+IPAddress WiFiUDP::remoteIP() const
+{
+    return current >= 0 ? inbox[current].from : IPAddress();
+}
+
+// Diag server: routes run in-process, the listener is polled while idle
+
+WebServer *WebServer::started = nullptr;
+
+WebServer::WebServer(int port) : routeCount(0), listener(-1), status(0), type(""), pageLen(0), truncated(false)
+{
+    (void)port;
+}
+
+void WebServer::on(const char *uri, HTTPMethod method, Handler handler)
+{
+    (void)method;
+    if (routeCount < MAX_ROUTES)
+    {
+        routes[routeCount++] = {uri, handler};
+    }
+}
+
+void WebServer::begin()
+{
+    if (started)
+    {
+        return;
+    }
+    started = this;
+    uint16_t port = Sim::options.httpPort;
+    if (port == 0)
+    {
+        return;
+    }
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (listener < 0 || bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 4) != 0)
+    {
+        fprintf(stderr, "sim: can't listen on 127.0.0.1:%u (%s)\n", (unsigned)port, strerror(errno));
+        if (listener >= 0)
+        {
+            close(listener);
+        }
+        listener = -1;
+        return;
+    }
+    fcntl(listener, F_SETFL, O_NONBLOCK);
+    fprintf(stderr, "sim: diag server on http://127.0.0.1:%u/\n", (unsigned)port);
+    Sim::onIdle(poll);
+}
+
+void WebServer::poll()
+{
+    started->handleClient();
+}
+
+void WebServer::send(int code, const char *contentType, const char *content)
+{
+    status = code;
+    type = contentType;
+    sendContent(content, strlen(content));
+}
+
+void WebServer::sendContent(const char *content, size_t length)
+{
+    size_t room = sizeof(page) - pageLen;
+    if (length > room)
+    {
+        length = room;
+        truncated = true;
+    }
+    memcpy(page + pageLen, content, length);
+    pageLen += length;
+}
+
+int WebServer::run(const char *uri)
+{
+    pageLen = 0;
+    truncated = false;
+    for (uint8_t i = 0; i < routeCount; i++)
+    {
+        if (strcmp(routes[i].uri, uri) == 0)
+        {
+            status = 200;
+            type = "text/plain";
+            routes[i].handler();
+            if (truncated)
+            {
+                fprintf(stderr, "sim: %s cut to WebServer::PAGE_SIZE\n", uri);
+            }
+            return status;
+        }
+    }
+    status = 404;
+    type = "text/plain";
+    const char *missing = "Not found\n";
+    sendContent(missing, strlen(missing));
+    return status;
+}
+
+int WebServer::get(const char *uri, const char **body, size_t *length)
+{
+    if (!started)
+    {
+        *body = "";
+        *length = 0;
+        return 0;
+    }
+    int code = started->run(uri);
+    *body = started->page;
+    *length = started->pageLen;
+    return code;
+}
+
+void WebServer::handleClient()
+{
+    if (listener < 0)
+    {
+        return;
+    }
+    int fd = accept(listener, nullptr, nullptr);
+    if (fd < 0)
+    {
+        return;
+    }
+    // The request line is all that's needed; a slow client gets a second
+    struct timeval timeout = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    char request[1024];
+    size_t len = 0;
+    while (len + 1 < sizeof(request))
+    {
+        ssize_t n = recv(fd, request + len, sizeof(request) - 1 - len, 0);
+        if (n <= 0)
+        {
+            break;
+        }
+        len += (size_t)n;
+        request[len] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n"))
+        {
+            break;
+        }
+    }
+    request[len] = '\0';
+
+    char uri[256] = "";
+    sscanf(request, "GET %255[^? \r\n]", uri);
+    int code = run(uri);
+    char header[160];
+    int n = snprintf(header, sizeof(header),
+                     "HTTP/1.0 %d %s\r\nContent-Type: %s\r\nContent-Length: %u\r\nConnection: close\r\n\r\n", code,
+                     code == 200 ? "OK" : "Not Found", type, (unsigned)pageLen);
+    ::send(fd, header, (size_t)n, MSG_NOSIGNAL);
+    ::send(fd, page, pageLen, MSG_NOSIGNAL);
+    close(fd);
+}
@@ -0,0 +1,212 @@
+#include <string.h>
+#include <sys/stat.h>
+#include "sim_panel.h"
+#include "sim.h"
+
+#define ST77XX_SLPIN 0x10
+#define ST77XX_SLPOUT 0x11
+#define ST77XX_DISPOFF 0x28
+#define ST77XX_DISPON 0x29
+#define ST77XX_CASET 0x2A
+#define ST77XX_RASET 0x2B
+#define ST77XX_RAMWR 0x2C
+
+SimPanelBus *SimPanelBus::current = nullptr;
+
+static void saveFrameOnIdle()
+{
+    if (SimPanelBus::instance())
+    {
+        SimPanelBus::instance()->saveFrame();
+    }
+}
+
+SimPanelBus::SimPanelBus(int16_t width, int16_t height, uint8_t colStart, uint8_t rowStart)
+    : width(width), height(height), colStart(colStart), rowStart(rowStart),
+      ram(new uint16_t[(size_t)width * height]()), command(0), argCount(0), x0(0), x1(width - 1), y0(0),
+      y1(height - 1), x(0), y(0), pendingByte(-1), sleeping(true), displayOn(false), changed(false), frames(0),
+      sent(0)
+{
+    current = this;
+}
+
+SimPanelBus::~SimPanelBus()
+{
+    if (current == this)
+    {
+        current = nullptr;
+    }
+    delete[] ram;
+}
+
+void SimPanelBus::begin()
+{
+    static bool hooked = false;
+    if (!hooked)
+    {
+        hooked = true;
+        Sim::onIdle(saveFrameOnIdle);
+    }
+}
+
+void SimPanelBus::writeCommand(uint8_t cmd)
+{
+    sent++;
+    command = cmd;
+    argCount = 0;
+    pendingByte = -1;
+    switch (cmd)
+    {
+    case ST77XX_SLPIN:
+    case ST77XX_SLPOUT:
+        changed |= sleeping != (cmd == ST77XX_SLPIN);
+        sleeping = cmd == ST77XX_SLPIN;
+        break;
+    case ST77XX_DISPOFF:
+    case ST77XX_DISPON:
+        changed |= displayOn != (cmd == ST77XX_DISPON);
+        displayOn = cmd == ST77XX_DISPON;
+        break;
+    case ST77XX_RAMWR:
+        x = x0;
+        y = y0;
+        break;
+    }
+}
+
+void SimPanelBus::writeData(const uint8_t *data, size_t len)
+{
+    sent += len;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (command == ST77XX_RAMWR)
+        {
+            // Pixels sent as parameter bytes, MSB first
+            if (pendingByte < 0)
+            {
+                pendingByte = data[i];
+            }
+            else
+            {
+                pixel((uint16_t)(pendingByte << 8 | data[i]));
+                pendingByte = -1;
+            }
+            continue;
+        }
+        if (argCount < sizeof(args))
+        {
+            args[argCount++] = data[i];
+        }
+        if (argCount == 4 && (command == ST77XX_CASET || command == ST77XX_RASET))
+        {
+            int16_t first = (int16_t)(args[0] << 8 | args[1]);
+            int16_t last = (int16_t)(args[2] << 8 | args[3]);
+            if (command == ST77XX_CASET)
+            {
+                x0 = first - colStart;
+                x1 = last - colStart;
+            }
+            else
+            {
+                y0 = first - rowStart;
+                y1 = last - rowStart;
+            }
+        }
+    }
+}
+
+void SimPanelBus::writePixels(const uint16_t *pixels, size_t count)
+{
+    sent += count * 2;
+    for (size_t i = 0; i < count; i++)
+    {
+        pixel(pixels[i]);
+    }
+}
+
+void SimPanelBus::writeRepeat(uint16_t color, uint32_t count)
+{
+    sent += count * 2;
+    while (count--)
+    {
+        pixel(color);
+    }
+}
+
+void SimPanelBus::delayMs(uint32_t ms)
+{
+    Sim::wait(ms, false);
+}
+
+// Next pixel of the RAMWR window, wrapping like the controller does.
+// Writes outside the visible area (the offsets' margin) are dropped.
+void SimPanelBus::pixel(uint16_t color)
+{
+    if (x >= 0 && x < width && y >= 0 && y < height)
+    {
+        uint16_t &cell = ram[(size_t)y * width + x];
+        changed |= cell != color;
+        cell = color;
+    }
+    if (++x > x1)
+    {
+        x = x0;
+        if (++y > y1)
+        {
+            y = y0;
+        }
+    }
+}
+
+void SimPanelBus::saveFrame()
+{
+    if (!changed || !Sim::options.framesDir)
+    {
+        return;
+    }
+    changed = false;
+    frames++;
+
+    mkdir(Sim::options.framesDir, 0755);
+    char path[256];
+    snprintf(path, sizeof(path), "%s/frame-%05u.ppm", Sim::options.framesDir, (unsigned)frames);
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "sim: can't write %s\n", path);
+        return;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    bool visible = displayOn && !sleeping;
+    for (size_t i = 0; i < (size_t)width * height; i++)
+    {
+        uint16_t c = visible ? ram[i] : 0;
+        // Replicate the top bits so white stays 255
+        uint8_t rgb[3] = {(uint8_t)((c >> 8 & 0xF8) | c >> 13), (uint8_t)((c >> 3 & 0xFC) | (c >> 9 & 0x03)),
+                          (uint8_t)((c << 3 & 0xF8) | (c >> 2 & 0x07))};
+        fwrite(rgb, 1, sizeof(rgb), file);
+    }
+    fclose(file);
+    fprintf(stderr, "sim: %s at %.3f s\n", path, Sim::runUs() / 1e6);
+}
+
+void SimPanelBus::saveState(FILE *file) const
+{
+    uint8_t flags = (uint8_t)(sleeping | displayOn << 1);
+    fwrite(&flags, 1, 1, file);
+    fwrite(&frames, sizeof(frames), 1, file);
+    fwrite(ram, sizeof(uint16_t), (size_t)width * height, file);
+}
+
+bool SimPanelBus::loadState(FILE *file)
+{
+    uint8_t flags;
+    if (fread(&flags, 1, 1, file) != 1 || fread(&frames, sizeof(frames), 1, file) != 1 ||
+        fread(ram, sizeof(uint16_t), (size_t)width * height, file) != (size_t)width * height)
+    {
+        return false;
+    }
+    sleeping = flags & 1;
+    displayOn = flags & 2;
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef HOST_SIM_PANEL_H
+#define HOST_SIM_PANEL_H
+
+#include <stdio.h>
+#include "panel_bus.h"
+
+// The ST7735 as seen from its bus: CASET/RASET/RAMWR into controller RAM,
+// sleep and display on/off, everything else accepted and ignored. The
+// init list's MADCTL and colour order are taken as set up, so RAM is kept
+// in the canvas's coordinates and pixels as plain RGB565.
+//
+// Whenever the firmware is about to wait and the visible image changed,
+// the screen is written to SimOptions::framesDir as frame-NNNNN.ppm
+// (binary PPM, 8 bits per channel; black while the panel is off).
+class SimPanelBus : public PanelBus
+{
+public:
+    SimPanelBus(int16_t width, int16_t height, uint8_t colStart, uint8_t rowStart);
+    ~SimPanelBus();
+
+    void begin() override;
+    void beginTransaction() override {}
+    void endTransaction() override {}
+    void writeCommand(uint8_t cmd) override;
+    void writeData(const uint8_t *data, size_t len) override;
+    void writePixels(const uint16_t *pixels, size_t count) override;
+    void writeRepeat(uint16_t color, uint32_t count) override;
+    void delayMs(uint32_t ms) override;
+
+    // Bytes that would have crossed the wire, commands included
+    uint32_t bytesSent() const { return sent; }
+
+    // Write a snapshot if the image changed since the last one
+    void saveFrame();
+    uint32_t framesSaved() const { return frames; }
+
+    // Carried through the restart that emulates deep sleep, as the real
+    // panel keeps its RAM while the chip is off
+    static SimPanelBus *instance() { return current; }
+    void saveState(FILE *file) const;
+    bool loadState(FILE *file);
+
+private:
+    void pixel(uint16_t color);
+
+    static SimPanelBus *current;
+
+    int16_t width;
+    int16_t height;
+    uint8_t colStart;
+    uint8_t rowStart;
+    uint16_t *ram;
+
+    uint8_t command;
+    uint8_t args[4];
+    uint8_t argCount;
+    // RAMWR window (in canvas coordinates) and write position
+    int16_t x0, x1, y0, y1;
+    int16_t x, y;
+    // First byte of a pixel split across writeData() calls
+    int16_t pendingByte;
+
+    bool sleeping;
+    bool displayOn;
+    bool changed;
+    uint32_t frames;
+    uint32_t sent;
+};
+
+#endif // HOST_SIM_PANEL_H
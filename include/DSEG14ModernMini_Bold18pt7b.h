@@ -1,3 +1,6 @@
+#ifndef DSEG14MODERNMINI_BOLD18PT7B_H
+#define DSEG14MODERNMINI_BOLD18PT7B_H
+
 const uint8_t DSEG14ModernMini_Bold18pt7bBitmaps[] PROGMEM = {
   0x00, 0x00, 0xC0, 0x07, 0x00, 0x3E, 0x01, 0xF0, 0x0F, 0x87, 0xFC, 0x3F,
   0xE0, 0xFF, 0x07, 0xF8, 0x37, 0xC0, 0xBE, 0x05, 0xF0, 0x2F, 0x80, 0x7C,
@@ -540,7 +543,8 @@ const uint8_t DSEG14ModernMini_Bold18pt7bBitmaps[] PROGMEM = {
   0x00, 0xFE, 0x00, 0x03, 0xF3, 0xFF, 0xC7, 0xCF, 0xFF, 0xC6, 0x7F, 0xFF,
   0x81, 0xFF, 0xFF, 0x80 };
 
-const GFXglyph DSEG14ModernMini_Bold18pt7bGlyphs[] PROGMEM = {
+// constexpr so Layout can measure text at compile time
+constexpr GFXglyph DSEG14ModernMini_Bold18pt7bGlyphs[] PROGMEM = {
   {     0,   1,   1,   7,    0,    0 },   // 0x20 ' '
   {     1,   1,   1,  29,    0,    0 },   // 0x21 '!'
   {     2,  13,  17,  29,    3,  -32 },   // 0x22 '"'
@@ -643,3 +647,5 @@ const GFXfont DSEG14ModernMini_Bold18pt7b PROGMEM = {
   0x20, 0x7E, 38 };
 
 // Approx. 7144 bytes
+
+#endif // DSEG14MODERNMINI_BOLD18PT7B_H
@@ -0,0 +1,73 @@
+#ifndef CPU_GOVERNOR_H
+#define CPU_GOVERNOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CPU clock governor. The loop spends nearly all its time blocked, so the
+// clock sits at IDLE_MHZ and a Boost scope raises it to the boost clock
+// for bursts of work (TLS handshake, JSON parse, full redraw). Boosts nest;
+// the clock drops when the outermost one ends.
+//
+// With CONFIG_PM_ENABLE the scopes hold an ESP_PM_CPU_FREQ_MAX lock and the
+// power manager does the switching; the Arduino prebuilt SDK doesn't enable
+// it, so otherwise the clock is set directly with setCpuFrequencyMhz().
+//
+// Time at each clock and fetch connect latency (the TCP + TLS handshake
+// stage of HttpFetch) are kept per clock, so setBoostMhz() can be used to
+// compare settings.
+class CpuGovernor
+{
+public:
+    // WiFi needs at least 80 MHz on the C3
+    static const uint32_t IDLE_MHZ = 80;
+    static const uint32_t DEFAULT_BOOST_MHZ = 160;
+    static const uint8_t LEVEL_COUNT = 2;
+
+    struct Level
+    {
+        uint32_t mhz;
+        uint32_t residencyMs;
+        uint32_t handshakes;
+        uint32_t handshakeTotalMs;
+        uint32_t handshakeMaxMs;
+    };
+
+    class Boost
+    {
+    public:
+        explicit Boost(const char *reason);
+        ~Boost();
+
+    private:
+        const char *previousReason;
+    };
+
+    // Drop to the idle clock; call at the end of setup()
+    static void begin();
+    // IDLE_MHZ turns boosting off. Only clocks in the level table are accepted.
+    static bool setBoostMhz(uint32_t mhz);
+    static uint32_t boostMhz() { return boostClock; }
+    static uint32_t currentMhz() { return currentClock; }
+
+    // Record a fetch connect latency against the current clock
+    static void noteHandshake(unsigned long ms);
+
+    static const Level &level(uint8_t index) { return levels[index]; }
+    // Plain text report into `buffer`, truncated to fit. Returns the length.
+    static size_t formatReport(char *buffer, size_t size);
+
+private:
+    static void switchTo(uint32_t mhz);
+    static Level *levelFor(uint32_t mhz);
+
+    static Level levels[LEVEL_COUNT];
+    static uint32_t boostClock;
+    static uint32_t currentClock;
+    static unsigned long lastSwitch;
+    static uint8_t depth;
+    static uint32_t switches;
+    static const char *reason;
+};
+
+#endif // CPU_GOVERNOR_H
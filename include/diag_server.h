@@ -0,0 +1,31 @@
+#ifndef DIAG_SERVER_H
+#define DIAG_SERVER_H
+
+#include <WebServer.h>
+
+// Small HTTP server on port 80 for on-device diagnostics. It runs in its
+// own task so the main loop can keep sleeping until its next deadline.
+// Both pages render into the same static buffer, one request at a time;
+// /diag goes out one section at a time, /metrics in one piece.
+//   GET /diag     -> Telemetry, CPU, time sync, fetch latency and (profile
+//                    builds) zone reports (text/plain)
+//   GET /metrics  -> Prometheus text format (see metrics_page.h)
+class DiagServer
+{
+public:
+    static const uint16_t PORT = 80;
+    static const size_t REPORT_SIZE = 6144;
+
+    // Start once WiFi is up
+    static void begin();
+
+private:
+    static void task(void *param);
+    static void handleDiag();
+    static void handleMetrics();
+
+    static WebServer server;
+    static char report[REPORT_SIZE];
+};
+
+#endif // DIAG_SERVER_H
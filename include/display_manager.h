@@ -1,11 +1,12 @@
 #include <Adafruit_GFX.h>
-#include <Adafruit_ST7735.h>
-#include <ArduinoJson.h>
+#include "st77xx_panel.h"
+#include "indexed_canvas.h"
 
-// #include "DSEG14Modern_Bold18pt7b.h"
-#include "DSEG14ModernMini_Bold18pt7b.h"
-// #include "DSEGWeather18pt7b.h"
-#include <Fonts/FreeMonoBold12pt7b.h>
+#include "layout.h"
+#include "fixed_string.h"
+#include "flight_record.h"
+
+// Other bundled fonts: DSEG14Modern_Bold18pt7b.h, DSEGWeather18pt7b.h
 
 // Pin definitions for ESP32-C3 with custom SPI pins
 #define TFT_CS 2  // Chip select pin
@@ -15,24 +16,14 @@
 #define TFT_MOSI 4 // MOSI pin (based on your board schematic)
 #define TFT_SCLK 3 // SCLK pin (based on your board schematic)
 // #define TFT_BL 9 /* No backlight control on this device  */
+#define TFT_SPI_FREQ 27000000
+// Green tab panels have a 2 column / 1 row offset in controller RAM
+#define TFT_COL_START 2
+#define TFT_ROW_START 1
 
-#define SCREEN_WIDTH 128
-#define SCREEN_HEIGHT 128
-
-// Layout constants
-#define BORDER_OFFSET 3
-#define TIME_Y_POS 55
-#define TEMP_Y_POS 85
-#define HUMIDITY_Y_POS 105
-#define AIRPORT_Y_POS 55
-#define AIRCRAFT_Y_POS 85
-#define FLIGHT_NUM_Y_POS 105
-
-// WiFi icon constants
-#define WIFI_ICON_WIDTH 22
-#define WIFI_ICON_HEIGHT 8
-#define WIFI_BAR_WIDTH 2
-#define WIFI_BAR_SPACING 2
+// Display state lives in fixed inline buffers so drawing never allocates
+typedef FixedString<16> FieldText;   // one text field (time, airport, callsign...)
+typedef FixedString<48> MessageText; // full-screen error message
 
 enum DisplayMode
 {
@@ -42,10 +33,37 @@ enum DisplayMode
     MODE_WIFI_SETUP
 };
 
+// When the panel is put to sleep (DISPOFF + SLPIN); it always wakes for an error
+enum PanelSleepPolicy
+{
+    PANEL_ALWAYS_ON,
+    PANEL_SLEEP_AT_NIGHT,                // dark all night
+    PANEL_SLEEP_AT_NIGHT_EXCEPT_FLIGHTS  // dark at night unless a flight is shown
+};
+
+struct PanelPowerStats
+{
+    uint32_t sleeps;
+    uint32_t wakes;
+    uint32_t lastWakeUs; // SLPOUT to picture back on, including the catch-up flush
+    uint32_t maxWakeUs;
+};
+
+struct DisplayCounters
+{
+    uint32_t frames;   // canvas flushes that reached the panel
+    uint32_t pixels;   // pixels flushed
+    uint32_t busBytes; // SPI bytes sent, commands and init included
+    // Debug overlay refreshes are left out of all three
+};
+
 class DisplayManager
 {
 public:
-    static void initDisplay();
+    // resumed: woken from deep sleep with the panel still configured
+    // (and asleep, if panelAsleep)
+    static void initDisplay(bool resumed = false, bool panelAsleep = false);
+    static void prepareDeepSleep();
     static void clearScreen();
     static void drawTime();
     static void drawFlight(const char *airport, const char *aircraft, const char *flightNumber);
@@ -53,19 +71,38 @@ public:
     static void drawError(const char *message);
     static void clearError();
     static void displayWiFiStrength();
-    static void displayFlightData(const JsonDocument &flightData);
+    static void displayFlightData(const FlightRecord &flight);
     static void displayTime();
-    static void setWeatherInfo(const String &temperature, const String &humidity);
+    static void setWeatherInfo(const char *temperature, const char *humidity);
+    static int calculateWiFiBars(long rssi);
+    static bool isShowingError();
+    // Changes every time the screen is wiped (clear, error, setup screen)
+    static uint32_t screenEpoch();
+
+    // Panel sleep. While asleep drawing still lands on the canvas; the dirty
+    // rows go out on wake, before the display is switched back on.
+    static void setPanelSleepPolicy(PanelSleepPolicy policy);
+    static bool panelWanted(PanelSleepPolicy policy, bool night, bool flightShown, bool errorShown);
+    static void updatePanelPower(bool night);
+    static bool isPanelAsleep();
+    static const PanelPowerStats &panelPowerStats();
+    // As of the last frame; safe to read from other tasks
+    static DisplayCounters counters();
+
+    // Debug overlay along the bottom of the screen: the last frame's render
+    // time (drawing and flush) and bus bytes, free heap, the last fetch
+    // (endpoint, latency, HTTP code) and loop passes per second. It is drawn
+    // once a frame has been flushed and measured, and flushed on its own, so
+    // it never shows up in the figures it reports or in counters().
+    static void setOverlay(bool on);
+    static bool isOverlayOn();
+    // Once per loop pass: counts the pass and refreshes the overlay if it is on
+    static void updateOverlay();
 
 private:
     // Helper functions for cleaner code
-    static void drawTextWithErase(int x, int y, const String &oldText, const String &newText,
-                                  uint16_t color, const GFXfont *font = nullptr);
+    static void drawField(const Layout::TextSlot &slot, const char *text,
+                          uint16_t color, const GFXfont *font);
     static void drawBorderedRect(uint16_t color);
-    static int calculateWiFiBars(long rssi);
-    static void drawWiFiBars(int bars, int startX, int startY, uint16_t activeColor = ST77XX_GREEN);
-
-    // Data extraction helpers
-    static String getValueOrQuestion(const JsonDocument &data, const char *key);
-    static String getCurrentTimeString();
+    static void drawWiFiBars(int bars, uint16_t activeColor = ST77XX_GREEN);
 };
\ No newline at end of file
@@ -0,0 +1,114 @@
+#ifndef FETCH_METRICS_H
+#define FETCH_METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+class FetchTimer;
+
+// Latency histogram in a fixed 120-byte table: exact below 4 ms, then four
+// buckets per power of two up to 65 s, so percentiles are within 25%.
+class LatencyHistogram
+{
+public:
+    static const uint8_t BUCKETS = 60;
+    static const uint32_t MAX_MS = 65535;
+
+    void add(uint32_t ms);
+    void clear();
+    // Upper edge of the bucket holding the p-th percentile, clamped to [min, max]
+    uint32_t percentile(uint8_t p) const;
+    uint32_t count() const { return samples; }
+    uint32_t sum() const { return total; }
+    uint32_t min() const { return samples ? lowest : 0; }
+    uint32_t max() const { return highest; }
+
+    static uint8_t bucketFor(uint32_t ms);
+    static uint32_t bucketUpper(uint8_t index);
+
+private:
+    uint16_t counts[BUCKETS];
+    uint32_t samples;
+    uint32_t total;
+    uint32_t lowest;
+    uint32_t highest;
+};
+
+// Per-endpoint, per-stage fetch latencies. A fetch is timed with a
+// FetchTimer, marking each stage as it completes, and handed to record().
+class FetchMetrics
+{
+public:
+    enum Stage
+    {
+        STAGE_DNS,
+        STAGE_CONNECT,    // TCP and TLS handshake (WiFiClientSecure does both in one call)
+        STAGE_FIRST_BYTE, // request sent to response headers read
+        STAGE_BODY,       // body transfer and JSON parse, which are streamed together
+        STAGE_TOTAL,
+        STAGE_COUNT
+    };
+
+    enum Endpoint
+    {
+        ENDPOINT_FLIGHT,
+        ENDPOINT_WEATHER,
+        ENDPOINT_COUNT
+    };
+
+    // The most recent fetch of either endpoint
+    struct Last
+    {
+        uint32_t totalMs; // to the last stage reached
+        int16_t status;   // HTTP status, or an HTTPC_ERROR_* code (<= 0)
+        uint8_t endpoint;
+        bool ok;
+    };
+
+    static const char *stageName(uint8_t stage);
+    static const char *endpointName(uint8_t endpoint);
+
+    // `status` as returned by HttpFetch::get()
+    static void record(Endpoint endpoint, const FetchTimer &timer, bool ok, int status);
+    // All zero until fetchCount() > 0. For loop() only (the overlay).
+    static const Last &last() { return lastFetch; }
+    // The rest can be read from any task (see stats_lock.h)
+    // Both endpoints, ok or not
+    static uint32_t fetchCount();
+    // A copy, so it can't change while it's formatted
+    static LatencyHistogram histogram(Endpoint endpoint, Stage stage);
+    static uint32_t successes(Endpoint endpoint);
+    // Failures by the stage that didn't complete
+    static uint32_t failures(Endpoint endpoint, Stage stage);
+
+    // Plain text report into `buffer`, truncated to fit. Returns the length.
+    static size_t formatReport(char *buffer, size_t size);
+
+private:
+    static LatencyHistogram histograms[ENDPOINT_COUNT][STAGE_COUNT];
+    static uint32_t ok[ENDPOINT_COUNT];
+    static uint32_t failed[ENDPOINT_COUNT][STAGE_COUNT];
+    static Last lastFetch;
+};
+
+// Stage timestamps for one fetch; times come from the caller (millis())
+class FetchTimer
+{
+public:
+    FetchTimer() { start(0); }
+    void start(unsigned long nowMs);
+    // `stage` finished at nowMs; its time runs from the previous mark
+    void mark(FetchMetrics::Stage stage, unsigned long nowMs);
+    bool reached(FetchMetrics::Stage stage) const { return (done & (1u << stage)) != 0; }
+    uint32_t stageMs(FetchMetrics::Stage stage) const { return ms[stage]; }
+    // First stage not marked yet (STAGE_TOTAL when all are)
+    FetchMetrics::Stage pending() const;
+
+private:
+    unsigned long started;
+    unsigned long last;
+    uint32_t ms[FetchMetrics::STAGE_COUNT];
+    uint8_t done;
+};
+
+#endif // FETCH_METRICS_H
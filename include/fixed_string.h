@@ -0,0 +1,104 @@
+#ifndef FIXED_STRING_H
+#define FIXED_STRING_H
+
+#include <stddef.h>
+#include <string.h>
+
+// Fixed-capacity string stored inline (in the object, on the stack or in
+// .bss), for display state that changes every tick. Never touches the heap:
+// text that doesn't fit is truncated and truncated() reports it.
+template <size_t N>
+class FixedString
+{
+public:
+    static const size_t CAPACITY = N - 1; // characters, excluding the terminator
+
+    FixedString() : used(0), overflow(false) { buffer[0] = '\0'; }
+    FixedString(const char *text) : FixedString() { assign(text); }
+
+    FixedString &operator=(const char *text)
+    {
+        assign(text);
+        return *this;
+    }
+
+    void assign(const char *text)
+    {
+        clear();
+        append(text);
+    }
+
+    void append(const char *text)
+    {
+        if (!text)
+        {
+            return;
+        }
+        size_t n = strlen(text);
+        if (n > CAPACITY - used)
+        {
+            n = CAPACITY - used;
+            overflow = true;
+        }
+        memcpy(buffer + used, text, n);
+        used += n;
+        buffer[used] = '\0';
+    }
+
+    void append(char c)
+    {
+        if (used == CAPACITY)
+        {
+            overflow = true;
+            return;
+        }
+        buffer[used++] = c;
+        buffer[used] = '\0';
+    }
+
+    FixedString &operator+=(const char *text)
+    {
+        append(text);
+        return *this;
+    }
+
+    FixedString &operator+=(char c)
+    {
+        append(c);
+        return *this;
+    }
+
+    void clear()
+    {
+        used = 0;
+        overflow = false;
+        buffer[0] = '\0';
+    }
+
+    // Raw buffer for snprintf-style writers; call resync() afterwards
+    char *data() { return buffer; }
+    void resync()
+    {
+        buffer[CAPACITY] = '\0';
+        used = strlen(buffer);
+    }
+
+    const char *c_str() const { return buffer; }
+    size_t length() const { return used; }
+    bool isEmpty() const { return used == 0; }
+    bool truncated() const { return overflow; }
+
+    bool operator==(const char *text) const { return strcmp(buffer, text ? text : "") == 0; }
+    bool operator!=(const char *text) const { return !(*this == text); }
+    template <size_t M>
+    bool operator==(const FixedString<M> &other) const { return *this == other.c_str(); }
+    template <size_t M>
+    bool operator!=(const FixedString<M> &other) const { return !(*this == other.c_str()); }
+
+private:
+    char buffer[N];
+    size_t used;
+    bool overflow;
+};
+
+#endif // FIXED_STRING_H
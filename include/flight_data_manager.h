@@ -2,15 +2,27 @@
 #define FLIGHT_DATA_H
 
 #include <ArduinoJson.h>
-#include <HTTPClient.h>
+#include "http_fetch.h"
+#include "flight_record.h"
+#include "snapshot_hash.h"
 
 class FlightDataManager
 {
 public:
     static bool fetchData();
+    static const SnapshotGate &snapshots() { return gate; }
+    // Last record handed to the display (kept through deep sleep by main)
+    static const FlightRecord &lastRecord() { return last; }
+    static void restore(const FlightRecord &record) { last = record; }
+    // Filter for deserializeJson(): the fields parseRecord() reads
+    static void buildFilter(JsonDocument &filter);
+    // Fill `record` from an API response in one pass over its fields
+    static void parseRecord(const JsonDocument &doc, FlightRecord &record);
 
 private:
-    static HTTPClient httpClient;
+    static HttpFetch http;
+    static SnapshotGate gate;
+    static FlightRecord last;
 };
 
 #endif // FLIGHT_DATA_H
@@ -0,0 +1,19 @@
+#ifndef FLIGHT_RECORD_H
+#define FLIGHT_RECORD_H
+
+// One flight as the display needs it, filled once at parse time so the
+// rendering code never sees JSON. Missing or "null" fields hold "?".
+struct FlightRecord
+{
+    static const unsigned CALLSIGN_SIZE = 9; // up to 8 characters, fills the flight number slot
+    static const unsigned AIRPORT_SIZE = 5;  // IATA/ICAO code
+    static const unsigned AIRCRAFT_SIZE = 9;
+
+    bool available; // false when the API reports no flight or no callsign
+    char callsign[CALLSIGN_SIZE];
+    char origin[AIRPORT_SIZE];
+    char destination[AIRPORT_SIZE];
+    char aircraft[AIRCRAFT_SIZE];
+};
+
+#endif // FLIGHT_RECORD_H
@@ -0,0 +1,174 @@
+#ifndef FT_LOG_H
+#define FT_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Leveled, tagged logging that never waits for the UART. FT_LOGx() formats
+// the message into a slot of a fixed ring and returns; a low-priority task
+// drains the ring to Serial when nothing else wants the CPU. When the ring
+// is full the message is dropped and counted, and the drain reports the
+// gap. Messages longer than LINE_SIZE are cut (and counted).
+//
+// Levels above FT_LOG_LEVEL (a build flag, default FT_LOG_INFO) compile to
+// nothing, arguments included.
+//
+//   static constexpr char TAG[] = "wifi";
+//   FT_LOGI(TAG, "connected in %lu ms", ms);
+//
+// With FT_LOG_TOKENIZED a call sends no text at all: level, tag and format
+// are hashed at compile time into a 32-bit token, and only the token, the
+// timestamp and the varint-encoded arguments go out, as a COBS frame between
+// zero bytes. tools/log_tokens.py collects the formats into a token database
+// at build time; tools/log_decode.py turns a capture back into text. Tags
+// must be constexpr arrays and formats string literals for the hash.
+
+#define FT_LOG_NONE 0
+#define FT_LOG_ERROR 1
+#define FT_LOG_WARN 2
+#define FT_LOG_INFO 3
+#define FT_LOG_DEBUG 4
+#define FT_LOG_VERBOSE 5
+
+#ifndef FT_LOG_LEVEL
+#define FT_LOG_LEVEL FT_LOG_INFO
+#endif
+
+#ifdef FT_LOG_TOKENIZED
+#include <type_traits>
+// The dead call keeps printf argument checking; it and the format are optimized out
+#define FT_LOG_AT(level, tag, format, ...)                                                                \
+    do                                                                                                    \
+    {                                                                                                     \
+        if (false)                                                                                        \
+        {                                                                                                 \
+            Log::checkFormat(format, ##__VA_ARGS__);                                                      \
+        }                                                                                                 \
+        Log::writeTokenized(std::integral_constant<uint32_t, Log::token(level, tag, format)>::value,      \
+                            ##__VA_ARGS__);                                                               \
+    } while (0)
+#else
+#define FT_LOG_AT(level, tag, format, ...) Log::write(level, tag, format, ##__VA_ARGS__)
+#endif
+#define FT_LOG_NOTHING() \
+    do                   \
+    {                    \
+    } while (0)
+
+#if FT_LOG_LEVEL >= FT_LOG_ERROR
+#define FT_LOGE(tag, ...) FT_LOG_AT(FT_LOG_ERROR, tag, __VA_ARGS__)
+#else
+#define FT_LOGE(tag, ...) FT_LOG_NOTHING()
+#endif
+#if FT_LOG_LEVEL >= FT_LOG_WARN
+#define FT_LOGW(tag, ...) FT_LOG_AT(FT_LOG_WARN, tag, __VA_ARGS__)
+#else
+#define FT_LOGW(tag, ...) FT_LOG_NOTHING()
+#endif
+#if FT_LOG_LEVEL >= FT_LOG_INFO
+#define FT_LOGI(tag, ...) FT_LOG_AT(FT_LOG_INFO, tag, __VA_ARGS__)
+#else
+#define FT_LOGI(tag, ...) FT_LOG_NOTHING()
+#endif
+#if FT_LOG_LEVEL >= FT_LOG_DEBUG
+#define FT_LOGD(tag, ...) FT_LOG_AT(FT_LOG_DEBUG, tag, __VA_ARGS__)
+#else
+#define FT_LOGD(tag, ...) FT_LOG_NOTHING()
+#endif
+#if FT_LOG_LEVEL >= FT_LOG_VERBOSE
+#define FT_LOGV(tag, ...) FT_LOG_AT(FT_LOG_VERBOSE, tag, __VA_ARGS__)
+#else
+#define FT_LOGV(tag, ...) FT_LOG_NOTHING()
+#endif
+
+class Log
+{
+public:
+    // Power of two, so slot tickets survive wrapping
+    static const uint8_t SLOTS = 32;
+    static const uint8_t LINE_SIZE = 128;
+
+    struct Stats
+    {
+        uint32_t written;
+        uint32_t dropped;   // ring full
+        uint32_t truncated; // longer than LINE_SIZE
+    };
+
+    // Receives one finished line (or frame), newline included
+    typedef void (*Sink)(const char *text, size_t len);
+
+    // Sink defaults to Serial. On the device this also starts the drain
+    // task; on the host call drain() yourself.
+    static void begin(Sink sink = nullptr);
+    // Safe from any task, not from an ISR
+    static void write(uint8_t level, const char *tag, const char *format, ...)
+        __attribute__((format(printf, 3, 4)));
+    // Hand up to `maxLines` queued lines to the sink. Returns how many went.
+    static size_t drain(size_t maxLines = SLOTS);
+    // Drain everything on the calling task, e.g. before deep sleep
+    static void flush();
+
+    static Stats stats();
+    static uint8_t pending();
+
+    // FNV-1a over the level letter, the tag, a 0x1f separator and the format.
+    // tools/log_tokens.py computes the same.
+    static constexpr uint32_t token(uint8_t level, const char *tag, const char *format)
+    {
+        return fnv1a(format, (fnv1a(tag, mix(2166136261u, levelLetter(level))) ^ 0x1fu) * 16777619u);
+    }
+    static constexpr char levelLetter(uint8_t level) { return level <= FT_LOG_VERBOSE ? "-EWIDV"[level] : '-'; }
+
+#ifdef FT_LOG_TOKENIZED
+    // Arguments in the order of the format: integers as zigzag varints,
+    // floating point as a little-endian float32, strings as a length byte
+    // and the bytes
+    class ArgWriter
+    {
+    public:
+        ArgWriter(uint8_t *buffer, size_t size) : start(buffer), p(buffer), end(buffer + size), cut(false) {}
+
+        template <typename T>
+        void put(T value)
+        {
+            static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "unsupported log argument");
+            int64_t v = std::is_signed<T>::value ? (int64_t)value : (int64_t)(uint64_t)value;
+            varint(((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+        }
+        void put(float value);
+        void put(double value) { put((float)value); }
+        void put(const char *text);
+        void put(char *text) { put((const char *)text); }
+
+        size_t length() const { return p - start; }
+        bool truncated() const { return cut; }
+
+    private:
+        void varint(uint64_t value);
+
+        uint8_t *start;
+        uint8_t *p;
+        uint8_t *end;
+        bool cut;
+    };
+
+    template <typename... Args>
+    static void writeTokenized(uint32_t token, Args... args)
+    {
+        uint8_t buffer[LINE_SIZE - 4];
+        ArgWriter w(buffer, sizeof(buffer));
+        (w.put(args), ...);
+        writeBinary(token, buffer, w.length(), w.truncated());
+    }
+    static void writeBinary(uint32_t token, const uint8_t *args, size_t len, bool truncated);
+
+    __attribute__((format(printf, 1, 2))) static void checkFormat(const char *format, ...) { (void)format; }
+#endif
+
+private:
+    static constexpr uint32_t mix(uint32_t hash, char c) { return (hash ^ (uint8_t)c) * 16777619u; }
+    static constexpr uint32_t fnv1a(const char *s, uint32_t hash) { return *s ? fnv1a(s + 1, mix(hash, *s)) : hash; }
+};
+
+#endif // FT_LOG_H
@@ -3,18 +3,67 @@
 
 #include <WiFi.h>
 #include <WiFiManager.h>
+#include "wifi_link.h"
 
+// Owns the radio. The connection is brought up and kept up in the
+// background by a WiFiLink state machine stepped from loop(); nothing here
+// blocks, so the device boots and keeps its clock without a network.
 class FtWiFiManager
 {
 public:
-    static bool connect();
+    // Direct association budget before falling back to a scan and DHCP
+    static const unsigned long FAST_CONNECT_TIMEOUT = 3000;
+    // Full path: scan, association and DHCP
+    static const unsigned long CONNECT_TIMEOUT = 15000;
+    // Full reconnects renew the DHCP lease; force one after this many fast ones
+    static const uint32_t MAX_FAST_RECONNECTS = 24;
+    // Config portal closes by itself after this long
+    static const unsigned long PORTAL_TIMEOUT_S = 300;
+
+    // Kept in RTC memory: survives deep sleep, cleared on power-on
+    struct ConnectStats
+    {
+        uint32_t fastHits;      // associated directly with the cached settings
+        uint32_t fastMisses;    // cached settings failed, fell back to the full path
+        uint32_t fullConnects;  // scan + DHCP (no cache, after a miss, or lease refresh)
+        uint32_t fastSinceFull;
+        uint32_t lastConnectMs; // start of the attempt to WL_CONNECTED
+        bool lastWasFast;
+    };
+
+    // radioOn false: leave the radio off until request() (night deep-sleep cycle)
+    static void begin(bool radioOn);
+    // Step the link; call on every loop wake
+    static void update();
+    // Bring the radio up if it's off
+    static void request();
+    // Radio off until request() (night light sleep)
+    static void park();
+    // Explicit trigger only (console "portal", or no saved credentials)
+    static void openPortal();
+    static bool isPortalOpen();
+    // Attempting a connection or serving the portal
+    static bool isBusy();
+    static unsigned long millisUntilNextStep();
+    static WiFiLink &link() { return wifiLink; }
+
+    // True while the radio is deliberately off (night sleep cycle)
+    static bool isRadioOff();
     static bool isConnected();
     static void disconnect();
     static String getLocalIP();
     static long getRSSI();
+    // Called from the WiFi event task whenever the station connects or drops
+    static void setStateCallback(void (*callback)());
+    static const ConnectStats &connectStats();
 
 private:
+    friend class EspWiFiDriver;
+
     static WiFiManager wm;
+    static WiFiLink wifiLink;
+    static void (*stateCallback)();
+    static void onWiFiEvent(arduino_event_id_t event);
     static void displayAPInfo(const String &apName, const String &password, const String &ip);
 };
 
@@ -0,0 +1,76 @@
+#ifndef HEAP_GUARD_H
+#define HEAP_GUARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// No-heap-after-boot checking. Built with FT_HEAP_GUARD (see [env:heap-guard]
+// and [env:native] in platformio.ini), malloc/calloc/realloc/free are
+// wrapped at link time and new/delete are replaced. After
+// markBootComplete() every allocation the loop task makes outside an Allow
+// scope is a violation: it is recorded against its caller address and the
+// innermost Tag, and reported from report(). With FT_HEAP_GUARD_ABORT the
+// first violation aborts instead, so the panic backtrace points at the
+// offender.
+//
+// Without FT_HEAP_GUARD everything here compiles to nothing.
+class HeapGuard
+{
+public:
+    static const uint8_t MAX_SITES = 16;
+
+    struct Site
+    {
+        const void *caller; // return address into the allocating function
+        const char *tag;    // innermost Tag when it happened
+        uint32_t size;      // size of the first allocation seen here
+        uint32_t count;
+    };
+
+    // Labels the allocations made while it is in scope
+    class Tag
+    {
+    public:
+#ifdef FT_HEAP_GUARD
+        explicit Tag(const char *name, bool allow = false);
+        ~Tag();
+
+    private:
+        const char *previousTag;
+        bool previousAllow;
+#else
+        explicit Tag(const char *, bool = false) {}
+#endif
+    };
+
+    // A tagged scope where allocation is expected (network stacks, TLS)
+    class Allow : public Tag
+    {
+    public:
+        explicit Allow(const char *name) : Tag(name, true) {}
+    };
+
+#ifdef FT_HEAP_GUARD
+    static void markBootComplete();
+    static bool bootComplete();
+    // Log (through the ring, never blocking) sites recorded since the last report
+    static void report();
+
+    static uint32_t violations();
+    static uint32_t allowedAllocations();
+    static uint8_t siteCount();
+    static const Site &site(uint8_t index);
+
+    // Called by the allocation hooks
+    static void onAllocate(size_t size, const void *caller);
+#else
+    static void markBootComplete() {}
+    static bool bootComplete() { return false; }
+    static void report() {}
+    static uint32_t violations() { return 0; }
+    static uint32_t allowedAllocations() { return 0; }
+    static uint8_t siteCount() { return 0; }
+#endif
+};
+
+#endif // HEAP_GUARD_H
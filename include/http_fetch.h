@@ -0,0 +1,38 @@
+#ifndef HTTP_FETCH_H
+#define HTTP_FETCH_H
+
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include "fetch_metrics.h"
+
+// One instrumented GET. The host is resolved and connected here, so DNS
+// and the TCP/TLS connect show up as separate stages, and the connected
+// client is then handed to HTTPClient. Stage times go to FetchMetrics
+// under `endpoint` when the fetch ends.
+class HttpFetch
+{
+public:
+    static const size_t MAX_HOST = 64;
+
+    explicit HttpFetch(FetchMetrics::Endpoint endpoint);
+
+    // Resolve, connect and send the request. Returns the HTTP status, or an
+    // HTTPC_ERROR_* code (<= 0) on failure.
+    int get(const char *url);
+    // Response body, readable after get() returned a status > 0
+    Stream &body() { return http.getStream(); }
+    // Close the connection and record the fetch; `ok`: body was usable
+    void end(bool ok);
+
+    const FetchTimer &timer() const { return stages; }
+
+private:
+    FetchMetrics::Endpoint endpoint;
+    HTTPClient http;
+    WiFiClient plain;
+    WiFiClientSecure secure;
+    FetchTimer stages;
+    int status;
+};
+
+#endif // HTTP_FETCH_H
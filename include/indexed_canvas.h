@@ -0,0 +1,84 @@
+#ifndef INDEXED_CANVAS_H
+#define INDEXED_CANVAS_H
+
+#include <Adafruit_GFX.h>
+#include "st77xx_panel.h"
+
+// 4 bits per pixel off-screen canvas. DisplayManager draws here with normal
+// RGB565 colours; each colour is mapped to one of 16 palette slots and only
+// the slot index is stored (8 KB for 128x128 instead of 32 KB). flush() sends
+// the rows touched since the last flush, expanding them to RGB565 one line
+// at a time through a two-pixel lookup table.
+//
+// Palette slot 1 is the accent colour: everything drawn in the current accent
+// lives in that slot, so setAccent() recolours it on the next flush without
+// any drawing calls.
+class IndexedCanvas : public Adafruit_GFX
+{
+public:
+    static const uint8_t PALETTE_SIZE = 16;
+    static const uint8_t ACCENT_INDEX = 1;
+
+    struct FlushStats
+    {
+        uint32_t flushes;
+        uint32_t bands;  // address windows sent
+        uint32_t pixels; // pixels sent
+    };
+
+    IndexedCanvas(int16_t w, int16_t h);
+
+    void setAccent(uint16_t color);
+    uint16_t accent() const { return palette[ACCENT_INDEX]; }
+    // Recolour every pixel using `from`; marks only the affected rows dirty
+    void swapColor(uint16_t from, uint16_t to);
+
+    bool isDirty() const { return dirtyTop <= dirtyBottom; }
+    void markAllDirty();
+    // Send dirty rows to the panel. Returns the number of pixels sent.
+    uint32_t flush(St77xxPanel &panel);
+
+    const FlushStats &stats() const { return counters; }
+    static size_t bufferBytes(int16_t w, int16_t h) { return ((size_t)w * h + 1) / 2; }
+
+    // Adafruit_GFX overrides
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void fillScreen(uint16_t color) override;
+
+private:
+    static const int16_t MAX_WIDTH = 128;
+    static const int16_t MAX_HEIGHT = 128;
+    static const uint8_t CLEAN = 0xFF;
+
+    uint8_t colorIndex(uint16_t color);
+    void setPaletteEntry(uint8_t index, uint16_t color);
+    void rebuildLut();
+    void markDirty(int16_t x0, int16_t x1, int16_t y);
+    bool fillSpan(int16_t x, int16_t y, int16_t w, uint8_t index);
+    uint8_t indexAt(int16_t x, int16_t y) const;
+    void expandRow(int16_t y, int16_t x0, int16_t x1, uint16_t *out) const;
+
+    uint8_t pixels[MAX_WIDTH * MAX_HEIGHT / 2];
+    uint16_t palette[PALETTE_SIZE];
+    uint8_t paletteUsed;
+    uint8_t lastColorIndex;
+    // Two pixels (one packed byte) -> two RGB565 pixels, first pixel in the low half
+    uint32_t pairLut[256];
+
+    // Per-row dirty span, CLEAN when the row is untouched
+    uint8_t rowMin[MAX_HEIGHT];
+    uint8_t rowMax[MAX_HEIGHT];
+    int16_t dirtyTop;
+    int16_t dirtyBottom;
+
+    uint16_t line[MAX_WIDTH];
+    FlushStats counters;
+};
+
+#endif // INDEXED_CANVAS_H
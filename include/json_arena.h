@@ -0,0 +1,52 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <ArduinoJson.h>
+
+// One static arena shared by every JsonDocument the fetchers build. Blocks
+// are bumped off the top; freeing or resizing the newest block works in
+// place, anything else waits for reset(). Polls therefore never touch the
+// heap, and a response bigger than the arena fails the parse with NoMemory
+// instead of growing.
+//
+// Usage: reset(), then build the filter and the document on allocator().
+// Everything built since the last reset() shares the arena, so don't reset
+// while any of it is still in scope.
+class JsonArena
+{
+public:
+    // ArduinoJson takes its variant slots a pool at a time, and the filter
+    // and the document each hold one: ARDUINOJSON_POOL_CAPACITY slots of two
+    // pointers, 1 KB on the ESP32-C3 but 4 KB on a 64-bit host. The strings
+    // of the filtered flight and weather documents fit in the rest with
+    // headroom; highWater() in the fetch logs shows the real need.
+    static const size_t POOL_BYTES = ARDUINOJSON_POOL_CAPACITY * 2 * sizeof(void *);
+    static const size_t CAPACITY = 2 * POOL_BYTES + 6144;
+
+    struct Stats
+    {
+        size_t used;
+        size_t highWater;
+        uint32_t resets;
+        uint32_t overflows; // allocations refused because the arena was full
+    };
+
+    static ArduinoJson::Allocator *allocator();
+    static void reset();
+    static const Stats &stats() { return counters; }
+    static void report(const char *label);
+
+private:
+    class Arena : public ArduinoJson::Allocator
+    {
+    public:
+        void *allocate(size_t size) override;
+        void deallocate(void *ptr) override;
+        void *reallocate(void *ptr, size_t newSize) override;
+    };
+
+    static Arena arena;
+    static Stats counters;
+};
+
+#endif // JSON_ARENA_H
@@ -0,0 +1,196 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <Adafruit_GFX.h>
+#include "DSEG14ModernMini_Bold18pt7b.h"
+#include <Fonts/FreeMonoBold12pt7b.h>
+
+#define SCREEN_WIDTH 128
+#define SCREEN_HEIGHT 128
+
+// Screen layout, resolved at compile time. Every text field gets a fixed
+// cursor position and an erase box sized from the font metrics for the
+// widest thing the field can show; the static_asserts at the bottom turn
+// overlapping or off-screen fields into build errors.
+namespace Layout
+{
+    struct Box
+    {
+        int16_t x;
+        int16_t y;
+        int16_t w;
+        int16_t h;
+
+        constexpr int16_t right() const { return x + w - 1; }
+        constexpr int16_t bottom() const { return y + h - 1; }
+        constexpr bool contains(const Box &o) const
+        {
+            return o.x >= x && o.y >= y && o.right() <= right() && o.bottom() <= bottom();
+        }
+        constexpr bool above(const Box &o) const { return bottom() < o.y; }
+    };
+
+    // Glyph extents relative to the cursor over the characters a field can show
+    struct FontMetrics
+    {
+        uint8_t advance; // widest xAdvance
+        int8_t top;      // highest ink row (negative, above the baseline)
+        int8_t bottom;   // first row below the lowest ink row
+    };
+
+    constexpr FontMetrics measure(const GFXglyph *glyphs, uint16_t first, const char *charset)
+    {
+        FontMetrics m = {0, 0, 0};
+        for (const char *c = charset; *c; c++)
+        {
+            const GFXglyph &g = glyphs[(uint8_t)*c - first];
+            if (g.xAdvance > m.advance)
+                m.advance = g.xAdvance;
+            if (g.yOffset < m.top)
+                m.top = g.yOffset;
+            if (g.yOffset + g.height > m.bottom)
+                m.bottom = g.yOffset + g.height;
+        }
+        return m;
+    }
+
+    constexpr int16_t textWidth(const GFXglyph *glyphs, uint16_t first, const char *text)
+    {
+        int16_t width = 0;
+        for (const char *c = text; *c; c++)
+        {
+            width += glyphs[(uint8_t)*c - first].xAdvance;
+        }
+        return width;
+    }
+
+    enum class Align
+    {
+        Left,
+        Center,
+        Right
+    };
+
+    constexpr int16_t align(Align a, int16_t start, int16_t space, int16_t size)
+    {
+        return a == Align::Left ? start : a == Align::Center ? start + (space - size) / 2 : start + space - size;
+    }
+
+    // Cursor position for a text field and the box that covers anything it can show
+    struct TextSlot
+    {
+        int16_t x;
+        int16_t baseline;
+        Box box;
+    };
+
+    constexpr TextSlot textSlot(const FontMetrics &f, int16_t x, int16_t baseline, int16_t width)
+    {
+        return {x, baseline, {x, (int16_t)(baseline + f.top), width, (int16_t)(f.bottom - f.top)}};
+    }
+
+    // Fonts
+    constexpr const char *DSEG_CHARSET = "0123456789:ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    constexpr FontMetrics DSEG = measure(DSEG14ModernMini_Bold18pt7bGlyphs, 0x20, DSEG_CHARSET);
+
+    // FreeMonoBold12pt7b ships with Adafruit_GFX as plain `const` data, so it
+    // can't be read at compile time. These figures mirror its table for
+    // MONO_CHARSET; test_layout fails if they stop matching it.
+    constexpr const char *MONO_CHARSET = "0123456789.-%?ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    constexpr FontMetrics MONO = {14, -15, 4};
+
+    // Classic built-in 5x7 font, drawn downward from the cursor in a 6x8 cell
+    constexpr int16_t CLASSIC_W = 5;
+    constexpr int16_t CLASSIC_H = 8;
+
+    // Frame
+    constexpr int16_t BORDER_OFFSET = 3;
+    constexpr Box BORDER = {0, BORDER_OFFSET, SCREEN_WIDTH, SCREEN_HEIGHT - BORDER_OFFSET};
+    constexpr Box INTERIOR = {BORDER.x + 1, BORDER.y + 1, BORDER.w - 2, BORDER.h - 2};
+
+    // Time & weather screen
+    constexpr TextSlot TIME = textSlot(DSEG, BORDER_OFFSET, 55,
+                                       textWidth(DSEG14ModernMini_Bold18pt7bGlyphs, 0x20, "88:88"));
+    constexpr TextSlot TEMPERATURE = textSlot(MONO, BORDER_OFFSET, 85, 6 * MONO.advance); // "-10.5C"
+    constexpr TextSlot HUMIDITY = textSlot(MONO, BORDER_OFFSET, 105, 4 * MONO.advance);   // "100%"
+
+    // Flight screen
+    constexpr TextSlot AIRPORT = textSlot(DSEG, BORDER_OFFSET, 55, 4 * DSEG.advance);
+    constexpr TextSlot AIRCRAFT = textSlot(MONO, 5, 85, 8 * MONO.advance);
+    constexpr TextSlot FLIGHT_NUMBER = textSlot(MONO, 5, 105, 8 * MONO.advance);
+
+    // Error and setup screens (classic font, cursor is the top-left corner)
+    constexpr int16_t ERROR_X = BORDER_OFFSET;
+    constexpr int16_t ERROR_Y = 50;
+    constexpr int16_t AP_INFO_Y = 10;
+
+    // WiFi icon, top right
+    constexpr int16_t WIFI_ICON_WIDTH = 22;
+    constexpr int16_t WIFI_ICON_HEIGHT = 8;
+    constexpr int16_t WIFI_BAR_WIDTH = 2;
+    constexpr int16_t WIFI_BAR_SPACING = 2;
+    constexpr int WIFI_BAR_COUNT = 4;
+    constexpr Box WIFI_ICON = {SCREEN_WIDTH - WIFI_ICON_WIDTH, 5, WIFI_ICON_WIDTH, WIFI_ICON_HEIGHT};
+    constexpr int16_t WIFI_BARS_WIDTH = WIFI_BAR_COUNT * WIFI_BAR_WIDTH + (WIFI_BAR_COUNT - 1) * WIFI_BAR_SPACING;
+    constexpr int16_t WIFI_BARS_X = align(Align::Center, WIFI_ICON.x, WIFI_ICON.w, WIFI_BARS_WIDTH);
+
+    // Bar i (0 = weakest) grows 2 px per step, bottom aligned in the icon
+    constexpr Box wifiBar(int i)
+    {
+        return {(int16_t)(WIFI_BARS_X + i * (WIFI_BAR_WIDTH + WIFI_BAR_SPACING)),
+                (int16_t)(WIFI_ICON.bottom() + 1 - (i + 1) * 2), WIFI_BAR_WIDTH, (int16_t)((i + 1) * 2)};
+    }
+
+    constexpr Box WIFI_OFFLINE_MARK = {align(Align::Center, WIFI_ICON.x, WIFI_ICON.w, CLASSIC_W),
+                                       align(Align::Center, WIFI_ICON.y, WIFI_ICON.h, CLASSIC_H),
+                                       CLASSIC_W, CLASSIC_H};
+
+    // Debug overlay: classic font lines along the bottom of the frame, under
+    // the lowest row of either screen
+    constexpr int OVERLAY_LINES = 2;
+    constexpr Box OVERLAY = {INTERIOR.x, (int16_t)(INTERIOR.bottom() + 1 - OVERLAY_LINES * CLASSIC_H), INTERIOR.w,
+                             (int16_t)(OVERLAY_LINES * CLASSIC_H)};
+    constexpr int OVERLAY_CHARS = OVERLAY.w / (CLASSIC_W + 1);
+
+    constexpr Box overlayLine(int i)
+    {
+        return {OVERLAY.x, (int16_t)(OVERLAY.y + i * CLASSIC_H), OVERLAY.w, CLASSIC_H};
+    }
+
+    // Runtime check for fonts whose tables aren't constexpr (see test_layout)
+    inline bool fontFits(const GFXfont &font, const FontMetrics &m, const char *charset)
+    {
+        for (const char *c = charset; *c; c++)
+        {
+            const GFXglyph &g = font.glyph[(uint8_t)*c - font.first];
+            if (g.xOffset + g.width > m.advance || g.yOffset < m.top || g.yOffset + g.height > m.bottom)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(DSEG.advance > 0 && DSEG.top < 0, "DSEG metrics not resolved");
+    static_assert(INTERIOR.contains(TIME.box), "time field crosses the border");
+    static_assert(INTERIOR.contains(TEMPERATURE.box), "temperature field crosses the border");
+    static_assert(INTERIOR.contains(HUMIDITY.box), "humidity field crosses the border");
+    static_assert(INTERIOR.contains(AIRPORT.box), "airport field crosses the border");
+    static_assert(INTERIOR.contains(AIRCRAFT.box), "aircraft field crosses the border");
+    static_assert(INTERIOR.contains(FLIGHT_NUMBER.box), "flight number field crosses the border");
+    static_assert(TIME.box.above(TEMPERATURE.box) && TEMPERATURE.box.above(HUMIDITY.box),
+                  "time/weather rows overlap");
+    static_assert(AIRPORT.box.above(AIRCRAFT.box) && AIRCRAFT.box.above(FLIGHT_NUMBER.box),
+                  "flight rows overlap");
+    static_assert(WIFI_ICON.y > BORDER.y && WIFI_ICON.above(TIME.box) && WIFI_ICON.above(AIRPORT.box),
+                  "WiFi icon overlaps the border or the top row");
+    static_assert(INTERIOR.contains(wifiBar(0)) && INTERIOR.contains(wifiBar(WIFI_BAR_COUNT - 1)),
+                  "WiFi bars cross the border");
+    static_assert(WIFI_ICON.contains(wifiBar(WIFI_BAR_COUNT - 1)) && WIFI_ICON.contains(WIFI_OFFLINE_MARK),
+                  "WiFi icon contents don't fit the icon");
+    static_assert(INTERIOR.contains(OVERLAY), "overlay crosses the border");
+    static_assert(HUMIDITY.box.above(OVERLAY) && FLIGHT_NUMBER.box.above(OVERLAY), "overlay overlaps the bottom row");
+    static_assert(OVERLAY_CHARS >= 21, "overlay lines too narrow");
+}
+
+#endif // LAYOUT_H
@@ -0,0 +1,38 @@
+#ifndef METRICS_PAGE_H
+#define METRICS_PAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Renders the /metrics page in the Prometheus text format (0.0.4) straight
+// into a caller's buffer: no String, no heap, one pass. Lines are written
+// whole or not at all, so a page cut short by the buffer still parses.
+//
+// Fetch counts and latencies are read from FetchMetrics and log counters
+// from Log; everything only the platform can measure comes in through
+// System, so the page renders the same on the host.
+class MetricsPage
+{
+public:
+    struct System
+    {
+        uint32_t uptimeS;
+        uint32_t freeHeap;     // bytes
+        uint32_t largestBlock; // bytes
+        uint32_t minFreeHeap;  // bytes
+        bool connected;
+        int32_t rssi;          // dBm, only meaningful when connected
+        uint32_t fastConnects; // cached BSSID/channel/lease
+        uint32_t fullConnects; // scan + DHCP
+        uint32_t fastMisses;
+        uint32_t frames;
+        uint32_t pixels;
+        uint32_t busBytes;
+    };
+
+    // Returns the length written; *complete (if given) is false when lines
+    // had to be dropped to fit.
+    static size_t format(char *buffer, size_t size, const System &sys, bool *complete = nullptr);
+};
+
+#endif // METRICS_PAGE_H
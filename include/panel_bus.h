@@ -0,0 +1,133 @@
+#ifndef PANEL_BUS_H
+#define PANEL_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Byte-level transport used by St77xxPanel. The panel decides *what* to send
+// (commands, windows, pixel runs); the bus only knows how to move bytes and
+// toggle the data/command line.
+class PanelBus
+{
+public:
+    virtual ~PanelBus() {}
+
+    virtual void begin() = 0;
+    virtual void hardwareReset() {}
+    virtual void beginTransaction() = 0;
+    virtual void endTransaction() = 0;
+    virtual void writeCommand(uint8_t cmd) = 0;
+    virtual void writeData(const uint8_t *data, size_t len) = 0;
+    // Pixels are passed in native byte order and sent MSB first
+    virtual void writePixels(const uint16_t *pixels, size_t count) = 0;
+    // Send the same pixel `count` times as a single burst
+    virtual void writeRepeat(uint16_t color, uint32_t count) = 0;
+    virtual void delayMs(uint32_t ms) = 0;
+    // Latch CS/DC/RST at their current level through deep sleep (or release them)
+    virtual void holdPins(bool hold) { (void)hold; }
+};
+
+#ifdef ARDUINO
+#include <SPI.h>
+
+// Hardware SPI transport with manually driven CS/DC/RST lines
+class SpiPanelBus : public PanelBus
+{
+public:
+    SpiPanelBus(SPIClass &spi, int8_t cs, int8_t dc, int8_t rst, uint32_t freq);
+
+    void begin() override;
+    void hardwareReset() override;
+    void beginTransaction() override;
+    void endTransaction() override;
+    void writeCommand(uint8_t cmd) override;
+    void writeData(const uint8_t *data, size_t len) override;
+    void writePixels(const uint16_t *pixels, size_t count) override;
+    void writeRepeat(uint16_t color, uint32_t count) override;
+    void delayMs(uint32_t ms) override;
+    void holdPins(bool hold) override;
+
+    // Bytes clocked out since boot, commands included
+    uint32_t bytesSent() const { return sent; }
+
+private:
+    SPIClass &spi;
+    int8_t csPin;
+    int8_t dcPin;
+    int8_t rstPin;
+    SPISettings settings;
+    uint32_t sent;
+};
+#endif
+
+// One entry of the recorded command stream
+struct PanelBusEvent
+{
+    enum Type : uint8_t
+    {
+        BEGIN,
+        END,
+        COMMAND,
+        DATA,
+        PIXELS,
+        REPEAT,
+        DELAY
+    };
+
+    Type type;
+    uint8_t value;  // command byte for COMMAND, first data byte for DATA
+    uint32_t count; // bytes for DATA, pixels for PIXELS/REPEAT, ms for DELAY
+};
+
+// Recording transport: keeps the command stream in a fixed buffer and
+// aggregate counters, optionally forwarding everything to a real bus. Used
+// on the host to verify batching, and on the device to measure bus traffic.
+class TracePanelBus : public PanelBus
+{
+public:
+    struct Totals
+    {
+        uint32_t transactions;
+        uint32_t commands;
+        uint32_t dataBytes;   // parameter bytes, excluding pixels
+        uint32_t pixelBytes;  // bytes of pixel data on the wire
+        uint32_t bursts;      // individual writePixels/writeRepeat calls
+        uint32_t dcToggles;   // command <-> data switches
+    };
+
+    static const size_t MAX_EVENTS = 256;
+
+    explicit TracePanelBus(PanelBus *forward = nullptr);
+
+    void begin() override;
+    void hardwareReset() override;
+    void beginTransaction() override;
+    void endTransaction() override;
+    void writeCommand(uint8_t cmd) override;
+    void writeData(const uint8_t *data, size_t len) override;
+    void writePixels(const uint16_t *pixels, size_t count) override;
+    void writeRepeat(uint16_t color, uint32_t count) override;
+    void delayMs(uint32_t ms) override;
+    void holdPins(bool hold) override;
+
+    void clear();
+    const Totals &totals() const { return sums; }
+    size_t eventCount() const { return used; }
+    size_t droppedEvents() const { return dropped; }
+    const PanelBusEvent &event(size_t i) const { return events[i]; }
+    // Bytes that would cross the wire, commands included
+    uint32_t wireBytes() const { return sums.commands + sums.dataBytes + sums.pixelBytes; }
+
+private:
+    void record(PanelBusEvent::Type type, uint8_t value, uint32_t count);
+    void noteMode(bool isData);
+
+    PanelBus *next;
+    PanelBusEvent events[MAX_EVENTS];
+    size_t used;
+    size_t dropped;
+    Totals sums;
+    bool lastWasData;
+};
+
+#endif // PANEL_BUS_H
@@ -0,0 +1,81 @@
+#ifndef POWER_SCHEDULER_H
+#define POWER_SCHEDULER_H
+
+#include <stdint.h>
+#include "flight_record.h"
+
+// Decides how loop() waits for its next deadline. By day it idles on the
+// task notification with the radio in modem sleep, so WiFi events still wake
+// it. At night, when the next deadline is far enough away, it sleeps with
+// the radio off: deep sleep while the panel is dark, waking just ahead of
+// the deadline with the state needed to carry on in RTC memory; light sleep
+// while the panel is lit (always-on policy, or a flight on screen), since
+// rebooting for every clock minute would cost more than it saves.
+//
+// decide() is a pure function of its inputs so the policy can be driven
+// with virtual time on the host.
+class PowerScheduler
+{
+public:
+    // Sleep below this isn't worth the reboot (~0.3 s plus redraw) or,
+    // for light sleep, bringing the radio back up for the next fetch
+    static const unsigned long MIN_DEEP_SLEEP_MS = 5000;
+    // Wake this early so boot and redraw land on the deadline
+    static const unsigned long WAKE_LEAD_MS = 700;
+
+    enum Action
+    {
+        IDLE,        // block on the loop task notification, radio in modem sleep
+        LIGHT_SLEEP, // CPU paused with RAM kept, radio off; the panel shows on
+        DEEP_SLEEP   // everything off except the RTC and the held panel lines
+    };
+
+    struct Inputs
+    {
+        bool night;
+        bool errorShown;         // keep an error screen live and reachable
+        bool radioBusy;          // connecting or serving the config portal
+        bool panelLit;           // panel awake: its picture has to keep up
+        unsigned long idleMs;    // until the next loop deadline
+    };
+
+    struct Decision
+    {
+        Action action;
+        unsigned long sleepMs;
+    };
+
+    // State carried through deep sleep (RTC slow memory, plain data only)
+    struct Retained
+    {
+        uint32_t magic;
+        uint32_t deepSleeps;
+        uint32_t sleptMs;       // length of the last deep sleep
+        uint32_t flightAgeMs;   // time since the last fetch when going down
+        uint32_t weatherAgeMs;
+        bool panelAsleep;       // panel left in SLPIN
+        uint8_t wifiFailures;   // WiFiLink backoff level
+        FlightRecord flight;    // last flight shown (available = false if none)
+        char temperature[16];
+        char humidity[16];
+    };
+
+    static Decision decide(const Inputs &in);
+
+    // True when this boot is a wake from our own deep sleep with valid state
+    static bool begin();
+    static bool resumed() { return wasResumed; }
+    static Retained &retained();
+
+    // Stores nothing itself: fill retained() first. Doesn't return.
+    static void deepSleep(unsigned long ms);
+    // Returns when the timer fires; park the radio first
+    static void lightSleep(unsigned long ms);
+    static uint32_t lightSleeps() { return lightSleepCount; }
+
+private:
+    static bool wasResumed;
+    static uint32_t lightSleepCount;
+};
+
+#endif // POWER_SCHEDULER_H
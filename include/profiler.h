@@ -0,0 +1,94 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Scoped profiling zones. FT_PROFILE_ZONE("name") times the rest of the
+// enclosing scope and adds it to that zone's calls, total and max in a
+// static table; formatReport() lists the zones by total time. Built with
+// FT_PROFILE (see [env:profile] in platformio.ini); without it zones
+// compile to nothing.
+//
+//   void DisplayManager::drawField(...)
+//   {
+//       FT_PROFILE_ZONE("draw field");
+//       ...
+//
+// On the device the clock is the CPU cycle counter, scaled by the clock the
+// governor has set (CpuGovernor calls clockChanged()), so a zone costs two
+// counter reads and a multiply. The host uses clock_gettime(). Times are
+// elapsed time on the calling task: blocking and preemption count, and
+// nested zones are included in their parents. Zones are for the loop task;
+// each update takes a StatsLock, so formatReport() can run on another task
+// (/diag) without reading a half-written 64-bit total.
+
+#ifdef FT_PROFILE
+#define FT_PROFILE_CONCAT_(a, b) a##b
+#define FT_PROFILE_CONCAT(a, b) FT_PROFILE_CONCAT_(a, b)
+#define FT_PROFILE_ZONE(name)                                                \
+    static Profiler::Zone FT_PROFILE_CONCAT(profileZone, __LINE__)(name);    \
+    Profiler::Scope FT_PROFILE_CONCAT(profileScope, __LINE__)(FT_PROFILE_CONCAT(profileZone, __LINE__))
+#else
+#define FT_PROFILE_ZONE(name) \
+    do                        \
+    {                         \
+    } while (0)
+#endif
+
+class Profiler
+{
+public:
+    static const uint8_t MAX_ZONES = 32;
+
+    // Constant-initialized, so a zone static costs no guard check; it joins
+    // the table the first time it is timed
+    struct Zone
+    {
+        constexpr explicit Zone(const char *zoneName)
+            : name(zoneName), calls(0), totalNs(0), maxNs(0), listed(false) {}
+
+        const char *name;
+        uint32_t calls;
+        uint64_t totalNs;
+        uint32_t maxNs;
+        bool listed;
+    };
+
+#ifdef FT_PROFILE
+    class Scope
+    {
+    public:
+        explicit Scope(Zone &zone) : zone(zone), start(now()) {}
+        ~Scope() { record(zone, now() - start); }
+
+    private:
+        Zone &zone;
+        uint64_t start;
+    };
+
+    // Nanoseconds on a private time base; only differences mean anything
+    static uint64_t now();
+    // The CPU clock is about to change (or just did); the cycle count so
+    // far is converted at the old rate
+    static void clockChanged(uint32_t mhz);
+    static void record(Zone &zone, uint64_t ns);
+    // Zero every zone and restart the report window
+    static void reset();
+
+    static uint8_t zoneCount();
+    static const Zone &zone(uint8_t index);
+    // Zones that didn't fit in the table
+    static uint32_t unlisted();
+
+    // Plain text report into `buffer`, truncated to fit. Returns the length.
+    static size_t formatReport(char *buffer, size_t size);
+#else
+    static void clockChanged(uint32_t) {}
+    static void reset() {}
+    static uint8_t zoneCount() { return 0; }
+    static size_t formatReport(char *, size_t) { return 0; }
+#endif
+};
+
+#endif // PROFILER_H
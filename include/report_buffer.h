@@ -0,0 +1,12 @@
+#ifndef REPORT_BUFFER_H
+#define REPORT_BUFFER_H
+
+#include <stddef.h>
+
+// Text reports (/diag, console commands) are built by appending to one
+// caller-owned buffer. snprintf at buffer + len, keeping len clamped so the
+// buffer stays terminated and later appends do nothing once it's full.
+// Returns false if this append was cut short or dropped.
+bool appendf(char *buffer, size_t size, size_t &len, const char *format, ...) __attribute__((format(printf, 4, 5)));
+
+#endif // REPORT_BUFFER_H
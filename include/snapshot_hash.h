@@ -0,0 +1,84 @@
+#ifndef SNAPSHOT_HASH_H
+#define SNAPSHOT_HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 64-bit FNV-1a over the fields a snapshot puts on screen. Feed the fields
+// one after another; add() includes the terminator so "AB"+"C" and "A"+"BC"
+// hash differently.
+class SnapshotHash
+{
+public:
+    SnapshotHash() : value(OFFSET_BASIS) {}
+
+    SnapshotHash &add(const char *text)
+    {
+        do
+        {
+            mix((uint8_t)*text);
+        } while (*text++);
+        return *this;
+    }
+
+    SnapshotHash &add(uint32_t number)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            mix((uint8_t)(number >> (8 * i)));
+        }
+        return *this;
+    }
+
+    uint64_t result() const { return value; }
+
+private:
+    static const uint64_t OFFSET_BASIS = 0xcbf29ce484222325ULL;
+    static const uint64_t PRIME = 0x100000001b3ULL;
+
+    void mix(uint8_t b)
+    {
+        value ^= b;
+        value *= PRIME;
+    }
+
+    uint64_t value;
+};
+
+// Lets a snapshot through only when its hash differs from the last one
+// that was rendered, and counts both outcomes
+class SnapshotGate
+{
+public:
+    SnapshotGate() : last(0), primed(false), applied(0), suppressed(0) {}
+
+    bool changed(uint64_t hash)
+    {
+        if (primed && hash == last)
+        {
+            suppressed++;
+            return false;
+        }
+        last = hash;
+        primed = true;
+        applied++;
+        return true;
+    }
+
+    // Replace the stored hash without counting, for when rendering itself
+    // changed an input (e.g. the screen epoch)
+    void settle(uint64_t hash) { last = hash; }
+    // Forget the last hash so the next snapshot is always applied
+    void invalidate() { primed = false; }
+
+    uint32_t appliedCount() const { return applied; }
+    uint32_t suppressedCount() const { return suppressed; }
+
+private:
+    uint64_t last;
+    bool primed;
+    uint32_t applied;
+    uint32_t suppressed;
+};
+
+#endif // SNAPSHOT_HASH_H
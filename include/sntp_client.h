@@ -0,0 +1,122 @@
+#ifndef SNTP_CLIENT_H
+#define SNTP_CLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// What SntpClient needs from the platform. TimeSync implements it with
+// WiFiUDP and the system clock; a host test runs it against a local server.
+// None of these may block for long.
+class SntpDriver
+{
+public:
+    virtual ~SntpDriver() {}
+
+    virtual bool open() = 0;
+    virtual void close() = 0;
+    virtual bool send(uint8_t server, const uint8_t *packet, size_t len) = 0;
+    // One pending datagram, 0 if none. `server` is set to its sender.
+    virtual size_t receive(uint8_t *packet, size_t size, uint8_t &server) = 0;
+    // System wall clock, microseconds since 1970
+    virtual int64_t nowUs() = 0;
+    // Correct the system clock by deltaUs, at once or gradually
+    virtual void adjust(int64_t deltaUs, bool step) = 0;
+};
+
+// One usable reply
+struct SntpSample
+{
+    int64_t offsetUs; // true time - local time
+    int64_t delayUs;  // round trip minus server processing; error <= delay / 2
+    uint8_t server;
+    uint8_t stratum;
+};
+
+// SNTP (RFC 4330) client that queries every server at once. While the
+// clock has never been set the first valid reply wins; after that replies
+// are collected for SELECT_WINDOW and the one with the shortest round trip
+// is used.
+//
+// Each sync also measures how far the clock drifted since the previous one.
+// The estimated drift is corrected in small slews between syncs, and the
+// resync interval is stretched until the drift left over would reach
+// TARGET_ERROR_US (between MIN_INTERVAL and MAX_INTERVAL).
+class SntpClient
+{
+public:
+    static const uint8_t MAX_SERVERS = 4;
+    static const size_t PACKET_SIZE = 48;
+    static const unsigned long QUERY_TIMEOUT = 2000;   // ms
+    static const unsigned long SELECT_WINDOW = 300;    // ms after the first reply
+    static const unsigned long RETRY_UNSYNCED = 10000; // ms between failed queries
+    static const unsigned long RETRY_SYNCED = 60000;
+    static const uint32_t MIN_INTERVAL = 900;          // s
+    static const uint32_t MAX_INTERVAL = 86400;        // s
+    static const uint32_t MIN_DRIFT_SPAN = 600;        // s between syncs to measure drift
+    static const int64_t TARGET_ERROR_US = 50000;
+    static const int64_t STEP_THRESHOLD_US = 128000;   // larger offsets step, smaller ones slew
+    static const int64_t COMPENSATE_STEP_US = 10000;   // smallest drift correction applied
+
+    // Plain data, kept in RTC memory through deep sleep (all zero = never synced)
+    struct Retained
+    {
+        bool synced;
+        bool driftKnown;
+        int64_t lastSyncUs;         // system clock when the last offset was applied
+        int64_t lastCompensationUs;
+        int64_t compensatedUs;      // drift corrections since the last sync
+        int64_t lastOffsetUs;
+        int64_t lastDelayUs;
+        float driftPpm;             // positive: the clock runs fast
+        uint32_t intervalS;
+        uint32_t syncs;
+        uint32_t failures;
+    };
+
+    SntpClient(SntpDriver &driver, Retained &state);
+
+    void setServerCount(uint8_t count);
+    // Query now, whether or not one is due
+    void request(unsigned long nowMs);
+    // Drive a running query, apply drift correction, and start a query when
+    // one is due and `online`
+    void update(unsigned long nowMs, bool online);
+    unsigned long millisUntilNextStep(unsigned long nowMs, bool online);
+
+    bool isQuerying() const { return querying; }
+    bool isSynced() const { return state.synced; }
+    const Retained &stats() const { return state; }
+
+    // NTP era 0 (1900-2036) timestamps, 32.32 fixed point
+    static uint64_t toNtp(int64_t unixUs);
+    static int64_t fromNtp(uint64_t ntp);
+    static void buildRequest(uint8_t *packet, uint64_t transmit);
+    // t1Us/t4Us: local send and receive times. False for anything that isn't
+    // a valid server reply to the request stamped `originate`.
+    static bool parseReply(const uint8_t *packet, size_t len, uint64_t originate, int64_t t1Us, int64_t t4Us,
+                           SntpSample &out);
+
+private:
+    void startQuery(unsigned long nowMs);
+    void finishQuery(unsigned long nowMs);
+    void apply(const SntpSample &sample);
+    void compensate();
+    bool due(unsigned long nowMs);
+
+    SntpDriver &driver;
+    Retained &state;
+    uint8_t serverCount;
+    bool querying;
+    bool attempted;      // a query has run since boot
+    bool lastFailed;
+    unsigned long queryStart;
+    unsigned long lastAttempt;
+    unsigned long firstReply;
+    uint8_t replies;
+    bool haveBest;
+    SntpSample best;
+    int64_t sentUs[MAX_SERVERS];
+    uint64_t sentNtp[MAX_SERVERS];
+};
+
+#endif // SNTP_CLIENT_H
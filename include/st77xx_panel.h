@@ -0,0 +1,124 @@
+#ifndef ST77XX_PANEL_H
+#define ST77XX_PANEL_H
+
+#include <Adafruit_GFX.h>
+#include "panel_bus.h"
+
+// Colours used by the UI (RGB565, same values as the Adafruit ST77xx library)
+#ifndef ST77XX_BLACK
+#define ST77XX_BLACK 0x0000
+#define ST77XX_WHITE 0xFFFF
+#define ST77XX_RED 0xF800
+#define ST77XX_GREEN 0x07E0
+#define ST77XX_BLUE 0x001F
+#define ST77XX_CYAN 0x07FF
+#define ST77XX_MAGENTA 0xF81F
+#define ST77XX_YELLOW 0xFFE0
+#define ST77XX_ORANGE 0xFC00
+#endif
+
+// Lean ST7735R driver. Drop-in for Adafruit_ST7735 as far as DisplayManager
+// is concerned (it is an Adafruit_GFX), but it:
+//  - keeps one SPI transaction open for a whole beginFrame()/endFrame() batch
+//  - only resends CASET/RASET when the column/row range actually changes
+//  - streams adjacent pixels into the open RAM window without a new window
+//  - sends solid runs as repeated-pixel bursts instead of pixel-by-pixel
+class St77xxPanel : public Adafruit_GFX
+{
+public:
+    struct Stats
+    {
+        uint32_t frames;
+        uint32_t windowSets;  // CASET/RASET commands actually sent
+        uint32_t windowSkips; // CASET/RASET omitted because unchanged
+        uint32_t streamed;    // pixels appended to an already open window
+        uint32_t pixels;      // pixels pushed in total
+    };
+
+    St77xxPanel(PanelBus &bus, int16_t w, int16_t h, uint8_t colStart, uint8_t rowStart);
+
+    // Hardware reset and the 7735R green tab init sequence, in one transaction
+    void begin();
+    // Deep sleep keeps the panel powered and configured: latch the control
+    // lines on the way down, and on wake take the bus back without a reset
+    void prepareDeepSleep();
+    void resumeFromDeepSleep(bool panelAsleep);
+
+    // Panel sleep: display off and SLPIN. Frame memory is kept, so after
+    // wake() (SLPOUT, 120 ms) the old picture is still there; update what
+    // changed, then setDisplayOn(true).
+    void sleep();
+    void wake();
+    void setDisplayOn(bool on);
+    bool isAsleep() const { return asleep; }
+
+    // With batching off every primitive sets its own window and transaction,
+    // exactly like the generic Adafruit_SPITFT path. Used for A/B benchmarks.
+    void setBatching(bool enabled);
+    bool isBatching() const { return batching; }
+
+    // Group everything drawn until the matching endFrame() into one bus
+    // transaction. Frames nest; only the outermost pair counts.
+    void beginFrame();
+    void endFrame();
+    bool inFrame() const { return frameDepth != 0; }
+
+    void sendCommand(uint8_t cmd, const uint8_t *args = nullptr, uint8_t numArgs = 0);
+    void setAddrWindow(int16_t x, int16_t y, int16_t w, int16_t h);
+    // Stream pixels into the window set by setAddrWindow()
+    void pushPixels(const uint16_t *pixels, uint32_t count);
+
+    const Stats &stats() const { return counters; }
+    void resetStats();
+
+    // Adafruit_GFX overrides
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void startWrite() override;
+    void endWrite() override;
+    void writePixel(int16_t x, int16_t y, uint16_t color) override;
+    void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void fillScreen(uint16_t color) override;
+    void invertDisplay(bool invert) override;
+
+private:
+    static const uint8_t LINE_PIXELS = 32;
+    static const uint8_t MIN_REPEAT_RUN = 4;
+
+    void runCommandList(const uint8_t *list);
+    void openWindow(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+    void queuePixel(uint16_t color);
+    void flushRun();
+    void flushLine();
+    void flushPixels();
+    bool clip(int16_t &x, int16_t &y, int16_t &w, int16_t &h) const;
+
+    PanelBus &bus;
+    uint8_t colStart;
+    uint8_t rowStart;
+    bool batching;
+    uint8_t writeDepth;
+    uint8_t frameDepth;
+
+    // Window currently programmed into the controller (-1 = unknown)
+    int16_t winX0, winX1, winY0, winY1;
+    // In SLPIN; frame memory kept, no RAM writes until wake()
+    bool asleep;
+    // Next pixel position of the open RAMWR stream
+    bool streaming;
+    int16_t streamX, streamY;
+
+    // Pending output: a run of identical pixels and a small line buffer
+    uint16_t runColor;
+    uint32_t runLength;
+    uint16_t line[LINE_PIXELS];
+    uint8_t lineUsed;
+
+    Stats counters;
+};
+
+#endif // ST77XX_PANEL_H
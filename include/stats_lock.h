@@ -0,0 +1,24 @@
+#ifndef STATS_LOCK_H
+#define STATS_LOCK_H
+
+// Counters that loop() updates and the diag task reads for /diag and
+// /metrics. Both sides hold a StatsLock while they copy, so a report never
+// sees a half-written value: a 64-bit total on this 32-bit core, or a
+// histogram between its count and its sum. One spinlock for all of them;
+// hold it to copy, never to format or log.
+class StatsLock
+{
+public:
+#ifdef ARDUINO
+    StatsLock();
+    ~StatsLock();
+#else
+    // Only loop() runs on the host
+    StatsLock() {}
+    ~StatsLock() {}
+#endif
+    StatsLock(const StatsLock &) = delete;
+    StatsLock &operator=(const StatsLock &) = delete;
+};
+
+#endif // STATS_LOCK_H
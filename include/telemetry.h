@@ -0,0 +1,61 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Memory and stack telemetry kept in a fixed ring. loop() calls sample()
+// every SAMPLE_INTERVAL; the serial console ("telemetry") and the /diag
+// endpoint both print formatReport(), which ends in CSV rows so logs from
+// several devices can be lined up against fetch failures and resets.
+class Telemetry
+{
+public:
+    static const unsigned long SAMPLE_INTERVAL = 60000; // 1 minute
+    static const uint8_t CAPACITY = 60;                 // one hour of samples
+    static const uint8_t TASK_COUNT = 6;
+
+    struct Sample
+    {
+        uint32_t uptime;       // seconds
+        uint32_t freeHeap;     // bytes
+        uint32_t largestBlock; // largest allocatable block, bytes
+        uint32_t minFreeHeap;  // lowest free heap since boot, bytes
+        uint16_t stackFree[TASK_COUNT]; // high-water marks, bytes (0 = task not found)
+        uint16_t fetchFailures;         // since boot
+    };
+
+    // Record the reset reason; call once at boot
+    static void begin();
+    static bool sampleDue(unsigned long now);
+    static unsigned long millisUntilSample(unsigned long now);
+    // Read heap and stack figures from the system and record them (the host
+    // has none: its samples only carry uptime and fetch failures)
+    static void sample(unsigned long now);
+    // Store a sample taken elsewhere (host builds, tests)
+    static void record(const Sample &s);
+
+    static void noteFetch(bool ok);
+
+    // Plain text report into `buffer`, truncated to fit. Returns the length.
+    static size_t formatReport(char *buffer, size_t size);
+
+    static uint8_t count() { return used; }
+    // 0 = oldest
+    static const Sample &at(uint8_t index);
+    static const char *taskName(uint8_t index) { return TASK_NAMES[index]; }
+
+private:
+    static const char *const TASK_NAMES[TASK_COUNT];
+
+    static Sample ring[CAPACITY];
+    static uint8_t head;
+    static uint8_t used;
+    static unsigned long lastSample;
+    static bool sampled;
+    static uint32_t fetchOk;
+    static uint32_t fetchFailed;
+    static const char *resetReason;
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,50 @@
+#ifndef TIME_SERVICE_H
+#define TIME_SERVICE_H
+
+#include <time.h>
+
+// Local wall-clock time with the expensive parts done once. The zone is
+// applied in begin(); after that update() only compares the current epoch
+// against the cached minute, and advances the cached "HH:MM" by one minute
+// in place when it rolls over. localtime_r() only runs again on a clock
+// step, a DST transition or a gap longer than a minute.
+class TimeService
+{
+public:
+    static void begin(const char *posixTz);
+
+    // Call once per tick. Returns true when the local minute changed.
+    static bool update();
+    // Force a full recompute on the next update(), e.g. after an NTP step
+    static void invalidate();
+    static const char *zone() { return posixZone; }
+    // False until the clock has been set (SNTP or kept by the RTC)
+    static bool isSet() { return minuteStart > VALID_EPOCH; }
+
+    static const char *timeString() { return text; } // "HH:MM"
+    static int hour() { return localHour; }
+    static int minute() { return localMinute; }
+    // Monotonic minute counter (epoch / 60), handy as a change stamp
+    static time_t minuteStamp() { return minuteStart / 60; }
+    static time_t nextMinuteEpoch() { return minuteStart + 60; }
+    static time_t nextDstTransition() { return nextTransition; }
+    static unsigned long millisUntilNextMinute();
+
+private:
+    static const time_t VALID_EPOCH = 1577836800; // 2020-01-01
+
+    static void recompute(time_t now);
+    static void advanceOneMinute();
+    static void format();
+    static time_t findNextTransition(time_t from);
+
+    static const char *posixZone;
+    static char text[6];
+    static int localHour;
+    static int localMinute;
+    static time_t minuteStart;
+    static time_t nextTransition;
+    static bool valid;
+};
+
+#endif // TIME_SERVICE_H
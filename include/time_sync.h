@@ -0,0 +1,30 @@
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stddef.h>
+#include "sntp_client.h"
+
+// Keeps the system clock set from NTP with SntpClient, over WiFiUDP. The
+// servers are queried in parallel; sync state, drift and the resync
+// interval live in RTC memory so they carry through the night deep sleep.
+class TimeSync
+{
+public:
+    static void begin();
+    // Query now (WiFi just came up)
+    static void request();
+    // Call on every loop wake
+    static void update();
+    static unsigned long millisUntilNextStep();
+    static bool isQuerying();
+    // Set by NTP since power-on (the clock itself may be kept by the RTC)
+    static bool isSynced();
+    // For loop() only
+    static const SntpClient::Retained &stats();
+
+    // Plain text report into `buffer`, truncated to fit. Returns the length.
+    // Safe from other tasks: reads the state as of the last update().
+    static size_t formatReport(char *buffer, size_t size);
+};
+
+#endif // TIME_SYNC_H
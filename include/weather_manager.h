@@ -2,15 +2,27 @@
 #define WEATHER_MANAGER_H
 
 #include <ArduinoJson.h>
-#include <HTTPClient.h>
+#include "http_fetch.h"
+#include "snapshot_hash.h"
 
 class WeatherManager
 {
 public:
     static bool fetchData();
+    static const SnapshotGate &snapshots() { return gate; }
+    // Store a reading and hand it to the display; main keeps the last one
+    // through deep sleep and re-applies it on wake
+    static void apply(const char *temperature, const char *humidity);
+    static const char *temperature() { return lastTemperature; }
+    static const char *humidity() { return lastHumidity; }
+    // Filter for deserializeJson(): the two current readings
+    static void buildFilter(JsonDocument &filter);
 
 private:
-    static HTTPClient httpClient;
+    static HttpFetch http;
+    static SnapshotGate gate;
+    static char lastTemperature[16];
+    static char lastHumidity[16];
 };
 
 #endif // WEATHER_MANAGER_H
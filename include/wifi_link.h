@@ -0,0 +1,100 @@
+#ifndef WIFI_LINK_H
+#define WIFI_LINK_H
+
+#include <stdint.h>
+
+// What WiFiLink needs from the radio. FtWiFiManager implements it on top of
+// WiFi/WiFiManager; a simulated driver runs the same state machine on the
+// host. None of these may block.
+class WiFiDriver
+{
+public:
+    virtual ~WiFiDriver() {}
+
+    virtual bool hasCredentials() = 0;
+    // Start associating; returns how long to give this attempt
+    virtual unsigned long beginAttempt() = 0;
+    // The attempt timed out. Returns true to try again straight away
+    // (a stale fast-path cache was dropped) rather than back off.
+    virtual bool abortAttempt() = 0;
+    virtual bool isConnected() = 0;
+    virtual void onConnected(unsigned long attemptMs) = 0;
+    virtual void beginPortal() = 0;
+    // Service the config portal; false once it has closed (saved or timed out)
+    virtual bool processPortal() = 0;
+    // Drop the link and turn the radio off
+    virtual void powerOff() = 0;
+};
+
+// Connectivity state machine, stepped from loop() so the clock and the last
+// data keep rendering while the link comes and goes:
+//
+//   OFF --request()--> CONNECTING --connected--> CONNECTED
+//    ^                                               |
+//    +---------------------park()--------------------+  (or from BACKOFF)
+//                        |    ^                     |
+//                 timeout|    |retry due      drop  |
+//                        v    |                     v
+//                       BACKOFF <--grace expired-- (waits DROP_GRACE for
+//                                                  the driver's own reconnect)
+//
+// Backoff doubles from INITIAL_BACKOFF up to MAX_BACKOFF and resets on a
+// connection. The config portal only opens on openPortal(), or when there
+// are no saved credentials to try.
+class WiFiLink
+{
+public:
+    static const unsigned long INITIAL_BACKOFF = 5000;
+    static const unsigned long MAX_BACKOFF = 300000; // 5 minutes
+    static const unsigned long DROP_GRACE = 15000;
+    static const unsigned long PORTAL_POLL = 50;
+    static const unsigned long NO_DEADLINE = 0xFFFFFFFFUL;
+
+    enum State
+    {
+        LINK_OFF,        // radio off (night cycle) until request()
+        LINK_CONNECTING,
+        LINK_CONNECTED,
+        LINK_BACKOFF,
+        LINK_PORTAL
+    };
+
+    explicit WiFiLink(WiFiDriver &driver);
+
+    // radioOn false: stay off until request() (woken from deep sleep)
+    void begin(unsigned long now, bool radioOn);
+    // Bring the radio up if it's off; otherwise no-op
+    void request(unsigned long now);
+    // Radio off until the next request() (light sleep at night). No-op
+    // while connecting or serving the portal.
+    void park();
+    void openPortal(unsigned long now);
+    void update(unsigned long now);
+
+    // Time until update() has something to do (events may come sooner)
+    unsigned long millisUntilNextStep(unsigned long now) const;
+
+    State state() const { return current; }
+    // Attempting or serving the portal: don't power down
+    bool isBusy() const { return current == LINK_CONNECTING || current == LINK_PORTAL; }
+    // Consecutive failed attempts; carried through deep sleep
+    uint8_t failures() const { return failed; }
+    void setFailures(uint8_t count) { failed = count; }
+    uint32_t drops() const { return dropCount; }
+    uint32_t attempts() const { return attemptCount; }
+
+private:
+    void startAttempt(unsigned long now);
+    void enterBackoff(unsigned long now);
+    unsigned long backoffDelay() const;
+
+    WiFiDriver &driver;
+    State current;
+    unsigned long since;  // start of the current attempt or backoff
+    unsigned long budget; // length of the current attempt or backoff
+    uint8_t failed;
+    uint32_t dropCount;
+    uint32_t attemptCount;
+};
+
+#endif // WIFI_LINK_H
@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <string.h>
+#include "cpu_governor.h"
+#include "ft_log.h"
+#include "profiler.h"
+#include "report_buffer.h"
+#include "stats_lock.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+static esp_pm_lock_handle_t boostLock = nullptr;
+#endif
+#elif defined(FT_SIM)
+// Virtual time from the desktop simulator (host/)
+#include <Arduino.h>
+#else
+#include <chrono>
+static unsigned long millis()
+{
+    using namespace std::chrono;
+    return (unsigned long)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+static constexpr char TAG[] = "cpu";
+
+CpuGovernor::Level CpuGovernor::levels[LEVEL_COUNT] = {{80, 0, 0, 0, 0}, {160, 0, 0, 0, 0}};
+uint32_t CpuGovernor::boostClock = CpuGovernor::DEFAULT_BOOST_MHZ;
+// board_build.f_cpu: setup() runs at full speed
+uint32_t CpuGovernor::currentClock = 160;
+unsigned long CpuGovernor::lastSwitch = 0;
+uint8_t CpuGovernor::depth = 0;
+uint32_t CpuGovernor::switches = 0;
+const char *CpuGovernor::reason = "idle";
+
+CpuGovernor::Boost::Boost(const char *name) : previousReason(reason)
+{
+    reason = name;
+    if (depth++ == 0)
+    {
+        switchTo(boostClock);
+    }
+}
+
+CpuGovernor::Boost::~Boost()
+{
+    reason = previousReason;
+    if (--depth == 0)
+    {
+        switchTo(IDLE_MHZ);
+    }
+}
+
+void CpuGovernor::begin()
+{
+    lastSwitch = millis();
+#if defined(ARDUINO) && CONFIG_PM_ENABLE
+    esp_pm_config_esp32c3_t config = {};
+    config.max_freq_mhz = DEFAULT_BOOST_MHZ;
+    config.min_freq_mhz = IDLE_MHZ;
+    config.light_sleep_enable = false;
+    if (esp_pm_configure(&config) != ESP_OK ||
+        esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "boost", &boostLock) != ESP_OK)
+    {
+        boostLock = nullptr;
+    }
+#endif
+    switchTo(IDLE_MHZ);
+#ifdef ARDUINO
+    FT_LOGI(TAG, "CPU governor: idle %u MHz, boost %u MHz", (unsigned)IDLE_MHZ, (unsigned)boostClock);
+#endif
+}
+
+bool CpuGovernor::setBoostMhz(uint32_t mhz)
+{
+    if (!levelFor(mhz))
+    {
+        return false;
+    }
+    boostClock = mhz;
+    if (depth > 0)
+    {
+        switchTo(boostClock);
+    }
+    return true;
+}
+
+CpuGovernor::Level *CpuGovernor::levelFor(uint32_t mhz)
+{
+    for (uint8_t i = 0; i < LEVEL_COUNT; i++)
+    {
+        if (levels[i].mhz == mhz)
+        {
+            return &levels[i];
+        }
+    }
+    return nullptr;
+}
+
+void CpuGovernor::switchTo(uint32_t mhz)
+{
+    unsigned long now = millis();
+    {
+        StatsLock lock;
+        Level *current = levelFor(currentClock);
+        if (current)
+        {
+            current->residencyMs += now - lastSwitch;
+        }
+        lastSwitch = now;
+    }
+    if (mhz == currentClock)
+    {
+        return;
+    }
+    Profiler::clockChanged(mhz);
+
+#if defined(ARDUINO) && CONFIG_PM_ENABLE
+    if (boostLock)
+    {
+        // The power manager only knows max and min; a boost to IDLE_MHZ is no boost
+        if (mhz == IDLE_MHZ)
+        {
+            esp_pm_lock_release(boostLock);
+        }
+        else
+        {
+            esp_pm_lock_acquire(boostLock);
+        }
+    }
+    else
+    {
+        setCpuFrequencyMhz(mhz);
+    }
+#elif defined(ARDUINO)
+    setCpuFrequencyMhz(mhz);
+#endif
+    StatsLock lock;
+    currentClock = mhz;
+    switches++;
+}
+
+void CpuGovernor::noteHandshake(unsigned long ms)
+{
+    StatsLock lock;
+    Level *current = levelFor(currentClock);
+    if (!current)
+    {
+        return;
+    }
+    current->handshakes++;
+    current->handshakeTotalMs += ms;
+    if (ms > current->handshakeMaxMs)
+    {
+        current->handshakeMaxMs = ms;
+    }
+}
+
+size_t CpuGovernor::formatReport(char *buffer, size_t size)
+{
+    size_t len = 0;
+    if (size == 0)
+    {
+        return 0;
+    }
+    buffer[0] = '\0';
+
+    Level copy[LEVEL_COUNT];
+    uint32_t clock;
+    uint32_t switchCount;
+    const char *why;
+    unsigned long now = millis();
+    unsigned long open;
+    {
+        StatsLock lock;
+        memcpy(copy, levels, sizeof(copy));
+        clock = currentClock;
+        switchCount = switches;
+        why = reason;
+        // A switch since `now` was read has already been counted
+        open = (long)(now - lastSwitch) > 0 ? now - lastSwitch : 0;
+    }
+    for (uint8_t i = 0; i < LEVEL_COUNT; i++)
+    {
+        const Level &l = copy[i];
+        uint32_t residency = l.residencyMs + (l.mhz == clock ? open : 0);
+        unsigned average = l.handshakes ? (unsigned)(l.handshakeTotalMs / l.handshakes) : 0;
+        appendf(buffer, size, len, "cpu %u MHz: %u s, %u handshakes, avg %u ms, max %u ms\n", (unsigned)l.mhz,
+                (unsigned)(residency / 1000), (unsigned)l.handshakes, average, (unsigned)l.handshakeMaxMs);
+    }
+    appendf(buffer, size, len, "cpu now %u MHz (%s), boost %u MHz, %u switches\n", (unsigned)clock, why,
+            (unsigned)boostClock, (unsigned)switchCount);
+    return len;
+}
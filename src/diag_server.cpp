@@ -0,0 +1,110 @@
+#include <Arduino.h>
+#include "diag_server.h"
+#include "telemetry.h"
+#include "heap_guard.h"
+#include "cpu_governor.h"
+#include "time_sync.h"
+#include "fetch_metrics.h"
+#include "profiler.h"
+#include "metrics_page.h"
+#include "ft_wifi_manager.h"
+#include "display_manager.h"
+#include "ft_log.h"
+
+static constexpr char TAG[] = "diag";
+
+// Polling interval of the server task; requests wait at most this long
+static const TickType_t POLL_TICKS = pdMS_TO_TICKS(50);
+static const uint32_t TASK_STACK = 4096;
+
+WebServer DiagServer::server(DiagServer::PORT);
+char DiagServer::report[DiagServer::REPORT_SIZE];
+
+void DiagServer::begin()
+{
+    static bool started = false;
+    if (started)
+    {
+        return;
+    }
+    started = true;
+
+    server.on("/diag", HTTP_GET, handleDiag);
+    server.on("/metrics", HTTP_GET, handleMetrics);
+    server.begin();
+    // Same name as Telemetry::TASK_NAMES so its stack shows up in the report
+    xTaskCreate(task, "diag", TASK_STACK, nullptr, 1, nullptr);
+    FT_LOGI(TAG, "Diagnostics on http://%s/diag", WiFi.localIP().toString().c_str());
+}
+
+void DiagServer::task(void *param)
+{
+    (void)param;
+    while (true)
+    {
+        server.handleClient();
+        vTaskDelay(POLL_TICKS);
+    }
+}
+
+// The /diag sections, in page order. Each is formatted into the buffer and
+// sent before the next, so only the largest has to fit in REPORT_SIZE.
+static const struct
+{
+    const char *name;
+    size_t (*format)(char *buffer, size_t size);
+} SECTIONS[] = {
+    {"telemetry", Telemetry::formatReport},
+    {"cpu", CpuGovernor::formatReport},
+    {"time", TimeSync::formatReport},
+    {"fetch", FetchMetrics::formatReport},
+    {"profile", Profiler::formatReport},
+};
+
+void DiagServer::handleDiag()
+{
+    // Chunked; the server ends the reply once the handler returns
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/plain", "");
+    for (const auto &section : SECTIONS)
+    {
+        size_t len = section.format(report, sizeof(report));
+        if (len + 1 >= sizeof(report))
+        {
+            FT_LOGW(TAG, "/diag %s section truncated, raise DiagServer::REPORT_SIZE", section.name);
+        }
+        if (len > 0)
+        {
+            server.sendContent(report, len);
+        }
+    }
+}
+
+void DiagServer::handleMetrics()
+{
+    MetricsPage::System sys;
+    sys.uptimeS = millis() / 1000;
+    sys.freeHeap = ESP.getFreeHeap();
+    sys.largestBlock = ESP.getMaxAllocHeap();
+    sys.minFreeHeap = ESP.getMinFreeHeap();
+    sys.connected = FtWiFiManager::isConnected();
+    sys.rssi = sys.connected ? FtWiFiManager::getRSSI() : 0;
+    const FtWiFiManager::ConnectStats &connects = FtWiFiManager::connectStats();
+    sys.fastConnects = connects.fastHits;
+    sys.fullConnects = connects.fullConnects;
+    sys.fastMisses = connects.fastMisses;
+    DisplayCounters display = DisplayManager::counters();
+    sys.frames = display.frames;
+    sys.pixels = display.pixels;
+    sys.busBytes = display.busBytes;
+
+    bool complete;
+    size_t len = MetricsPage::format(report, sizeof(report), sys, &complete);
+    if (!complete)
+    {
+        FT_LOGW(TAG, "/metrics truncated, raise DiagServer::REPORT_SIZE");
+    }
+    server.setContentLength(len);
+    server.send(200, "text/plain; version=0.0.4", "");
+    server.sendContent(report, len);
+}
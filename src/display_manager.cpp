@@ -1,102 +1,238 @@
 #include <Arduino.h>
 #include <SPI.h>
 #include "display_manager.h"
+#ifndef ARDUINO
+#include "sim_panel.h"
+#endif
+#include "cpu_governor.h"
 #include "ft_wifi_manager.h"
-#include <sys/time.h>
+#include "time_service.h"
+#include "fetch_metrics.h"
+#include "ft_log.h"
+#include "profiler.h"
+#include "stats_lock.h"
 
+static constexpr char TAG[] = "display";
+
+#ifdef ARDUINO
 // Initialize display using hardware SPI (CS, DC, RST pins only)
-Adafruit_ST7735 tft = Adafruit_ST7735(TFT_CS, TFT_DC, TFT_RST);
+SpiPanelBus panelBus(SPI, TFT_CS, TFT_DC, TFT_RST, TFT_SPI_FREQ);
+#else
+// Desktop simulator (host/): the panel is a framebuffer saved after each frame
+SimPanelBus panelBus(SCREEN_WIDTH, SCREEN_HEIGHT, TFT_COL_START, TFT_ROW_START);
+#endif
+#ifdef FT_PANEL_TRACE
+// Record the command stream so batching can be checked on the serial log
+TracePanelBus traceBus(&panelBus);
+St77xxPanel tft(traceBus, SCREEN_WIDTH, SCREEN_HEIGHT, TFT_COL_START, TFT_ROW_START);
+#else
+St77xxPanel tft(panelBus, SCREEN_WIDTH, SCREEN_HEIGHT, TFT_COL_START, TFT_ROW_START);
+#endif
+// All drawing goes to the 4 bpp canvas; FrameScope flushes it to the panel
+IndexedCanvas canvas(SCREEN_WIDTH, SCREEN_HEIGHT);
 
 bool isDisplayInitialized = false;
-String currentFlightNumber = "";
-String currentTimeString = "";
-String currentTemperature = "";
-String currentHumidity = "";
-String newTemperature = "";
-String newHumidity = "";
+FieldText currentFlightNumber;
+FieldText currentTimeString;
+FieldText currentTemperature;
+FieldText currentHumidity;
+FieldText newTemperature;
+FieldText newHumidity;
 bool isInErrorState = false;
-String currentErrorMessage = "";
+MessageText currentErrorMessage;
+// Bumped whenever the whole screen is wiped, so callers caching "already
+// rendered" state know to draw again
+uint32_t screenEpochCounter = 0;
+PanelSleepPolicy panelPolicy = PANEL_ALWAYS_ON;
+PanelPowerStats panelStats = {0, 0, 0, 0};
+
+// Debug overlay
+const unsigned long LOOP_RATE_WINDOW = 10000; // loop passes are averaged over 10 s
+typedef FixedString<Layout::OVERLAY_CHARS + 1> OverlayText;
+bool overlayOn = false;
+bool overlayShown = false; // the strip holds overlay text
+OverlayText overlayDrawn[Layout::OVERLAY_LINES];
+uint32_t overlayEpoch = 0;
+DisplayCounters overlayCost = {0, 0, 0};
+// Last frame: outermost FrameScope opened to flush done
+unsigned long frameStartUs = 0;
+uint32_t lastFrameUs = 0;
+uint32_t lastFrameBytes = 0;
+uint32_t loopPasses = 0;
+unsigned long loopWindowStart = 0;
+uint16_t loopRateTenths = 0;
+
+static void refreshOverlay();
+static void publishCounters();
+
+// Collects everything drawn in a scope and flushes the dirty rows of the
+// canvas to the panel when the outermost scope ends
+struct FrameScope
+{
+    static uint8_t depth;
+
+    FrameScope()
+    {
+        if (depth++ == 0)
+        {
+            frameStartUs = micros();
+        }
+    }
+    ~FrameScope()
+    {
+        // An asleep panel keeps the rows dirty until it wakes
+        if (--depth > 0 || tft.isAsleep())
+        {
+            return;
+        }
+        if (canvas.isDirty())
+        {
+            FT_PROFILE_ZONE("panel flush");
+            uint32_t bytes = panelBus.bytesSent();
+            unsigned long start = micros();
+            uint32_t pixels = canvas.flush(tft);
+            unsigned long end = micros();
+            unsigned long elapsed = end - start;
+            lastFrameUs = end - frameStartUs;
+            lastFrameBytes = panelBus.bytesSent() - bytes;
+#if defined(FT_PANEL_TRACE) && FT_LOG_LEVEL >= FT_LOG_INFO
+            const TracePanelBus::Totals &t = traceBus.totals();
+            FT_LOGI(TAG, "Panel frame: %u px in %lu us, %u txn, %u cmd, %u data B, %u pixel B, %u bursts",
+                    (unsigned)pixels, elapsed, (unsigned)t.transactions, (unsigned)t.commands,
+                    (unsigned)t.dataBytes, (unsigned)t.pixelBytes, (unsigned)t.bursts);
+            traceBus.clear();
+#else
+            (void)pixels;
+            (void)elapsed;
+#endif
+        }
+        // Only once the frame has been measured
+        if (overlayOn || overlayShown)
+        {
+            refreshOverlay();
+        }
+        publishCounters();
+    }
+};
+
+uint8_t FrameScope::depth = 0;
 
-void DisplayManager::initDisplay()
+void DisplayManager::initDisplay(bool resumed, bool panelAsleep)
 {
     if (!isDisplayInitialized)
     {
         // Initialize hardware SPI with custom pins
         SPI.begin(TFT_SCLK, -1, TFT_MOSI, -1); // (SCK, MISO, MOSI, SS)
 
-        // Initialize the display with hardware SPI
-        tft.initR(INITR_GREENTAB);    // Initialize with green tab settings
-        tft.fillScreen(ST77XX_BLACK); // Clear the screen to black
+        if (resumed)
+        {
+            // Woken from deep sleep: the panel still shows the last frame. The
+            // canvas is blank but fully dirty, so the first redraw replaces
+            // the whole screen in one flush, without a black flash.
+            tft.resumeFromDeepSleep(panelAsleep);
+        }
+        else
+        {
+            // Initialize the display with hardware SPI
+            tft.begin(); // Reset + green tab init sequence
+
+            // The canvas starts black and fully dirty, so this clears the panel
+            canvas.flush(tft);
+        }
+
+        FT_LOGI(TAG, "Canvas: %u bytes at 4 bpp (RGB565 would need %u)",
+                (unsigned)IndexedCanvas::bufferBytes(SCREEN_WIDTH, SCREEN_HEIGHT),
+                (unsigned)(SCREEN_WIDTH * SCREEN_HEIGHT * 2));
 
         isDisplayInitialized = true;
     }
 }
 
+void DisplayManager::prepareDeepSleep()
+{
+    tft.prepareDeepSleep();
+}
+
 void DisplayManager::clearScreen()
 {
-    tft.fillScreen(ST77XX_BLACK);
+    FrameScope frame;
+
+    canvas.fillScreen(ST77XX_BLACK);
+    screenEpochCounter++;
     // Reset error state when screen is cleared
     isInErrorState = false;
-    currentErrorMessage = "";
+    currentErrorMessage.clear();
     // Reset display state variables so first update after clear doesn't try to erase non-existent text
-    currentTimeString = "";
-    currentTemperature = "";
-    currentHumidity = "";
-    Serial.println("Screen cleared - reset display state variables");
+    currentTimeString.clear();
+    currentTemperature.clear();
+    currentHumidity.clear();
+    FT_LOGD(TAG, "Screen cleared - reset display state variables");
 }
 
 void DisplayManager::displayWiFiStrength()
 {
+    FT_PROFILE_ZONE("wifi bars");
     // Don't draw WiFi strength if we're in error state
     if (isInErrorState)
     {
         return;
     }
 
-    int iconX = SCREEN_WIDTH - WIFI_ICON_WIDTH;
-    int iconY = 5;
+    FrameScope frame;
 
     // Choose color based on display mode: yellow for flight data, green for time display
-    uint16_t wifiColor = (currentFlightNumber != "") ? ST77XX_YELLOW : ST77XX_GREEN;
+    uint16_t wifiColor = !currentFlightNumber.isEmpty() ? ST77XX_YELLOW : ST77XX_GREEN;
+    // Mode colour lives in the accent palette slot: switching it is a palette
+    // swap, not a redraw
+    canvas.setAccent(wifiColor);
+
+    if (FtWiFiManager::isRadioOff())
+    {
+        // Radio parked between night fetches: not an outage, leave the icon blank
+        canvas.fillRect(Layout::WIFI_ICON.x, Layout::WIFI_ICON.y, Layout::WIFI_ICON.w, Layout::WIFI_ICON.h,
+                        ST77XX_BLACK);
+        return;
+    }
 
     if (!FtWiFiManager::isConnected())
     {
-        tft.setTextSize(1);
-        tft.setFont();
-        tft.setTextColor(wifiColor);
-        tft.setCursor(iconX + (WIFI_ICON_WIDTH - 5) / 2, iconY + (WIFI_ICON_HEIGHT - 8) / 2);
-        tft.print("X");
+        canvas.setTextSize(1);
+        canvas.setFont();
+        canvas.setTextColor(wifiColor);
+        canvas.setCursor(Layout::WIFI_OFFLINE_MARK.x, Layout::WIFI_OFFLINE_MARK.y);
+        canvas.print("X");
         return;
     }
 
     long rssi = FtWiFiManager::getRSSI();
     int bars = calculateWiFiBars(rssi);
 
-    int totalBarsWidth = (4 * WIFI_BAR_WIDTH) + (3 * WIFI_BAR_SPACING);
-    int startX = iconX + (WIFI_ICON_WIDTH - totalBarsWidth) / 2;
-
-    drawWiFiBars(bars, startX, iconY, wifiColor);
+    drawWiFiBars(bars, wifiColor);
 }
 
 void DisplayManager::drawError(const char *message)
 {
-    String messageStr = String(message);
+    FrameScope frame;
+
+    // Truncated the same way as the stored copy, so long messages still compare equal
+    MessageText incoming(message);
 
     // Only redraw error if it's a new error message or we're not already in error state
-    if (!isInErrorState || currentErrorMessage != messageStr)
+    if (!isInErrorState || currentErrorMessage != incoming)
     {
-        tft.fillScreen(ST77XX_RED);
-        tft.setTextColor(ST77XX_WHITE);
-        tft.setTextSize(1);
-        tft.setFont();
+        canvas.fillScreen(ST77XX_RED);
+        screenEpochCounter++;
+        canvas.setTextColor(ST77XX_WHITE);
+        canvas.setTextSize(1);
+        canvas.setFont();
 
         // Display error message
-        tft.setCursor(BORDER_OFFSET, 50);
-        tft.print(message);
+        canvas.setCursor(Layout::ERROR_X, Layout::ERROR_Y);
+        canvas.print(message);
 
         isInErrorState = true;
-        currentErrorMessage = messageStr;
-        Serial.println("=== Error Displayed ===");
+        currentErrorMessage = incoming;
+        FT_LOGI(TAG, "=== Error Displayed ===");
     }
 }
 
@@ -105,12 +241,214 @@ void DisplayManager::clearError()
     if (isInErrorState)
     {
         isInErrorState = false;
-        currentErrorMessage = "";
+        currentErrorMessage.clear();
         clearScreen();
-        Serial.println("=== Error State Cleared ===");
+        FT_LOGI(TAG, "=== Error State Cleared ===");
     }
 }
 
+void DisplayManager::setPanelSleepPolicy(PanelSleepPolicy policy)
+{
+    panelPolicy = policy;
+}
+
+bool DisplayManager::panelWanted(PanelSleepPolicy policy, bool night, bool flightShown, bool errorShown)
+{
+    if (errorShown || !night)
+    {
+        return true;
+    }
+    switch (policy)
+    {
+    case PANEL_SLEEP_AT_NIGHT:
+        return false;
+    case PANEL_SLEEP_AT_NIGHT_EXCEPT_FLIGHTS:
+        return flightShown;
+    default:
+        return true;
+    }
+}
+
+void DisplayManager::updatePanelPower(bool night)
+{
+    bool wanted = panelWanted(panelPolicy, night, !currentFlightNumber.isEmpty(), isInErrorState);
+
+    if (!wanted && !tft.isAsleep())
+    {
+        tft.sleep();
+        panelStats.sleeps++;
+        FT_LOGI(TAG, "Panel asleep");
+    }
+    else if (wanted && tft.isAsleep())
+    {
+        unsigned long start = micros();
+        tft.wake();
+        {
+            // Bring the retained picture up to date while the display is
+            // still off; after a night that can be most of the screen
+            CpuGovernor::Boost boost("panel wake");
+            canvas.flush(tft);
+        }
+        tft.setDisplayOn(true);
+        uint32_t elapsed = micros() - start;
+
+        panelStats.wakes++;
+        panelStats.lastWakeUs = elapsed;
+        if (elapsed > panelStats.maxWakeUs)
+        {
+            panelStats.maxWakeUs = elapsed;
+        }
+        FT_LOGI(TAG, "Panel awake in %lu us (max %lu us)", (unsigned long)elapsed,
+                (unsigned long)panelStats.maxWakeUs);
+    }
+}
+
+bool DisplayManager::isPanelAsleep()
+{
+    return tft.isAsleep();
+}
+
+const PanelPowerStats &DisplayManager::panelPowerStats()
+{
+    return panelStats;
+}
+
+// counters() is read from the diag task, so it gets a copy taken as each
+// frame ends rather than the live canvas and bus figures
+static DisplayCounters publishedCounters = {0, 0, 0};
+
+static void publishCounters()
+{
+    const IndexedCanvas::FlushStats &flushed = canvas.stats();
+    DisplayCounters now = {flushed.flushes - overlayCost.frames, flushed.pixels - overlayCost.pixels,
+                           panelBus.bytesSent() - overlayCost.busBytes};
+    StatsLock lock;
+    publishedCounters = now;
+}
+
+DisplayCounters DisplayManager::counters()
+{
+    StatsLock lock;
+    return publishedCounters;
+}
+
+void DisplayManager::setOverlay(bool on)
+{
+    overlayOn = on;
+    // Drawn, or erased, as the frame ends
+    FrameScope frame;
+}
+
+bool DisplayManager::isOverlayOn()
+{
+    return overlayOn;
+}
+
+void DisplayManager::updateOverlay()
+{
+    unsigned long now = millis();
+    loopPasses++;
+    if (now - loopWindowStart >= LOOP_RATE_WINDOW)
+    {
+        uint32_t tenths = loopPasses * 10000UL / (now - loopWindowStart);
+        loopRateTenths = tenths > 999 ? 999 : tenths;
+        loopPasses = 0;
+        loopWindowStart = now;
+    }
+    if (overlayOn)
+    {
+        FrameScope frame;
+    }
+}
+
+static unsigned long clampTo5Digits(uint32_t value)
+{
+    return value > 99999 ? 99999 : value;
+}
+
+static void formatOverlay(OverlayText *lines)
+{
+    // Each field clamped to its width, in steps the compiler can follow
+    char text[Layout::OVERLAY_CHARS + 1];
+    unsigned long heapK = ESP.getFreeHeap() / 1024;
+    heapK = heapK > 999 ? 999 : heapK;
+    snprintf(text, sizeof(text), "%5luus %5luB %3luk", clampTo5Digits(lastFrameUs), clampTo5Digits(lastFrameBytes),
+             heapK);
+    lines[0] = text;
+
+    unsigned rate = loopRateTenths > 999 ? 999 : loopRateTenths;
+    if (FetchMetrics::fetchCount() > 0)
+    {
+        const FetchMetrics::Last &fetch = FetchMetrics::last();
+        unsigned long ms = fetch.totalMs > 99999 ? 99999 : fetch.totalMs;
+        int status = fetch.status < -99 ? -99 : fetch.status;
+        status = status > 999 ? 999 : status;
+        snprintf(text, sizeof(text), "%c %5lums %3d %2u.%u/s", toupper(FetchMetrics::endpointName(fetch.endpoint)[0]),
+                 ms, status, rate / 10, rate % 10);
+    }
+    else
+    {
+        snprintf(text, sizeof(text), "- %5sms %3s %2u.%u/s", "--", "--", rate / 10, rate % 10);
+    }
+    lines[1] = text;
+}
+
+// Redraw the overlay lines that changed (or erase them once it is off) and
+// flush just those rows, counted apart from the frames
+static void refreshOverlay()
+{
+    FT_PROFILE_ZONE("overlay");
+    if (overlayEpoch != screenEpochCounter)
+    {
+        // The screen was wiped under the overlay
+        overlayEpoch = screenEpochCounter;
+        for (int i = 0; i < Layout::OVERLAY_LINES; i++)
+        {
+            overlayDrawn[i].clear();
+        }
+    }
+
+    OverlayText lines[Layout::OVERLAY_LINES];
+    if (overlayOn)
+    {
+        formatOverlay(lines);
+    }
+    canvas.setFont();
+    canvas.setTextSize(1);
+    canvas.setTextColor(ST77XX_WHITE);
+    for (int i = 0; i < Layout::OVERLAY_LINES; i++)
+    {
+        if (lines[i] == overlayDrawn[i])
+        {
+            continue;
+        }
+        const Layout::Box line = Layout::overlayLine(i);
+        canvas.fillRect(line.x, line.y, line.w, line.h, ST77XX_BLACK);
+        canvas.setCursor(line.x, line.y);
+        canvas.print(lines[i].c_str());
+        overlayDrawn[i] = lines[i];
+    }
+    overlayShown = overlayOn;
+
+    if (canvas.isDirty())
+    {
+        uint32_t bytes = panelBus.bytesSent();
+        overlayCost.pixels += canvas.flush(tft);
+        overlayCost.busBytes += panelBus.bytesSent() - bytes;
+        overlayCost.frames++;
+    }
+}
+
+bool DisplayManager::isShowingError()
+{
+    return isInErrorState;
+}
+
+uint32_t DisplayManager::screenEpoch()
+{
+    return screenEpochCounter;
+}
+
 void DisplayManager::displayTime()
 {
     // Only clear error state if WiFi is connected (meaning we can successfully display time)
@@ -119,13 +457,13 @@ void DisplayManager::displayTime()
         clearError();
     }
 
-    if (currentFlightNumber == "")
+    if (currentFlightNumber.isEmpty())
     {
         drawTime();
     }
 }
 
-void DisplayManager::setWeatherInfo(const String &temperature, const String &humidity)
+void DisplayManager::setWeatherInfo(const char *temperature, const char *humidity)
 {
     newTemperature = temperature;
     newHumidity = humidity;
@@ -133,64 +471,48 @@ void DisplayManager::setWeatherInfo(const String &temperature, const String &hum
 
 void DisplayManager::drawTime()
 {
+    FT_PROFILE_ZONE("draw time");
     // Don't draw time if we're in error state
     if (isInErrorState)
     {
         return;
     }
 
+    FrameScope frame;
+    canvas.setAccent(ST77XX_GREEN);
     drawBorderedRect(ST77XX_GREEN);
-    tft.setTextSize(1);
+    canvas.setTextSize(1);
 
-    // Update time display
-    String currentTime = getCurrentTimeString();
-    if (currentTime != currentTimeString && currentTime != "00:00")
+    // Update time display; dashes until the clock has been set
+    const char *currentTime = TimeService::isSet() ? TimeService::timeString() : "--:--";
+    if (currentTimeString != currentTime)
     {
-        Serial.printf("Time update: old='%s' new='%s'\n", currentTimeString.c_str(), currentTime.c_str());
-        drawTextWithErase(BORDER_OFFSET, TIME_Y_POS, currentTimeString, currentTime,
-                          ST77XX_GREEN, &DSEG14ModernMini_Bold18pt7b);
+        FT_LOGD(TAG, "Time update: old='%s' new='%s'", currentTimeString.c_str(), currentTime);
+        drawField(Layout::TIME, currentTime, ST77XX_GREEN, &DSEG14ModernMini_Bold18pt7b);
         currentTimeString = currentTime;
-        Serial.printf("Current time: %s\n", currentTime.c_str());
+        FT_LOGD(TAG, "Current time: %s", currentTime);
     }
 
     // Update temperature display
     if (currentTemperature != newTemperature && !newTemperature.isEmpty())
     {
-        String oldTempText = currentTemperature.isEmpty() ? "" : currentTemperature + "C";
-        String newTempText = newTemperature + "C";
-
-        drawTextWithErase(BORDER_OFFSET, TEMP_Y_POS, oldTempText, newTempText,
-                          ST77XX_GREEN, &FreeMonoBold12pt7b);
+        FieldText text(newTemperature.c_str());
+        text += 'C';
+        drawField(Layout::TEMPERATURE, text.c_str(), ST77XX_GREEN, &FreeMonoBold12pt7b);
         currentTemperature = newTemperature;
     }
 
     // Update humidity display
     if (currentHumidity != newHumidity && !newHumidity.isEmpty())
     {
-        String oldHumidityText = currentHumidity.isEmpty() ? "" : currentHumidity + "%";
-        String newHumidityText = newHumidity + "%";
-
-        drawTextWithErase(BORDER_OFFSET, HUMIDITY_Y_POS, oldHumidityText, newHumidityText,
-                          ST77XX_GREEN, &FreeMonoBold12pt7b);
+        FieldText text(newHumidity.c_str());
+        text += '%';
+        drawField(Layout::HUMIDITY, text.c_str(), ST77XX_GREEN, &FreeMonoBold12pt7b);
         currentHumidity = newHumidity;
     }
 }
 
-String DisplayManager::getValueOrQuestion(const JsonDocument &data, const char *key)
-{
-    if (data[key].is<String>())
-    {
-        String value = data[key].as<String>();
-        if (value == "null" || value.isEmpty())
-        {
-            return "?";
-        }
-        return value;
-    }
-    return "?";
-}
-
-void DisplayManager::displayFlightData(const JsonDocument &flightData)
+void DisplayManager::displayFlightData(const FlightRecord &flight)
 {
     // Only clear error state if WiFi is connected
     if (FtWiFiManager::isConnected())
@@ -198,147 +520,107 @@ void DisplayManager::displayFlightData(const JsonDocument &flightData)
         clearError();
     }
 
-    if (flightData.isNull() || !flightData["callsign"].is<String>() ||
-        flightData["callsign"].as<String>() == "null" ||
-        flightData["callsign"].as<String>().isEmpty())
+    if (!flight.available)
     {
-        Serial.println("No flight data to display or callsign is null/empty.");
-        if (currentFlightNumber != "")
+        FT_LOGD(TAG, "No flight data to display or callsign is null/empty.");
+        if (!currentFlightNumber.isEmpty())
         {
             clearScreen();
             // Note: clearScreen() already resets time/weather variables
         }
-        currentFlightNumber = "";
+        currentFlightNumber.clear();
         return;
     }
 
-    Serial.println("Updating display with flight data...");
+    FT_LOGD(TAG, "Updating display with flight data...");
 
-    String airline = getValueOrQuestion(flightData, "airlineIcao");
-    String flightNumber = getValueOrQuestion(flightData, "callsign");
-    String origin = getValueOrQuestion(flightData, "originAirportIata");
-    String destination = getValueOrQuestion(flightData, "destinationAirportIata");
-    String aircraftCode = getValueOrQuestion(flightData, "aircraftCode");
-
-    if (destination == "SPC")
-    {
-        destination = origin;
-    }
-    drawFlight(destination.c_str(), aircraftCode.c_str(), flightNumber.c_str());
+    // Flights from the home airport show where they're going, flights into it
+    // where they came from
+    const char *airport = strcmp(flight.destination, "SPC") == 0 ? flight.origin : flight.destination;
+    drawFlight(airport, flight.aircraft, flight.callsign);
 }
 
 void DisplayManager::drawFlight(const char *airport, const char *aircraft, const char *flightNumber)
 {
+    FT_PROFILE_ZONE("draw flight");
+    FrameScope frame;
+
     // Only clear screen when switching between different flights or from time to flight display
     if (currentFlightNumber != flightNumber)
     {
-        Serial.printf("Flight change: '%s' -> '%s', clearing screen\n", currentFlightNumber.c_str(), flightNumber);
+        FT_LOGI(TAG, "Flight change: '%s' -> '%s', clearing screen", currentFlightNumber.c_str(), flightNumber);
         clearScreen();
     }
     currentFlightNumber = flightNumber;
 
+    canvas.setAccent(ST77XX_YELLOW);
     drawBorderedRect(ST77XX_YELLOW);
-    tft.setTextColor(ST77XX_YELLOW);
-    tft.setTextSize(1);
+    canvas.setTextSize(1);
 
     // Display airport destination
-    tft.setFont(&DSEG14ModernMini_Bold18pt7b);
-    tft.setCursor(BORDER_OFFSET, AIRPORT_Y_POS);
-    tft.print(airport);
+    drawField(Layout::AIRPORT, airport, ST77XX_YELLOW, &DSEG14ModernMini_Bold18pt7b);
 
     // Display aircraft and flight number
-    tft.setFont(&FreeMonoBold12pt7b);
-    tft.setCursor(5, AIRCRAFT_Y_POS);
-    tft.print(aircraft);
-    tft.setCursor(5, FLIGHT_NUM_Y_POS);
-    tft.print(flightNumber);
+    drawField(Layout::AIRCRAFT, aircraft, ST77XX_YELLOW, &FreeMonoBold12pt7b);
+    drawField(Layout::FLIGHT_NUMBER, flightNumber, ST77XX_YELLOW, &FreeMonoBold12pt7b);
 }
 
 void DisplayManager::displayAPInfo(const String &apName, const String &password, const String &ip)
 {
-    tft.fillScreen(ST77XX_BLACK);
-    tft.setTextSize(1);
-    tft.setTextColor(ST77XX_GREEN);
-
-    tft.setCursor(0, 10);
-    tft.println("WiFi Setup Mode");
-    tft.println("");
+    FrameScope frame;
 
-    tft.print("AP: ");
-    tft.println(apName);
+    canvas.fillScreen(ST77XX_BLACK);
+    screenEpochCounter++;
+    canvas.setTextSize(1);
+    canvas.setTextColor(ST77XX_GREEN);
 
-    tft.print("Pass: ");
-    tft.println(password);
+    canvas.setCursor(0, Layout::AP_INFO_Y);
+    canvas.println("WiFi Setup Mode");
+    canvas.println("");
 
-    tft.print("IP: ");
-    tft.println(ip);
+    canvas.print("AP: ");
+    canvas.println(apName);
 
-    tft.println("");
-    tft.println("Connect & browse to");
-    tft.println("192.168.4.1");
-
-    Serial.println("=== WiFi Setup Mode ===");
-    Serial.printf("AP Name: %s\n", apName.c_str());
-    Serial.printf("Password: %s\n", password.c_str());
-    Serial.printf("IP: %s\n", ip.c_str());
-    Serial.println("Connect and browse to 192.168.4.1");
-}
-
-String DisplayManager::getCurrentTimeString()
-{
-    // Set timezone to London (handles GMT/BST automatically)
-    setenv("TZ", "GMT0BST,M3.5.0/1,M10.5.0", 1);
-    tzset();
+    canvas.print("Pass: ");
+    canvas.println(password);
 
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
+    canvas.print("IP: ");
+    canvas.println(ip);
 
-    // Convert to London local time (automatically handles GMT/BST)
-    struct tm *timeinfo = localtime(&tv.tv_sec);
+    canvas.println("");
+    canvas.println("Connect & browse to");
+    canvas.println("192.168.4.1");
 
-    // Format as HH:MM
-    char timeStr[6];
-    snprintf(timeStr, sizeof(timeStr), "%02d:%02d", timeinfo->tm_hour, timeinfo->tm_min);
-
-    return String(timeStr);
+    FT_LOGI(TAG, "=== WiFi Setup Mode ===");
+    FT_LOGI(TAG, "AP Name: %s", apName.c_str());
+    FT_LOGI(TAG, "Password: %s", password.c_str());
+    FT_LOGI(TAG, "IP: %s", ip.c_str());
+    FT_LOGI(TAG, "Connect and browse to 192.168.4.1");
 }
 
-// Helper function to draw text with automatic erasing of old text
-void DisplayManager::drawTextWithErase(int x, int y, const String &oldText, const String &newText,
-                                       uint16_t color, const GFXfont *font)
+// Helper function to draw a text field, erasing whatever the field held before
+void DisplayManager::drawField(const Layout::TextSlot &slot, const char *text,
+                               uint16_t color, const GFXfont *font)
 {
-    // Make local copies to prevent any potential string reference issues
-    String oldTextCopy = oldText;
-    String newTextCopy = newText;
-
-    if (font)
-    {
-        tft.setFont(font);
-    }
+    FT_PROFILE_ZONE("draw field");
+    // The slot box covers anything the field can show, so the old text
+    // doesn't need to be known or redrawn in black
+    canvas.fillRect(slot.box.x, slot.box.y, slot.box.w, slot.box.h, ST77XX_BLACK);
 
-    // Erase old text by drawing it in black
-    if (!oldTextCopy.isEmpty())
+    if (*text)
     {
-        tft.setCursor(x, y);
-        tft.setTextColor(ST77XX_BLACK);
-        tft.print(oldTextCopy);
-        Serial.printf("Erasing old text: '%s' at (%d,%d)\n", oldTextCopy.c_str(), x, y);
-    }
-
-    // Draw new text in specified color
-    if (!newTextCopy.isEmpty())
-    {
-        tft.setCursor(x, y);
-        tft.setTextColor(color);
-        tft.print(newTextCopy);
-        Serial.printf("Drawing new text: '%s' at (%d,%d)\n", newTextCopy.c_str(), x, y);
+        canvas.setFont(font);
+        canvas.setCursor(slot.x, slot.baseline);
+        canvas.setTextColor(color);
+        canvas.print(text);
+        FT_LOGD(TAG, "Drawing new text: '%s' at (%d,%d)", text, slot.x, slot.baseline);
     }
 }
 
 // Helper function to draw bordered rectangle
 void DisplayManager::drawBorderedRect(uint16_t color)
 {
-    tft.drawRect(0, BORDER_OFFSET, SCREEN_WIDTH, SCREEN_HEIGHT - BORDER_OFFSET, color);
+    canvas.drawRect(Layout::BORDER.x, Layout::BORDER.y, Layout::BORDER.w, Layout::BORDER.h, color);
 }
 
 // Helper function to calculate WiFi signal bars
@@ -355,15 +637,13 @@ int DisplayManager::calculateWiFiBars(long rssi)
 }
 
 // Helper function to draw WiFi signal bars
-void DisplayManager::drawWiFiBars(int bars, int startX, int startY, uint16_t activeColor)
+void DisplayManager::drawWiFiBars(int bars, uint16_t activeColor)
 {
-    for (int i = 1; i <= 4; i++)
+    for (int i = 0; i < Layout::WIFI_BAR_COUNT; i++)
     {
-        int barHeight = i * 2;
-        int barY = startY + (WIFI_ICON_HEIGHT - barHeight);
-        uint16_t barColor = (bars >= i) ? activeColor : ST77XX_BLACK;
+        const Layout::Box bar = Layout::wifiBar(i);
+        uint16_t barColor = (bars > i) ? activeColor : ST77XX_BLACK;
 
-        tft.fillRect(startX, barY, WIFI_BAR_WIDTH, barHeight, barColor);
-        startX += (WIFI_BAR_WIDTH + WIFI_BAR_SPACING);
+        canvas.fillRect(bar.x, bar.y, bar.w, bar.h, barColor);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <string.h>
+#include "fetch_metrics.h"
+#include "report_buffer.h"
+#include "stats_lock.h"
+
+static const char *const STAGE_NAMES[FetchMetrics::STAGE_COUNT] = {"dns", "connect", "first byte", "body", "total"};
+static const char *const ENDPOINT_NAMES[FetchMetrics::ENDPOINT_COUNT] = {"flight", "weather"};
+
+// Index of the highest set bit, v > 0
+static uint8_t topBit(uint32_t v)
+{
+    return 31 - __builtin_clz(v);
+}
+
+uint8_t LatencyHistogram::bucketFor(uint32_t ms)
+{
+    if (ms > MAX_MS)
+    {
+        ms = MAX_MS;
+    }
+    if (ms < 4)
+    {
+        return ms;
+    }
+    uint8_t msb = topBit(ms);
+    return (msb - 1) * 4 + ((ms >> (msb - 2)) & 3);
+}
+
+uint32_t LatencyHistogram::bucketUpper(uint8_t index)
+{
+    if (index < 4)
+    {
+        return index;
+    }
+    uint8_t msb = index / 4 + 1;
+    uint32_t width = 1u << (msb - 2);
+    return (4 + index % 4) * width + width - 1;
+}
+
+void LatencyHistogram::add(uint32_t ms)
+{
+    uint8_t bucket = bucketFor(ms);
+    if (counts[bucket] < 0xFFFF)
+    {
+        counts[bucket]++;
+    }
+    if (samples == 0 || ms < lowest)
+    {
+        lowest = ms;
+    }
+    if (ms > highest)
+    {
+        highest = ms;
+    }
+    samples++;
+    total += ms;
+}
+
+void LatencyHistogram::clear()
+{
+    memset(this, 0, sizeof(*this));
+}
+
+uint32_t LatencyHistogram::percentile(uint8_t p) const
+{
+    if (samples == 0)
+    {
+        return 0;
+    }
+    // Rank of the sample wanted, 1-based, rounded up. Bucket counts
+    // saturate, so rank against what they hold rather than `samples`.
+    uint32_t binned = 0;
+    for (uint8_t i = 0; i < BUCKETS; i++)
+    {
+        binned += counts[i];
+    }
+    uint32_t rank = (binned * p + 99) / 100;
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < BUCKETS; i++)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+        {
+            uint32_t value = bucketUpper(i);
+            return value < min() ? min() : value > highest ? highest : value;
+        }
+    }
+    return highest;
+}
+
+LatencyHistogram FetchMetrics::histograms[ENDPOINT_COUNT][STAGE_COUNT];
+uint32_t FetchMetrics::ok[ENDPOINT_COUNT];
+uint32_t FetchMetrics::failed[ENDPOINT_COUNT][STAGE_COUNT];
+FetchMetrics::Last FetchMetrics::lastFetch;
+
+const char *FetchMetrics::stageName(uint8_t stage)
+{
+    return stage < STAGE_COUNT ? STAGE_NAMES[stage] : "?";
+}
+
+const char *FetchMetrics::endpointName(uint8_t endpoint)
+{
+    return endpoint < ENDPOINT_COUNT ? ENDPOINT_NAMES[endpoint] : "?";
+}
+
+void FetchMetrics::record(Endpoint endpoint, const FetchTimer &timer, bool success, int status)
+{
+    StatsLock lock;
+    lastFetch.totalMs = timer.stageMs(STAGE_TOTAL);
+    lastFetch.status = (int16_t)status;
+    lastFetch.endpoint = endpoint;
+    lastFetch.ok = success;
+
+    for (uint8_t s = 0; s < STAGE_TOTAL; s++)
+    {
+        if (timer.reached((Stage)s))
+        {
+            histograms[endpoint][s].add(timer.stageMs((Stage)s));
+        }
+    }
+    if (success)
+    {
+        // Failed fetches would drag the total towards their timeouts
+        histograms[endpoint][STAGE_TOTAL].add(timer.stageMs(STAGE_TOTAL));
+        ok[endpoint]++;
+    }
+    else
+    {
+        // All stages done but the body was unusable: blame the body
+        Stage stage = timer.pending();
+        failed[endpoint][stage == STAGE_TOTAL ? STAGE_BODY : stage]++;
+    }
+}
+
+LatencyHistogram FetchMetrics::histogram(Endpoint endpoint, Stage stage)
+{
+    StatsLock lock;
+    return histograms[endpoint][stage];
+}
+
+uint32_t FetchMetrics::successes(Endpoint endpoint)
+{
+    StatsLock lock;
+    return ok[endpoint];
+}
+
+uint32_t FetchMetrics::fetchCount()
+{
+    StatsLock lock;
+    uint32_t count = 0;
+    for (uint8_t e = 0; e < ENDPOINT_COUNT; e++)
+    {
+        count += ok[e];
+        for (uint8_t s = 0; s < STAGE_COUNT; s++)
+        {
+            count += failed[e][s];
+        }
+    }
+    return count;
+}
+
+uint32_t FetchMetrics::failures(Endpoint endpoint, Stage stage)
+{
+    StatsLock lock;
+    return failed[endpoint][stage];
+}
+
+size_t FetchMetrics::formatReport(char *buffer, size_t size)
+{
+    size_t len = 0;
+    if (size == 0)
+    {
+        return 0;
+    }
+    buffer[0] = '\0';
+
+    for (uint8_t e = 0; e < ENDPOINT_COUNT; e++)
+    {
+        uint32_t okCount;
+        uint32_t failedCount[STAGE_COUNT];
+        {
+            StatsLock lock;
+            okCount = ok[e];
+            memcpy(failedCount, failed[e], sizeof(failedCount));
+        }
+        uint32_t failedTotal = 0;
+        for (uint8_t s = 0; s < STAGE_COUNT; s++)
+        {
+            failedTotal += failedCount[s];
+        }
+        appendf(buffer, size, len, "fetch %s: %u ok, %u failed", ENDPOINT_NAMES[e], (unsigned)okCount,
+                (unsigned)failedTotal);
+        for (uint8_t s = 0; s < STAGE_TOTAL; s++)
+        {
+            if (failedCount[s])
+            {
+                appendf(buffer, size, len, ", %u at %s", (unsigned)failedCount[s], STAGE_NAMES[s]);
+            }
+        }
+        appendf(buffer, size, len, "\n  %-10s %6s %6s %6s %6s %6s (ms)\n", "stage", "n", "min", "p50", "p95", "max");
+        for (uint8_t s = 0; s < STAGE_COUNT; s++)
+        {
+            LatencyHistogram h = histogram((Endpoint)e, (Stage)s);
+            appendf(buffer, size, len, "  %-10s %6u %6u %6u %6u %6u\n", STAGE_NAMES[s], (unsigned)h.count(),
+                    (unsigned)h.min(), (unsigned)h.percentile(50), (unsigned)h.percentile(95), (unsigned)h.max());
+        }
+    }
+    return len;
+}
+
+void FetchTimer::start(unsigned long nowMs)
+{
+    started = nowMs;
+    last = nowMs;
+    memset(ms, 0, sizeof(ms));
+    done = 0;
+}
+
+void FetchTimer::mark(FetchMetrics::Stage stage, unsigned long nowMs)
+{
+    ms[stage] = nowMs - last;
+    ms[FetchMetrics::STAGE_TOTAL] = nowMs - started;
+    last = nowMs;
+    done |= 1u << stage;
+}
+
+FetchMetrics::Stage FetchTimer::pending() const
+{
+    for (uint8_t s = 0; s < FetchMetrics::STAGE_TOTAL; s++)
+    {
+        if (!reached((FetchMetrics::Stage)s))
+        {
+            return (FetchMetrics::Stage)s;
+        }
+    }
+    return FetchMetrics::STAGE_TOTAL;
+}
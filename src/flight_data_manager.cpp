@@ -1,49 +1,151 @@
 #include <sys/time.h>
 #include "flight_data_manager.h"
 #include "display_manager.h"
+#include "json_arena.h"
+#include "cpu_governor.h"
 #include <Arduino.h>
+#include "ft_log.h"
+#include "profiler.h"
+
+static constexpr char TAG[] = "flight";
 
 const char *API_URL = "https://flighttrack.primesolid.com/testX";
 
-HTTPClient FlightDataManager::httpClient;
+HttpFetch FlightDataManager::http(FetchMetrics::ENDPOINT_FLIGHT);
+SnapshotGate FlightDataManager::gate;
+FlightRecord FlightDataManager::last = {false, "", "", "", ""};
+
+// Copy a string field into a fixed buffer, "?" when it's missing, empty or "null".
+// Returns true when a real value was copied.
+static bool copyField(char *dst, size_t size, JsonVariantConst value)
+{
+    const char *text = value.as<const char *>();
+    bool present = text && *text && strcmp(text, "null") != 0;
+    if (!present)
+    {
+        text = "?";
+    }
+    strncpy(dst, text, size - 1);
+    dst[size - 1] = '\0';
+    return present;
+}
+
+// Everything drawFlight() shows, plus the screen epoch so a wiped screen
+// always gets redrawn
+static uint64_t hashRecord(const FlightRecord &record)
+{
+    SnapshotHash hash;
+    hash.add((uint32_t)record.available)
+        .add(record.callsign)
+        .add(record.origin)
+        .add(record.destination)
+        .add(record.aircraft)
+        .add(DisplayManager::screenEpoch());
+    return hash.result();
+}
+
+// Only keep the fields the display uses
+void FlightDataManager::buildFilter(JsonDocument &filter)
+{
+    filter["flightDataAvailable"] = true;
+    filter["callsign"] = true;
+    filter["originAirportIata"] = true;
+    filter["destinationAirportIata"] = true;
+    filter["aircraftCode"] = true;
+}
+
+void FlightDataManager::parseRecord(const JsonDocument &doc, FlightRecord &record)
+{
+    record.available = false;
+    strcpy(record.callsign, "?");
+    strcpy(record.origin, "?");
+    strcpy(record.destination, "?");
+    strcpy(record.aircraft, "?");
+
+    for (JsonPairConst field : doc.as<JsonObjectConst>())
+    {
+        const char *key = field.key().c_str();
+        if (strcmp(key, "callsign") == 0)
+        {
+            record.available = copyField(record.callsign, sizeof(record.callsign), field.value());
+        }
+        else if (strcmp(key, "originAirportIata") == 0)
+        {
+            copyField(record.origin, sizeof(record.origin), field.value());
+        }
+        else if (strcmp(key, "destinationAirportIata") == 0)
+        {
+            copyField(record.destination, sizeof(record.destination), field.value());
+        }
+        else if (strcmp(key, "aircraftCode") == 0)
+        {
+            copyField(record.aircraft, sizeof(record.aircraft), field.value());
+        }
+    }
+}
 
 bool FlightDataManager::fetchData()
 {
-    Serial.println("Attempting to fetch data from URL: " + String(API_URL));
-    httpClient.begin(API_URL);
-    int httpCode = httpClient.GET();
-    Serial.print("HTTP GET request sent. Response code: ");
-    Serial.println(httpCode);
+    FT_PROFILE_ZONE("flight fetch");
+    FT_LOGD(TAG, "Attempting to fetch data from URL: %s", API_URL);
+    int httpCode = http.get(API_URL);
+    FT_LOGD(TAG, "HTTP GET request sent. Response code: %d", httpCode);
+    if (http.timer().reached(FetchMetrics::STAGE_CONNECT))
+    {
+        CpuGovernor::noteHandshake(http.timer().stageMs(FetchMetrics::STAGE_CONNECT));
+    }
 
     if (httpCode > 0)
     {
-        String payload = httpClient.getString();
-        httpClient.end();
-        JsonDocument doc;
+        JsonArena::reset();
+
+        JsonDocument filter(JsonArena::allocator());
+        buildFilter(filter);
 
-        DeserializationError error = deserializeJson(doc, payload);
+        JsonDocument doc(JsonArena::allocator());
+        DeserializationError error;
+        {
+            // Streamed from the socket, so this includes the body transfer
+            FT_PROFILE_ZONE("flight json");
+            error = deserializeJson(doc, http.body(), DeserializationOption::Filter(filter));
+        }
+        http.end(!error);
+        JsonArena::report("Flight");
         if (error)
         {
-            Serial.print(F("deserializeJson() failed: "));
-            Serial.println(error.c_str());
+            FT_LOGE(TAG, "deserializeJson() failed: %s", error.c_str());
             return false;
         }
-        Serial.println("JSON parsing successful.");
+        FT_LOGD(TAG, "JSON parsing successful.");
 
         // Check if flight data is actually available
         if (doc["flightDataAvailable"].is<bool>() && doc["flightDataAvailable"].as<bool>() == false)
         {
-            Serial.println("No flight data available according to API.");
+            FT_LOGI(TAG, "No flight data available according to API.");
+        }
+
+        FlightRecord record;
+        parseRecord(doc, record);
+        if (gate.changed(hashRecord(record)))
+        {
+            DisplayManager::displayFlightData(record);
+            last = record;
+            // A flight change clears the screen; don't count that as new content next time
+            gate.settle(hashRecord(record));
+        }
+        else
+        {
+            FT_LOGD(TAG, "Flight snapshot unchanged, render skipped.");
         }
-        DisplayManager::displayFlightData(doc);
+        FT_LOGD(TAG, "Flight snapshots: %u applied, %u suppressed",
+                (unsigned)gate.appliedCount(), (unsigned)gate.suppressedCount());
 
         return true;
     }
     else
     {
-        Serial.print("HTTP GET request failed, error: ");
-        Serial.println(httpClient.errorToString(httpCode).c_str());
-        httpClient.end();
+        FT_LOGW(TAG, "HTTP GET request failed, error: %s", HTTPClient::errorToString(httpCode).c_str());
+        http.end(false);
         return false;
     }
 }
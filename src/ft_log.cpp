@@ -0,0 +1,365 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include "ft_log.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+static const uint32_t TASK_STACK = 2048;
+static TaskHandle_t drainTask = nullptr;
+#elif defined(FT_SIM)
+// Virtual time from the desktop simulator (host/)
+#include <Arduino.h>
+#else
+#include <chrono>
+static unsigned long millis()
+{
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return (unsigned long)duration_cast<milliseconds>(steady_clock::now() - start).count();
+}
+#endif
+
+// Bounded multi-producer ring (Vyukov's scheme). Every write takes a ticket;
+// ticket t uses slot t % SLOTS. A slot's `seq` says which lap it is in:
+// free for lap L when seq == L, filled when seq == L + 1. Laps are counted
+// in tickets (L = t - t % SLOTS), so an all-zero ring is a valid empty one
+// and writes before begin() are fine.
+struct LogSlot
+{
+    std::atomic<uint32_t> seq;
+    uint32_t ms;
+    const char *tag; // nullptr: `text` is a token and its arguments
+    uint8_t level;
+    uint8_t len;
+    char text[Log::LINE_SIZE];
+};
+
+static LogSlot slots[Log::SLOTS];
+static std::atomic<uint32_t> head(0); // next ticket to write
+static std::atomic<uint32_t> tail(0); // next ticket to drain
+static std::atomic<uint32_t> written(0);
+static std::atomic<uint32_t> dropped(0);
+static std::atomic<uint32_t> truncated(0);
+// Drops already reported by the drain
+static std::atomic<uint32_t> droppedShown(0);
+
+static void serialSink(const char *text, size_t len)
+{
+#ifdef ARDUINO
+    Serial.write((const uint8_t *)text, len);
+#else
+    fwrite(text, 1, len, stdout);
+#endif
+}
+
+static Log::Sink sink = serialSink;
+
+static uint32_t lapOf(uint32_t ticket)
+{
+    return ticket - ticket % Log::SLOTS;
+}
+
+#ifdef ARDUINO
+static void drainLoop(void *param)
+{
+    (void)param;
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        Log::drain();
+    }
+}
+#endif
+
+void Log::begin(Sink output)
+{
+    if (output)
+    {
+        sink = output;
+    }
+#ifdef ARDUINO
+    if (!drainTask)
+    {
+        // Below loopTask: lines go out when the loop is waiting anyway.
+        // Same name as Telemetry::TASK_NAMES so its stack shows up in the report.
+        xTaskCreate(drainLoop, "log", TASK_STACK, nullptr, 0, &drainTask);
+        // Anything queued before the task existed
+        xTaskNotifyGive(drainTask);
+    }
+#endif
+}
+
+// Take the next free slot, or count a drop and return nullptr
+static LogSlot *claim(uint32_t &ticket)
+{
+    ticket = head.load(std::memory_order_relaxed);
+    while (true)
+    {
+        LogSlot *slot = &slots[ticket % Log::SLOTS];
+        int32_t diff = (int32_t)(slot->seq.load(std::memory_order_acquire) - lapOf(ticket));
+        if (diff == 0)
+        {
+            if (head.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed))
+            {
+                slot->ms = millis();
+                return slot;
+            }
+        }
+        else if (diff < 0)
+        {
+            // Still holds a line from the previous lap: full
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        else
+        {
+            ticket = head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// Hand a filled slot to the drain
+static void publish(LogSlot *slot, uint32_t ticket)
+{
+    slot->seq.store(lapOf(ticket) + 1, std::memory_order_release);
+    written.fetch_add(1, std::memory_order_relaxed);
+#ifdef ARDUINO
+    if (drainTask)
+    {
+        xTaskNotifyGive(drainTask);
+    }
+#endif
+}
+
+void Log::write(uint8_t level, const char *tag, const char *format, ...)
+{
+    uint32_t ticket;
+    LogSlot *slot = claim(ticket);
+    if (!slot)
+    {
+        return;
+    }
+    slot->tag = tag;
+    slot->level = level;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(slot->text, LINE_SIZE, format, args);
+    va_end(args);
+    if (n < 0)
+    {
+        n = 0;
+    }
+    else if (n >= LINE_SIZE)
+    {
+        n = LINE_SIZE - 1;
+        truncated.fetch_add(1, std::memory_order_relaxed);
+    }
+    slot->len = (uint8_t)n;
+    publish(slot, ticket);
+}
+
+#ifdef FT_LOG_TOKENIZED
+void Log::ArgWriter::varint(uint64_t value)
+{
+    do
+    {
+        if (p == end)
+        {
+            cut = true;
+            return;
+        }
+        uint8_t b = value & 0x7F;
+        value >>= 7;
+        *p++ = value ? b | 0x80 : b;
+    } while (value);
+}
+
+void Log::ArgWriter::put(float value)
+{
+    if (end - p < 4)
+    {
+        cut = true;
+        p = end;
+        return;
+    }
+    uint32_t bits;
+    memcpy(&bits, &value, 4);
+    for (int i = 0; i < 4; i++)
+    {
+        *p++ = (uint8_t)(bits >> (8 * i));
+    }
+}
+
+void Log::ArgWriter::put(const char *text)
+{
+    if (p == end)
+    {
+        cut = true;
+        return;
+    }
+    size_t len = text ? strlen(text) : 0;
+    size_t room = end - p - 1;
+    if (len > room || len > 0xFF)
+    {
+        len = room < 0xFF ? room : 0xFF;
+        cut = true;
+    }
+    *p++ = (uint8_t)len;
+    memcpy(p, text, len);
+    p += len;
+}
+
+void Log::writeBinary(uint32_t token, const uint8_t *args, size_t len, bool cut)
+{
+    uint32_t ticket;
+    LogSlot *slot = claim(ticket);
+    if (!slot)
+    {
+        return;
+    }
+    slot->tag = nullptr;
+    slot->level = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        slot->text[i] = (char)(token >> (8 * i));
+    }
+    if (len > LINE_SIZE - 4)
+    {
+        len = LINE_SIZE - 4;
+    }
+    memcpy(slot->text + 4, args, len);
+    slot->len = (uint8_t)(4 + len);
+    if (cut)
+    {
+        truncated.fetch_add(1, std::memory_order_relaxed);
+    }
+    publish(slot, ticket);
+}
+#endif
+
+// Token, timestamp varint, arguments and a check byte, COBS-encoded between
+// two zero bytes so the decoder can pick frames out of plain text
+static size_t encodeFrame(const LogSlot *slot, char *out, size_t size)
+{
+    uint8_t payload[Log::LINE_SIZE + 8];
+    size_t n = 0;
+    memcpy(payload, slot->text, 4);
+    n += 4;
+    uint32_t ms = slot->ms;
+    do
+    {
+        uint8_t b = ms & 0x7F;
+        ms >>= 7;
+        payload[n++] = ms ? b | 0x80 : b;
+    } while (ms);
+    memcpy(payload + n, slot->text + 4, slot->len - 4);
+    n += slot->len - 4;
+    uint8_t check = 0xA5;
+    for (size_t i = 0; i < n; i++)
+    {
+        check ^= payload[i];
+    }
+    payload[n++] = check;
+
+    // COBS: each block is a length byte and up to 254 non-zero bytes
+    size_t len = 0;
+    out[len++] = 0;
+    size_t code = len++;
+    uint8_t run = 1;
+    for (size_t i = 0; i < n && len + 2 < size; i++)
+    {
+        if (payload[i] == 0)
+        {
+            out[code] = (char)run;
+            code = len++;
+            run = 1;
+            continue;
+        }
+        out[len++] = (char)payload[i];
+        if (++run == 0xFF)
+        {
+            out[code] = (char)run;
+            code = len++;
+            run = 1;
+        }
+    }
+    out[code] = (char)run;
+    out[len++] = 0;
+    return len;
+}
+
+size_t Log::drain(size_t maxLines)
+{
+    size_t moved = 0;
+    // Prefix, tag and message, cut to fit with the newline kept
+    char line[LINE_SIZE + 40];
+    while (moved < maxLines)
+    {
+        uint32_t total = dropped.load(std::memory_order_relaxed);
+        uint32_t shown = droppedShown.exchange(total, std::memory_order_relaxed);
+        if (total != shown)
+        {
+            int n = snprintf(line, sizeof(line), "[log] %u lines dropped\n", (unsigned)(total - shown));
+            sink(line, (size_t)n);
+        }
+
+        uint32_t ticket = tail.load(std::memory_order_relaxed);
+        LogSlot *slot = &slots[ticket % SLOTS];
+        int32_t diff = (int32_t)(slot->seq.load(std::memory_order_acquire) - (lapOf(ticket) + 1));
+        if (diff < 0)
+        {
+            break; // empty
+        }
+        // flush() and the drain task may both be here
+        if (diff > 0 || !tail.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed))
+        {
+            continue;
+        }
+
+        size_t len;
+        if (!slot->tag)
+        {
+            len = encodeFrame(slot, line, sizeof(line));
+        }
+        else
+        {
+            int n = snprintf(line, sizeof(line), "[%5lu.%03lu] %c %s: ", (unsigned long)(slot->ms / 1000),
+                             (unsigned long)(slot->ms % 1000), levelLetter(slot->level), slot->tag);
+            len = n > 0 && (size_t)n < sizeof(line) ? (size_t)n : 0;
+            size_t room = sizeof(line) - 1 - len;
+            size_t text = slot->len < room ? slot->len : room;
+            memcpy(line + len, slot->text, text);
+            len += text;
+            line[len++] = '\n';
+        }
+        // The slot is free for the next lap once copied out
+        slot->seq.store(lapOf(ticket) + SLOTS, std::memory_order_release);
+
+        sink(line, len);
+        moved++;
+    }
+    return moved;
+}
+
+void Log::flush()
+{
+    while (drain() > 0)
+    {
+    }
+#ifdef ARDUINO
+    Serial.flush();
+#endif
+}
+
+Log::Stats Log::stats()
+{
+    return {written.load(std::memory_order_relaxed), dropped.load(std::memory_order_relaxed),
+            truncated.load(std::memory_order_relaxed)};
+}
+
+uint8_t Log::pending()
+{
+    return (uint8_t)(head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed));
+}
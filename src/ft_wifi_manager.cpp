@@ -1,41 +1,256 @@
 #include "ft_wifi_manager.h"
+#include "time_sync.h"
 #include "display_manager.h"
+#include <Preferences.h>
+#include <esp_attr.h>
 #include <time.h>
+#include "ft_log.h"
+#include "profiler.h"
 // #include "config.h"
 
+static constexpr char TAG[] = "wifi";
+
+// Last successful association, written only when it changes
+struct FastConnectCache
+{
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t valid;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns1;
+    uint32_t dns2;
+};
+
+static const char *CACHE_NAMESPACE = "ftwifi";
+static const char *CACHE_KEY = "fast";
+
 WiFiManager FtWiFiManager::wm;
+void (*FtWiFiManager::stateCallback)() = nullptr;
+RTC_DATA_ATTR static FtWiFiManager::ConnectStats stats;
 
-bool FtWiFiManager::connect()
+static bool loadCache(FastConnectCache &cache)
 {
-    WiFi.mode(WIFI_STA);
+    Preferences prefs;
+    if (!prefs.begin(CACHE_NAMESPACE, true))
+    {
+        return false;
+    }
+    bool ok = prefs.getBytes(CACHE_KEY, &cache, sizeof(cache)) == sizeof(cache) && cache.valid;
+    prefs.end();
+    return ok;
+}
 
-    // Testing - uncomment to clear saved WiFi credentials
-    // wm.resetSettings();
+static void storeCache(const FastConnectCache &cache)
+{
+    FastConnectCache stored;
+    if (loadCache(stored) && memcmp(&stored, &cache, sizeof(cache)) == 0)
+    {
+        return;
+    }
+    Preferences prefs;
+    if (prefs.begin(CACHE_NAMESPACE, false))
+    {
+        prefs.putBytes(CACHE_KEY, &cache, sizeof(cache));
+        prefs.end();
+    }
+}
 
-    // Set custom parameters for the config portal
-    wm.setConfigPortalTimeout(300); // 5 minutes timeout
-    wm.setAPCallback([](WiFiManager *myWiFiManager)
-                     { FtWiFiManager::displayAPInfo(myWiFiManager->getConfigPortalSSID(),
-                                                    "password", WiFi.softAPIP().toString()); });
+static void clearCache()
+{
+    Preferences prefs;
+    if (prefs.begin(CACHE_NAMESPACE, false))
+    {
+        prefs.remove(CACHE_KEY);
+        prefs.end();
+    }
+}
 
-    // Try to connect with saved credentials first
-    if (wm.autoConnect("FT-Setup", "password"))
+// Snapshot of the current association and DHCP lease
+static void rememberConnection()
+{
+    FastConnectCache cache = {};
+    const uint8_t *bssid = WiFi.BSSID();
+    if (!bssid)
     {
-        Serial.println("Connected to WiFi successfully!");
-        Serial.print("IP address: ");
-        Serial.println(WiFi.localIP());
+        return;
+    }
+    memcpy(cache.bssid, bssid, sizeof(cache.bssid));
+    cache.channel = (uint8_t)WiFi.channel();
+    cache.valid = 1;
+    cache.ip = WiFi.localIP();
+    cache.gateway = WiFi.gatewayIP();
+    cache.subnet = WiFi.subnetMask();
+    cache.dns1 = WiFi.dnsIP(0);
+    cache.dns2 = WiFi.dnsIP(1);
+    storeCache(cache);
+}
 
-        // Initialize NTP time synchronization
-        configTime(0, 0, "pool.ntp.org", "time.nist.gov");
-        Serial.println("NTP time synchronization initialized");
+// WiFiDriver on the real radio. Attempts start with the cached fast path
+// when there is one and fall back to saved credentials with DHCP.
+class EspWiFiDriver : public WiFiDriver
+{
+public:
+    EspWiFiDriver() : fastInFlight(false) {}
+
+    bool hasCredentials() override
+    {
+        WiFi.mode(WIFI_STA);
+        return FtWiFiManager::wm.getWiFiIsSaved();
+    }
 
+    unsigned long beginAttempt() override
+    {
+        WiFi.mode(WIFI_STA);
+        FastConnectCache cache;
+        if (stats.fastSinceFull < FtWiFiManager::MAX_FAST_RECONNECTS && loadCache(cache))
+        {
+            // Known channel and BSSID skip the scan, the static lease skips
+            // DHCP. Kept out of NVS so the saved config stays unlocked.
+            fastInFlight = true;
+            WiFi.persistent(false);
+            WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.subnet),
+                        IPAddress(cache.dns1), IPAddress(cache.dns2));
+            WiFi.begin(FtWiFiManager::wm.getWiFiSSID().c_str(), FtWiFiManager::wm.getWiFiPass().c_str(),
+                       cache.channel, cache.bssid);
+            WiFi.persistent(true);
+            return FtWiFiManager::FAST_CONNECT_TIMEOUT;
+        }
+        // Full path: DHCP (renewing the lease after a run of fast connects)
+        // and the saved credentials alone. WiFi.begin() without arguments
+        // would rejoin with the channel and BSSID of the last fast attempt.
+        WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+        WiFi.begin(FtWiFiManager::wm.getWiFiSSID().c_str(), FtWiFiManager::wm.getWiFiPass().c_str());
+        return FtWiFiManager::CONNECT_TIMEOUT;
+    }
+
+    bool abortAttempt() override
+    {
+        WiFi.disconnect();
+        if (!fastInFlight)
+        {
+            FT_LOGW(TAG, "WiFi attempt timed out");
+            return false;
+        }
+        FT_LOGW(TAG, "Fast connect failed, falling back to a full connect");
+        fastInFlight = false;
+        stats.fastMisses++;
+        clearCache();
         return true;
     }
-    else
+
+    bool isConnected() override
     {
-        Serial.println("Failed to connect to WiFi");
-        return false;
+        return FtWiFiManager::isConnected();
+    }
+
+    void onConnected(unsigned long attemptMs) override
+    {
+        stats.lastConnectMs = attemptMs;
+        stats.lastWasFast = fastInFlight;
+        if (fastInFlight)
+        {
+            stats.fastHits++;
+            stats.fastSinceFull++;
+        }
+        else
+        {
+            stats.fullConnects++;
+            stats.fastSinceFull = 0;
+            rememberConnection();
+        }
+        FT_LOGI(TAG, "WiFi connected to %s in %lu ms (%s path; fast %u hits, %u misses, %u full)",
+                FtWiFiManager::getLocalIP().c_str(), attemptMs, fastInFlight ? "fast" : "full",
+                (unsigned)stats.fastHits, (unsigned)stats.fastMisses, (unsigned)stats.fullConnects);
+        fastInFlight = false;
+
+        // Radio sleeps between beacons while idle; wakes for DTIM and traffic
+        WiFi.setSleep(WIFI_PS_MIN_MODEM);
+        TimeSync::request();
+    }
+
+    void beginPortal() override
+    {
+        fastInFlight = false;
+        FT_LOGI(TAG, "Opening WiFi config portal");
+        FtWiFiManager::wm.setConfigPortalBlocking(false);
+        FtWiFiManager::wm.setConfigPortalTimeout(FtWiFiManager::PORTAL_TIMEOUT_S);
+        FtWiFiManager::wm.setAPCallback([](WiFiManager *myWiFiManager)
+                                        { FtWiFiManager::displayAPInfo(myWiFiManager->getConfigPortalSSID(),
+                                                                       "password", WiFi.softAPIP().toString()); });
+        FtWiFiManager::wm.startConfigPortal("FT-Setup", "password");
     }
+
+    bool processPortal() override
+    {
+        FtWiFiManager::wm.process();
+        return FtWiFiManager::wm.getConfigPortalActive();
+    }
+
+    void powerOff() override
+    {
+        fastInFlight = false;
+        WiFi.disconnect(true);
+    }
+
+private:
+    bool fastInFlight;
+};
+
+static EspWiFiDriver espDriver;
+WiFiLink FtWiFiManager::wifiLink(espDriver);
+
+void FtWiFiManager::begin(bool radioOn)
+{
+    // Testing - uncomment to clear saved WiFi credentials
+    // wm.resetSettings();
+    wifiLink.begin(millis(), radioOn);
+}
+
+void FtWiFiManager::update()
+{
+    wifiLink.update(millis());
+}
+
+void FtWiFiManager::request()
+{
+    wifiLink.request(millis());
+}
+
+void FtWiFiManager::park()
+{
+    wifiLink.park();
+}
+
+void FtWiFiManager::openPortal()
+{
+    wifiLink.openPortal(millis());
+}
+
+bool FtWiFiManager::isPortalOpen()
+{
+    return wifiLink.state() == WiFiLink::LINK_PORTAL;
+}
+
+bool FtWiFiManager::isBusy()
+{
+    return wifiLink.isBusy();
+}
+
+unsigned long FtWiFiManager::millisUntilNextStep()
+{
+    return wifiLink.millisUntilNextStep(millis());
+}
+
+const FtWiFiManager::ConnectStats &FtWiFiManager::connectStats()
+{
+    return stats;
+}
+
+bool FtWiFiManager::isRadioOff()
+{
+    return wifiLink.state() == WiFiLink::LINK_OFF;
 }
 
 bool FtWiFiManager::isConnected()
@@ -55,9 +270,42 @@ String FtWiFiManager::getLocalIP()
 
 long FtWiFiManager::getRSSI()
 {
+    FT_PROFILE_ZONE("wifi rssi");
     return WiFi.RSSI();
 }
 
+void FtWiFiManager::setStateCallback(void (*callback)())
+{
+    stateCallback = callback;
+    WiFi.onEvent(onWiFiEvent, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    WiFi.onEvent(onWiFiEvent, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+}
+
+// On the WiFi event task. The driver raises DISCONNECTED for every failed
+// association as well, so only a change of link state wakes the loop.
+void FtWiFiManager::onWiFiEvent(arduino_event_id_t event)
+{
+    static volatile bool up = false;
+    bool changed = false;
+    switch (event)
+    {
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+        changed = !up;
+        up = true;
+        break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+        changed = up;
+        up = false;
+        break;
+    default:
+        break;
+    }
+    if (changed && stateCallback)
+    {
+        stateCallback();
+    }
+}
+
 void FtWiFiManager::displayAPInfo(const String &apName, const String &password, const String &ip)
 {
     DisplayManager::displayAPInfo(apName, password, ip);
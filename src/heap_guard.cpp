@@ -0,0 +1,241 @@
+#ifdef FT_HEAP_GUARD
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <new>
+#include "ft_log.h"
+#include "heap_guard.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_rom_sys.h>
+#define GUARD_PRINTF esp_rom_printf // ROM printf, safe inside the allocator
+#else
+#include <stdio.h>
+#define GUARD_PRINTF(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+static constexpr char TAG[] = "heap";
+
+extern "C"
+{
+    void *__real_malloc(size_t size);
+    void *__real_calloc(size_t count, size_t size);
+    void *__real_realloc(void *ptr, size_t size);
+    void __real_free(void *ptr);
+}
+
+static bool booted = false;
+static bool inHook = false;
+#ifdef ARDUINO
+// Only the task that marked boot complete (the loop task) is policed; the
+// WiFi and lwIP tasks allocate by design
+static TaskHandle_t ownerTask = nullptr;
+#endif
+
+static const char *currentTag = "untagged";
+static bool currentAllow = false;
+
+static HeapGuard::Site sites[HeapGuard::MAX_SITES];
+static uint8_t sitesUsed = 0;
+static uint8_t sitesReported = 0;
+static uint32_t violationCount = 0;
+static uint32_t allowedCount = 0;
+static uint32_t droppedSites = 0;
+
+HeapGuard::Tag::Tag(const char *name, bool allow)
+    : previousTag(currentTag), previousAllow(currentAllow)
+{
+    currentTag = name;
+    // An Allow inside another Allow stays allowed; a plain Tag inside an Allow too
+    currentAllow = allow || previousAllow;
+}
+
+HeapGuard::Tag::~Tag()
+{
+    currentTag = previousTag;
+    currentAllow = previousAllow;
+}
+
+void HeapGuard::markBootComplete()
+{
+#ifdef ARDUINO
+    ownerTask = xTaskGetCurrentTaskHandle();
+#endif
+    booted = true;
+    FT_LOGI(TAG, "HeapGuard: boot complete, loop allocations are now checked");
+}
+
+bool HeapGuard::bootComplete()
+{
+    return booted;
+}
+
+uint32_t HeapGuard::violations()
+{
+    return violationCount;
+}
+
+uint32_t HeapGuard::allowedAllocations()
+{
+    return allowedCount;
+}
+
+uint8_t HeapGuard::siteCount()
+{
+    return sitesUsed;
+}
+
+const HeapGuard::Site &HeapGuard::site(uint8_t index)
+{
+    return sites[index];
+}
+
+void HeapGuard::onAllocate(size_t size, const void *caller)
+{
+    if (!booted || inHook)
+    {
+        return;
+    }
+#ifdef ARDUINO
+    if (xTaskGetCurrentTaskHandle() != ownerTask)
+    {
+        return;
+    }
+#endif
+    if (currentAllow)
+    {
+        allowedCount++;
+        return;
+    }
+
+    inHook = true;
+    violationCount++;
+
+#ifdef FT_HEAP_GUARD_ABORT
+    GUARD_PRINTF("HeapGuard: %u B allocated from %p [%s] after boot\n", (unsigned)size, caller, currentTag);
+    abort();
+#endif
+
+    uint8_t i = 0;
+    while (i < sitesUsed && !(sites[i].caller == caller && sites[i].tag == currentTag))
+    {
+        i++;
+    }
+    if (i < sitesUsed)
+    {
+        sites[i].count++;
+    }
+    else if (sitesUsed < MAX_SITES)
+    {
+        sites[sitesUsed++] = {caller, currentTag, (uint32_t)size, 1};
+    }
+    else
+    {
+        droppedSites++;
+    }
+    inHook = false;
+}
+
+void HeapGuard::report()
+{
+    if (sitesReported == sitesUsed)
+    {
+        return;
+    }
+
+    // Formatting may allocate itself (newlib's vsnprintf can)
+    Allow allow("heap guard report");
+    for (; sitesReported < sitesUsed; sitesReported++)
+    {
+        const Site &s = sites[sitesReported];
+        FT_LOGW(TAG, "HeapGuard: new site 0x%lx [%s], %u B", (unsigned long)(uintptr_t)s.caller, s.tag,
+                (unsigned)s.size);
+    }
+    FT_LOGW(TAG, "HeapGuard: %u violations at %u sites (%u not recorded), %u allowed", (unsigned)violationCount,
+            (unsigned)sitesUsed, (unsigned)droppedSites, (unsigned)allowedCount);
+}
+
+// Link-time wrappers, enabled by -Wl,--wrap=malloc etc.
+extern "C"
+{
+    void *__wrap_malloc(size_t size)
+    {
+        HeapGuard::onAllocate(size, __builtin_return_address(0));
+        return __real_malloc(size);
+    }
+
+    void *__wrap_calloc(size_t count, size_t size)
+    {
+        HeapGuard::onAllocate(count * size, __builtin_return_address(0));
+        return __real_calloc(count, size);
+    }
+
+    void *__wrap_realloc(void *ptr, size_t size)
+    {
+        HeapGuard::onAllocate(size, __builtin_return_address(0));
+        return __real_realloc(ptr, size);
+    }
+
+    void __wrap_free(void *ptr)
+    {
+        __real_free(ptr);
+    }
+}
+
+// new/delete go straight to the real allocator so each one is counted once,
+// against the code that called new
+static void *guardedNew(size_t size, const void *caller)
+{
+    HeapGuard::onAllocate(size, caller);
+    void *ptr = __real_malloc(size ? size : 1);
+    if (!ptr)
+    {
+        abort();
+    }
+    return ptr;
+}
+
+void *operator new(size_t size)
+{
+    return guardedNew(size, __builtin_return_address(0));
+}
+
+void *operator new[](size_t size)
+{
+    return guardedNew(size, __builtin_return_address(0));
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    HeapGuard::onAllocate(size, __builtin_return_address(0));
+    return __real_malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    HeapGuard::onAllocate(size, __builtin_return_address(0));
+    return __real_malloc(size ? size : 1);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    __real_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    __real_free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    __real_free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    __real_free(ptr);
+}
+
+#endif // FT_HEAP_GUARD
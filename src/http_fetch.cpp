@@ -0,0 +1,110 @@
+#include <WiFi.h>
+#include "http_fetch.h"
+#include "ft_log.h"
+
+static constexpr char TAG[] = "fetch";
+
+// Split "scheme://host[:port]/..." into its host and port. False if the
+// URL isn't http or https or the host doesn't fit.
+static bool parseUrl(const char *url, char *host, size_t hostSize, uint16_t &port, bool &tls)
+{
+    if (strncmp(url, "https://", 8) == 0)
+    {
+        tls = true;
+        port = 443;
+        url += 8;
+    }
+    else if (strncmp(url, "http://", 7) == 0)
+    {
+        tls = false;
+        port = 80;
+        url += 7;
+    }
+    else
+    {
+        return false;
+    }
+
+    size_t len = strcspn(url, ":/?");
+    if (len == 0 || len >= hostSize)
+    {
+        return false;
+    }
+    memcpy(host, url, len);
+    host[len] = '\0';
+    if (url[len] == ':')
+    {
+        port = (uint16_t)strtoul(url + len + 1, nullptr, 10);
+    }
+    return true;
+}
+
+HttpFetch::HttpFetch(FetchMetrics::Endpoint endpoint) : endpoint(endpoint), status(0)
+{
+}
+
+int HttpFetch::get(const char *url)
+{
+    stages.start(millis());
+    status = HTTPC_ERROR_CONNECTION_REFUSED;
+
+    char host[MAX_HOST];
+    uint16_t port;
+    bool tls;
+    if (!parseUrl(url, host, sizeof(host), port, tls))
+    {
+        return status;
+    }
+
+    // lwIP caches the answer, so the lookup inside connect() below is free
+    IPAddress address;
+    if (!WiFi.hostByName(host, address))
+    {
+        return status;
+    }
+    stages.mark(FetchMetrics::STAGE_DNS, millis());
+
+    WiFiClient *client = &plain;
+    if (tls)
+    {
+        // Same as HTTPClient::begin(url) without a CA: encrypted, not authenticated
+        secure.setInsecure();
+        client = &secure;
+    }
+    // By name rather than address so TLS sends SNI
+    if (!client->connect(host, port))
+    {
+        return status;
+    }
+    stages.mark(FetchMetrics::STAGE_CONNECT, millis());
+
+    // HTTP/1.0 avoids chunked encoding, so the body can be parsed straight off the socket
+    http.useHTTP10(true);
+    // HTTPClient reuses a client that is already connected
+    http.begin(*client, url);
+    status = http.GET();
+    if (status > 0)
+    {
+        stages.mark(FetchMetrics::STAGE_FIRST_BYTE, millis());
+    }
+    return status;
+}
+
+void HttpFetch::end(bool ok)
+{
+    if (status > 0)
+    {
+        stages.mark(FetchMetrics::STAGE_BODY, millis());
+    }
+    http.end();
+    plain.stop();
+    secure.stop();
+    FetchMetrics::record(endpoint, stages, ok, status);
+
+    FT_LOGI(TAG, "Fetch %s: dns %u, connect %u, first byte %u, body %u, total %u ms",
+            FetchMetrics::endpointName(endpoint), (unsigned)stages.stageMs(FetchMetrics::STAGE_DNS),
+            (unsigned)stages.stageMs(FetchMetrics::STAGE_CONNECT),
+            (unsigned)stages.stageMs(FetchMetrics::STAGE_FIRST_BYTE),
+            (unsigned)stages.stageMs(FetchMetrics::STAGE_BODY),
+            (unsigned)stages.stageMs(FetchMetrics::STAGE_TOTAL));
+}
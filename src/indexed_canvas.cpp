@@ -0,0 +1,379 @@
+#include <string.h>
+#include "indexed_canvas.h"
+
+IndexedCanvas::IndexedCanvas(int16_t w, int16_t h)
+    : Adafruit_GFX(w < MAX_WIDTH ? w : MAX_WIDTH, h < MAX_HEIGHT ? h : MAX_HEIGHT),
+      paletteUsed(2), lastColorIndex(0), counters()
+{
+    memset(pixels, 0, sizeof(pixels));
+    memset(palette, 0, sizeof(palette));
+    palette[0] = ST77XX_BLACK;
+    palette[ACCENT_INDEX] = ST77XX_GREEN;
+    rebuildLut();
+    markAllDirty();
+}
+
+void IndexedCanvas::rebuildLut()
+{
+    for (int b = 0; b < 256; b++)
+    {
+        pairLut[b] = (uint32_t)palette[b >> 4] | ((uint32_t)palette[b & 0x0F] << 16);
+    }
+}
+
+void IndexedCanvas::setPaletteEntry(uint8_t index, uint16_t color)
+{
+    palette[index] = color;
+    for (int b = 0; b < 256; b++)
+    {
+        if ((b >> 4) == index || (b & 0x0F) == index)
+        {
+            pairLut[b] = (uint32_t)palette[b >> 4] | ((uint32_t)palette[b & 0x0F] << 16);
+        }
+    }
+}
+
+uint8_t IndexedCanvas::colorIndex(uint16_t color)
+{
+    if (palette[lastColorIndex] == color)
+    {
+        return lastColorIndex;
+    }
+
+    // Accent first so the current mode colour always lands in the swappable slot
+    if (palette[ACCENT_INDEX] == color)
+    {
+        return lastColorIndex = ACCENT_INDEX;
+    }
+    for (uint8_t i = 0; i < paletteUsed; i++)
+    {
+        if (palette[i] == color)
+        {
+            return lastColorIndex = i;
+        }
+    }
+
+    if (paletteUsed < PALETTE_SIZE)
+    {
+        setPaletteEntry(paletteUsed, color);
+        return lastColorIndex = paletteUsed++;
+    }
+
+    // Palette full: fall back to the nearest existing colour
+    uint8_t best = 0;
+    uint32_t bestDistance = UINT32_MAX;
+    for (uint8_t i = 0; i < PALETTE_SIZE; i++)
+    {
+        int dr = ((palette[i] >> 11) & 0x1F) - ((color >> 11) & 0x1F);
+        int dg = ((palette[i] >> 5) & 0x3F) - ((color >> 5) & 0x3F);
+        int db = (palette[i] & 0x1F) - (color & 0x1F);
+        uint32_t distance = (uint32_t)(4 * dr * dr + dg * dg + 4 * db * db);
+        if (distance < bestDistance)
+        {
+            bestDistance = distance;
+            best = i;
+        }
+    }
+    return best;
+}
+
+void IndexedCanvas::setAccent(uint16_t color)
+{
+    if (palette[ACCENT_INDEX] != color)
+    {
+        swapColor(palette[ACCENT_INDEX], color);
+    }
+}
+
+void IndexedCanvas::swapColor(uint16_t from, uint16_t to)
+{
+    // Look the slot up without allocating one for `from`
+    uint8_t index = PALETTE_SIZE;
+    if (palette[ACCENT_INDEX] == from)
+    {
+        index = ACCENT_INDEX;
+    }
+    for (uint8_t i = 0; i < paletteUsed && index == PALETTE_SIZE; i++)
+    {
+        if (palette[i] == from)
+        {
+            index = i;
+        }
+    }
+    if (index == PALETTE_SIZE || from == to)
+    {
+        return;
+    }
+
+    setPaletteEntry(index, to);
+
+    // Only rows that actually contain the slot need to go out again
+    for (int16_t y = 0; y < _height; y++)
+    {
+        int16_t first = -1;
+        int16_t last = -1;
+        for (int16_t x = 0; x < _width; x++)
+        {
+            if (indexAt(x, y) == index)
+            {
+                if (first < 0)
+                {
+                    first = x;
+                }
+                last = x;
+            }
+        }
+        if (first >= 0)
+        {
+            markDirty(first, last, y);
+        }
+    }
+}
+
+void IndexedCanvas::markDirty(int16_t x0, int16_t x1, int16_t y)
+{
+    if (rowMin[y] == CLEAN || x0 < rowMin[y])
+    {
+        rowMin[y] = x0;
+    }
+    if (rowMax[y] == CLEAN || x1 > rowMax[y])
+    {
+        rowMax[y] = x1;
+    }
+    if (y < dirtyTop)
+    {
+        dirtyTop = y;
+    }
+    if (y > dirtyBottom)
+    {
+        dirtyBottom = y;
+    }
+}
+
+void IndexedCanvas::markAllDirty()
+{
+    for (int16_t y = 0; y < _height; y++)
+    {
+        rowMin[y] = 0;
+        rowMax[y] = _width - 1;
+    }
+    dirtyTop = 0;
+    dirtyBottom = _height - 1;
+}
+
+uint8_t IndexedCanvas::indexAt(int16_t x, int16_t y) const
+{
+    uint8_t b = pixels[(y * _width + x) >> 1];
+    return (x & 1) ? (b & 0x0F) : (b >> 4);
+}
+
+bool IndexedCanvas::fillSpan(int16_t x, int16_t y, int16_t w, uint8_t index)
+{
+    uint8_t *row = &pixels[(y * _width) >> 1];
+    uint8_t pair = (index << 4) | index;
+    int16_t end = x + w;
+    bool changed = false;
+
+    if (x & 1)
+    {
+        uint8_t b = (row[x >> 1] & 0xF0) | index;
+        changed |= b != row[x >> 1];
+        row[x >> 1] = b;
+        x++;
+    }
+    for (; x + 1 < end; x += 2)
+    {
+        changed |= row[x >> 1] != pair;
+        row[x >> 1] = pair;
+    }
+    if (x < end)
+    {
+        uint8_t b = (row[x >> 1] & 0x0F) | (index << 4);
+        changed |= b != row[x >> 1];
+        row[x >> 1] = b;
+    }
+    return changed;
+}
+
+void IndexedCanvas::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+    if (x < 0 || y < 0 || x >= _width || y >= _height)
+    {
+        return;
+    }
+    uint8_t index = colorIndex(color);
+    uint8_t &b = pixels[(y * _width + x) >> 1];
+    uint8_t updated = (x & 1) ? ((b & 0xF0) | index) : ((b & 0x0F) | (index << 4));
+    // Redrawing identical content (borders, erase passes) must not cost a flush
+    if (updated != b)
+    {
+        b = updated;
+        markDirty(x, x, y);
+    }
+}
+
+void IndexedCanvas::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    if (w < 0)
+    {
+        x += w + 1;
+        w = -w;
+    }
+    if (h < 0)
+    {
+        y += h + 1;
+        h = -h;
+    }
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if (x + w > _width)
+    {
+        w = _width - x;
+    }
+    if (y + h > _height)
+    {
+        h = _height - y;
+    }
+    if (w <= 0 || h <= 0)
+    {
+        return;
+    }
+
+    uint8_t index = colorIndex(color);
+    for (int16_t row = y; row < y + h; row++)
+    {
+        if (fillSpan(x, row, w, index))
+        {
+            markDirty(x, x + w - 1, row);
+        }
+    }
+}
+
+void IndexedCanvas::writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    writeFillRect(x, y, w, 1, color);
+}
+
+void IndexedCanvas::writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    writeFillRect(x, y, 1, h, color);
+}
+
+void IndexedCanvas::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    writeFillRect(x, y, w, 1, color);
+}
+
+void IndexedCanvas::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    writeFillRect(x, y, 1, h, color);
+}
+
+void IndexedCanvas::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    writeFillRect(x, y, w, h, color);
+}
+
+void IndexedCanvas::fillScreen(uint16_t color)
+{
+    uint8_t pair = (colorIndex(color) << 4) | colorIndex(color);
+    size_t bytes = bufferBytes(_width, _height);
+    for (size_t i = 0; i < bytes; i++)
+    {
+        if (pixels[i] != pair)
+        {
+            memset(pixels, pair, bytes);
+            markAllDirty();
+            return;
+        }
+    }
+}
+
+void IndexedCanvas::expandRow(int16_t y, int16_t x0, int16_t x1, uint16_t *out) const
+{
+    const uint8_t *row = &pixels[(y * _width) >> 1];
+    int16_t x = x0;
+
+    if (x & 1)
+    {
+        *out++ = palette[row[x >> 1] & 0x0F];
+        x++;
+    }
+    for (; x + 1 <= x1; x += 2)
+    {
+        // memcpy keeps the 32-bit store legal when `out` isn't word aligned
+        memcpy(out, &pairLut[row[x >> 1]], sizeof(uint32_t));
+        out += 2;
+    }
+    if (x == x1)
+    {
+        *out = palette[row[x >> 1] >> 4];
+    }
+}
+
+uint32_t IndexedCanvas::flush(St77xxPanel &panel)
+{
+    if (!isDirty())
+    {
+        return 0;
+    }
+
+    uint32_t sent = 0;
+    panel.beginFrame();
+
+    // Consecutive dirty rows form a band sent through one address window
+    int16_t y = dirtyTop;
+    while (y <= dirtyBottom)
+    {
+        if (rowMin[y] == CLEAN)
+        {
+            y++;
+            continue;
+        }
+
+        int16_t top = y;
+        int16_t x0 = rowMin[y];
+        int16_t x1 = rowMax[y];
+        while (y + 1 <= dirtyBottom && rowMin[y + 1] != CLEAN)
+        {
+            y++;
+            if (rowMin[y] < x0)
+            {
+                x0 = rowMin[y];
+            }
+            if (rowMax[y] > x1)
+            {
+                x1 = rowMax[y];
+            }
+        }
+
+        int16_t w = x1 - x0 + 1;
+        panel.setAddrWindow(x0, top, w, y - top + 1);
+        for (int16_t row = top; row <= y; row++)
+        {
+            expandRow(row, x0, x1, line);
+            panel.pushPixels(line, w);
+            rowMin[row] = CLEAN;
+            rowMax[row] = CLEAN;
+        }
+        sent += (uint32_t)w * (y - top + 1);
+        counters.bands++;
+        y++;
+    }
+
+    panel.endFrame();
+
+    dirtyTop = _height;
+    dirtyBottom = -1;
+    counters.flushes++;
+    counters.pixels += sent;
+    return sent;
+}
@@ -0,0 +1,136 @@
+#include <Arduino.h>
+#include <string.h>
+#include "json_arena.h"
+#include "ft_log.h"
+
+static constexpr char TAG[] = "arena";
+
+// Every block starts with a header holding its size and the previous block,
+// so the newest block can be popped and earlier ones reached again
+struct BlockHeader
+{
+    uint32_t size;
+    uint32_t prev;
+};
+
+static const size_t ALIGN = 8;
+static const size_t HEADER = (sizeof(BlockHeader) + ALIGN - 1) & ~(ALIGN - 1);
+static const uint32_t NO_BLOCK = UINT32_MAX;
+
+alignas(ALIGN) static uint8_t arenaBuffer[JsonArena::CAPACITY];
+static size_t top = 0;
+static uint32_t lastBlock = NO_BLOCK;
+
+JsonArena::Arena JsonArena::arena;
+JsonArena::Stats JsonArena::counters = {0, 0, 0, 0};
+
+static size_t roundUp(size_t size)
+{
+    return (size + ALIGN - 1) & ~(ALIGN - 1);
+}
+
+static BlockHeader *headerOf(void *ptr)
+{
+    return (BlockHeader *)((uint8_t *)ptr - HEADER);
+}
+
+static uint32_t offsetOf(void *ptr)
+{
+    return (uint32_t)((uint8_t *)ptr - HEADER - arenaBuffer);
+}
+
+ArduinoJson::Allocator *JsonArena::allocator()
+{
+    return &arena;
+}
+
+void JsonArena::reset()
+{
+    top = 0;
+    lastBlock = NO_BLOCK;
+    counters.used = 0;
+    counters.resets++;
+}
+
+void JsonArena::report(const char *label)
+{
+    (void)label; // FT_LOGD may be compiled out
+    FT_LOGD(TAG, "%s JSON arena: %u/%u bytes, peak %u, %u overflows", label, (unsigned)counters.used,
+            (unsigned)CAPACITY, (unsigned)counters.highWater, (unsigned)counters.overflows);
+}
+
+void *JsonArena::Arena::allocate(size_t size)
+{
+    size_t need = HEADER + roundUp(size);
+    if (need > CAPACITY - top)
+    {
+        counters.overflows++;
+        return nullptr;
+    }
+
+    BlockHeader *header = (BlockHeader *)(arenaBuffer + top);
+    header->size = size;
+    header->prev = lastBlock;
+    lastBlock = top;
+    top += need;
+
+    counters.used = top;
+    if (top > counters.highWater)
+    {
+        counters.highWater = top;
+    }
+    return arenaBuffer + lastBlock + HEADER;
+}
+
+void JsonArena::Arena::deallocate(void *ptr)
+{
+    // Only the newest block can be given back; the rest goes at reset()
+    if (ptr && offsetOf(ptr) == lastBlock)
+    {
+        top = lastBlock;
+        lastBlock = headerOf(ptr)->prev;
+        counters.used = top;
+    }
+}
+
+void *JsonArena::Arena::reallocate(void *ptr, size_t newSize)
+{
+    if (!ptr)
+    {
+        return allocate(newSize);
+    }
+
+    BlockHeader *header = headerOf(ptr);
+
+    if (offsetOf(ptr) == lastBlock)
+    {
+        // Newest block: grow or shrink in place
+        size_t need = HEADER + roundUp(newSize);
+        if (need > CAPACITY - lastBlock)
+        {
+            counters.overflows++;
+            return nullptr;
+        }
+        header->size = newSize;
+        top = lastBlock + need;
+        counters.used = top;
+        if (top > counters.highWater)
+        {
+            counters.highWater = top;
+        }
+        return ptr;
+    }
+
+    if (newSize <= header->size)
+    {
+        // Shrinking an older block (shrinkToFit): keep it where it is
+        return ptr;
+    }
+
+    void *moved = allocate(newSize);
+    if (moved)
+    {
+        memcpy(moved, ptr, header->size);
+    }
+    return moved;
+}
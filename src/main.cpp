@@ -4,14 +4,32 @@
 #include "ft_wifi_manager.h"
 #include "flight_data_manager.h"
 #include "weather_manager.h"
+#include "time_service.h"
+#include "time_sync.h"
+#include "heap_guard.h"
+#include "telemetry.h"
+#include "diag_server.h"
+#include "fixed_string.h"
+#include "power_scheduler.h"
+#include "cpu_governor.h"
+#include "fetch_metrics.h"
+#include "ft_log.h"
+#include "profiler.h"
+
+static constexpr char TAG[] = "main";
 
 // Timing constants (in milliseconds)
 const unsigned long NIGHT_FLIGHT_UPDATE_INTERVAL = 3600000; // 1 hour during night
 const unsigned long DAY_FLIGHT_UPDATE_INTERVAL = 20000;     // 20 seconds during day
 const unsigned long WEATHER_UPDATE_INTERVAL = 600000;       // 10 minutes
-const unsigned long DISPLAY_REFRESH_INTERVAL = 100;         // 100ms for time/WiFi updates
+const unsigned long RSSI_SAMPLE_INTERVAL = 5000;            // 5 seconds between RSSI checks
+const unsigned long MAX_IDLE_SLEEP = 60000;                 // Upper bound for a single idle wait
+const unsigned long MAX_DARK_SLEEP = 1800000;               // Same with the panel asleep (no clock to update)
+const unsigned long STATS_INTERVAL = 3600000;               // Render/awake report every hour
 const unsigned long NIGHT_START_HOUR = 22;                  // 10 PM
 const unsigned long NIGHT_END_HOUR = 7;                     // 7 AM
+const char *LOCAL_TIMEZONE = "GMT0BST,M3.5.0/1,M10.5.0";    // London (handles GMT/BST automatically)
+const PanelSleepPolicy PANEL_SLEEP_POLICY = PANEL_SLEEP_AT_NIGHT_EXCEPT_FLIGHTS;
 
 // Application state
 struct AppState
@@ -20,16 +38,51 @@ struct AppState
     unsigned long lastFlightUpdate = 0;
     unsigned long lastWeatherUpdate = 0;
     unsigned long lastDisplayRefresh = 0;
+
+    // What the screen currently reflects; a change in any of these is a
+    // render event
+    time_t renderedMinute = -1;
+    int renderedBars = -1;
+    bool renderedConnected = false;
+    bool snapshotPending = false;
+    bool fetchedSinceBoot = false;
+    // A fetch has run since boot (or since the config portal closed)
+    bool flightFetched = false;
+    bool weatherFetched = false;
+    unsigned long lastRssiSample = 0;
+
+    // Render / CPU-awake accounting for the current stats window
+    unsigned long statsWindowStart = 0;
+    unsigned long renderCount = 0;
+    unsigned long wakeCount = 0;
+    unsigned long awakeMillis = 0;
 };
 
 AppState appState;
+TaskHandle_t loopTaskHandle = nullptr;
+
+// Serial console: a line is read on every loop wake (at least every
+// RSSI_SAMPLE_INTERVAL while connected)
+FixedString<32> consoleLine;
+char consoleReport[DiagServer::REPORT_SIZE];
+
+// Called from the WiFi event task on connect/disconnect: wake loop() early
+void onWiFiStateChange()
+{
+    if (loopTaskHandle)
+    {
+        xTaskNotifyGive(loopTaskHandle);
+    }
+}
 
+// Never true on an unset (1970) clock: that would be midnight
 bool isNightHours()
 {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    struct tm *timeinfo = localtime(&tv.tv_sec);
-    int currentHour = timeinfo->tm_hour;
+    if (!TimeService::isSet())
+    {
+        return false;
+    }
+    int currentHour = TimeService::hour();
 
     return (currentHour >= NIGHT_START_HOUR || currentHour < NIGHT_END_HOUR);
 }
@@ -39,112 +92,480 @@ unsigned long getFlightUpdateInterval()
     return isNightHours() ? NIGHT_FLIGHT_UPDATE_INTERVAL : DAY_FLIGHT_UPDATE_INTERVAL;
 }
 
+// Fetch ages and the last snapshot survive deep sleep in RTC memory;
+// millis() restarts at zero on wake, so ages are stored, not timestamps
+void enterDeepSleep(unsigned long ms)
+{
+    PowerScheduler::Retained &state = PowerScheduler::retained();
+    state.flightAgeMs = millis() - appState.lastFlightUpdate;
+    state.weatherAgeMs = millis() - appState.lastWeatherUpdate;
+    state.panelAsleep = DisplayManager::isPanelAsleep();
+    state.wifiFailures = FtWiFiManager::link().failures();
+    state.flight = FlightDataManager::lastRecord();
+    strncpy(state.temperature, WeatherManager::temperature(), sizeof(state.temperature) - 1);
+    strncpy(state.humidity, WeatherManager::humidity(), sizeof(state.humidity) - 1);
+
+    DisplayManager::prepareDeepSleep();
+    PowerScheduler::deepSleep(ms);
+}
+
+void restoreFromDeepSleep()
+{
+    const PowerScheduler::Retained &state = PowerScheduler::retained();
+    // Unsigned wrap-around keeps millis() - last equal to the true age
+    appState.lastFlightUpdate = millis() - (state.flightAgeMs + state.sleptMs);
+    appState.lastWeatherUpdate = millis() - (state.weatherAgeMs + state.sleptMs);
+    appState.isInitialized = true;
+    appState.flightFetched = true;
+    appState.weatherFetched = true;
+    FtWiFiManager::link().setFailures(state.wifiFailures);
+
+    WeatherManager::apply(state.temperature, state.humidity);
+    FlightDataManager::restore(state.flight);
+    if (state.flight.available)
+    {
+        DisplayManager::displayFlightData(state.flight);
+    }
+    FT_LOGI(TAG, "Resumed from deep sleep #%u", (unsigned)state.deepSleeps);
+}
+
 void initializeSystem()
 {
-    Serial.begin(9600);
-    DisplayManager::initDisplay();
-    Serial.println("Display initialized");
+    Serial.begin(115200);
+    Log::begin();
+    Telemetry::begin();
+    TimeService::begin(LOCAL_TIMEZONE);
+    TimeSync::begin();
+    bool resumed = PowerScheduler::begin();
+    DisplayManager::initDisplay(resumed, PowerScheduler::retained().panelAsleep);
+    DisplayManager::setPanelSleepPolicy(PANEL_SLEEP_POLICY);
+    FT_LOGI(TAG, "Display initialized");
 
-    if (!FtWiFiManager::connect())
+    if (resumed)
     {
-        Serial.println("Failed to connect to WiFi. Halting.");
-        DisplayManager::drawError("WiFi Connection Failed!");
-        while (true)
-        {
-            delay(1000); // Prevent watchdog reset
-        }
+        restoreFromDeepSleep();
     }
 
-    Serial.println("System initialization complete");
+    loopTaskHandle = xTaskGetCurrentTaskHandle();
+    FtWiFiManager::setStateCallback(onWiFiStateChange);
+    // Connects in the background; at night the radio stays off until a fetch is due
+    FtWiFiManager::begin(!resumed);
+    appState.statsWindowStart = millis();
+
+    FT_LOGI(TAG, "System initialization complete");
 }
 
 void setup()
 {
     initializeSystem();
+    // From here on the loop must run without touching the heap, apart from
+    // the fetches' network stacks
+    HeapGuard::markBootComplete();
+    CpuGovernor::begin();
 }
 
 bool shouldUpdateFlight()
 {
-    return !appState.isInitialized ||
+    return !appState.flightFetched ||
            (millis() - appState.lastFlightUpdate > getFlightUpdateInterval());
 }
 
 bool shouldUpdateWeather()
 {
-    return !appState.isInitialized ||
+    return !appState.weatherFetched ||
            (millis() - appState.lastWeatherUpdate > WEATHER_UPDATE_INTERVAL);
 }
 
+// The display only changes on a minute boundary, a WiFi state change, a
+// different number of RSSI bars or a new data snapshot
 bool shouldRefreshDisplay()
 {
-    return !appState.isInitialized ||
-           (millis() - appState.lastDisplayRefresh > DISPLAY_REFRESH_INTERVAL);
+    if (!appState.isInitialized || appState.snapshotPending)
+    {
+        return true;
+    }
+    if (TimeService::minuteStamp() != appState.renderedMinute)
+    {
+        return true;
+    }
+
+    bool connected = FtWiFiManager::isConnected();
+    if (connected != appState.renderedConnected)
+    {
+        return true;
+    }
+    if (connected && millis() - appState.lastRssiSample >= RSSI_SAMPLE_INTERVAL)
+    {
+        appState.lastRssiSample = millis();
+        return DisplayManager::calculateWiFiBars(FtWiFiManager::getRSSI()) != appState.renderedBars;
+    }
+    return false;
+}
+
+unsigned long millisUntil(unsigned long last, unsigned long interval)
+{
+    unsigned long elapsed = millis() - last;
+    return elapsed >= interval ? 0 : interval - elapsed;
+}
+
+// Time until the local clock next reads hour:00
+unsigned long millisUntilHour(int hour)
+{
+    int minutes = ((hour - TimeService::hour() + 24) % 24) * 60 - TimeService::minute();
+    if (minutes <= 0)
+    {
+        minutes += 24 * 60;
+    }
+    return TimeService::millisUntilNextMinute() + (unsigned long)(minutes - 1) * 60000UL;
+}
+
+// Time until the earliest render or fetch deadline
+unsigned long millisUntilNextEvent()
+{
+    unsigned long wait;
+    if (DisplayManager::isPanelAsleep())
+    {
+        // No clock on screen: only fetches and the end of the night matter
+        wait = min(MAX_DARK_SLEEP, millisUntilHour(NIGHT_END_HOUR));
+    }
+    else
+    {
+        wait = min(MAX_IDLE_SLEEP, TimeService::millisUntilNextMinute());
+    }
+    // While the link is coming up its own deadlines apply; connecting
+    // notifies us, and the due fetches run then
+    if (FtWiFiManager::isConnected() || FtWiFiManager::isRadioOff())
+    {
+        unsigned long flightWait = millisUntil(appState.lastFlightUpdate, getFlightUpdateInterval() + 1);
+        unsigned long weatherWait = millisUntil(appState.lastWeatherUpdate, WEATHER_UPDATE_INTERVAL + 1);
+        wait = min(wait, shouldUpdateFlight() ? 0 : flightWait);
+        wait = min(wait, shouldUpdateWeather() ? 0 : weatherWait);
+    }
+    wait = min(wait, FtWiFiManager::millisUntilNextStep());
+    wait = min(wait, TimeSync::millisUntilNextStep());
+    wait = min(wait, Telemetry::millisUntilSample(millis()));
+    // Signal bars aren't worth keeping the chip up for at night
+    if (FtWiFiManager::isConnected() && !isNightHours())
+    {
+        wait = min(wait, millisUntil(appState.lastRssiSample, RSSI_SAMPLE_INTERVAL));
+    }
+    return wait;
+}
+
+// A multi-line report as one log line each, so it stays in order with the rest
+void logReport(const char *text)
+{
+    char line[Log::LINE_SIZE];
+    while (*text)
+    {
+        const char *end = strchr(text, '\n');
+        size_t len = end ? (size_t)(end - text) : strlen(text);
+        snprintf(line, sizeof(line), "%.*s", (int)len, text);
+        FT_LOGI(TAG, "%s", line);
+        text += end ? len + 1 : len;
+    }
+}
+
+void reportLoopStats()
+{
+    unsigned long window = millis() - appState.statsWindowStart;
+    if (window < STATS_INTERVAL)
+    {
+        return;
+    }
+    FT_LOGI(TAG, "Last %lu s: %lu renders, %lu wakes, CPU awake %lu ms (%.2f%%)",
+            window / 1000, appState.renderCount, appState.wakeCount, appState.awakeMillis,
+            100.0 * appState.awakeMillis / window);
+    // Since boot: fetches that changed what's on screen, and those that didn't
+    const SnapshotGate &flights = FlightDataManager::snapshots();
+    const SnapshotGate &weather = WeatherManager::snapshots();
+    FT_LOGI(TAG, "Snapshots: flight %u applied, %u suppressed; weather %u applied, %u suppressed",
+            (unsigned)flights.appliedCount(), (unsigned)flights.suppressedCount(),
+            (unsigned)weather.appliedCount(), (unsigned)weather.suppressedCount());
+    CpuGovernor::formatReport(consoleReport, sizeof(consoleReport));
+    logReport(consoleReport);
+    appState.statsWindowStart = millis();
+    appState.renderCount = 0;
+    appState.wakeCount = 0;
+    appState.awakeMillis = 0;
+}
+
+// Boot (or deep-sleep wake) to the first request: what the fast reconnect
+// path is there to shorten
+void noteFetchStart()
+{
+    if (appState.fetchedSinceBoot)
+    {
+        return;
+    }
+    appState.fetchedSinceBoot = true;
+    FT_LOGI(TAG, "First fetch %lu ms after boot (WiFi %lu ms, %s path)", millis(),
+            (unsigned long)FtWiFiManager::connectStats().lastConnectMs,
+            FtWiFiManager::connectStats().lastWasFast ? "fast" : "full");
 }
 
 void updateFlightData()
 {
     if (!FtWiFiManager::isConnected())
     {
-        Serial.println("WiFi not connected, cannot fetch flight data.");
-        DisplayManager::drawError("No WiFi Connection!");
+        // Keep showing the last flight; the fetch runs once the link is up
+        HeapGuard::Allow allow("wifi link");
+        FtWiFiManager::request();
         return;
     }
 
-    Serial.println("Fetching latest flight data...");
-    FlightDataManager::fetchData();
+    FT_LOGD(TAG, "Fetching latest flight data...");
+    noteFetchStart();
+    uint32_t applied = FlightDataManager::snapshots().appliedCount();
+    {
+        HeapGuard::Allow allow("flight fetch");
+        // TLS handshake, JSON parse and, for a new flight, a full redraw
+        CpuGovernor::Boost boost("flight fetch");
+        Telemetry::noteFetch(FlightDataManager::fetchData());
+    }
     appState.lastFlightUpdate = millis();
-    Serial.println("Flight data updated.");
+    appState.flightFetched = true;
+    // A new flight clears the screen, so the clock and bars need redrawing;
+    // an unchanged one leaves them as they are
+    if (FlightDataManager::snapshots().appliedCount() != applied)
+    {
+        appState.snapshotPending = true;
+    }
+    FT_LOGD(TAG, "Flight data updated.");
 }
 
 void updateWeatherData()
 {
     if (!FtWiFiManager::isConnected())
     {
-        Serial.println("WiFi not connected, cannot fetch weather data.");
+        HeapGuard::Allow allow("wifi link");
+        FtWiFiManager::request();
         return;
     }
 
-    Serial.println("Fetching weather data...");
-    WeatherManager::fetchData();
+    FT_LOGD(TAG, "Fetching weather data...");
+    noteFetchStart();
+    uint32_t applied = WeatherManager::snapshots().appliedCount();
+    {
+        HeapGuard::Allow allow("weather fetch");
+        CpuGovernor::Boost boost("weather fetch");
+        Telemetry::noteFetch(WeatherManager::fetchData());
+    }
     appState.lastWeatherUpdate = millis();
+    appState.weatherFetched = true;
+    // Identical readings are filtered out before they reach the display
+    if (WeatherManager::snapshots().appliedCount() != applied)
+    {
+        appState.snapshotPending = true;
+    }
+}
+
+void runConsoleCommand(const char *command)
+{
+    if (strcmp(command, "telemetry") == 0)
+    {
+        size_t len = Telemetry::formatReport(consoleReport, sizeof(consoleReport));
+        Serial.write((const uint8_t *)consoleReport, len);
+    }
+    else if (strcmp(command, "cpu") == 0)
+    {
+        size_t len = CpuGovernor::formatReport(consoleReport, sizeof(consoleReport));
+        Serial.write((const uint8_t *)consoleReport, len);
+    }
+    else if (strncmp(command, "boost ", 6) == 0)
+    {
+        // A/B the fetch latency: "boost 80" turns boosting off
+        uint32_t mhz = strtoul(command + 6, nullptr, 10);
+        if (CpuGovernor::setBoostMhz(mhz))
+        {
+            Serial.printf("Boost clock now %u MHz\n", (unsigned)mhz);
+        }
+        else
+        {
+            Serial.printf("Unsupported clock %u MHz\n", (unsigned)mhz);
+        }
+    }
+    else if (strcmp(command, "fetch") == 0)
+    {
+        size_t len = FetchMetrics::formatReport(consoleReport, sizeof(consoleReport));
+        Serial.write((const uint8_t *)consoleReport, len);
+    }
+    else if (strcmp(command, "time") == 0)
+    {
+        size_t len = TimeSync::formatReport(consoleReport, sizeof(consoleReport));
+        Serial.write((const uint8_t *)consoleReport, len);
+    }
+    else if (strcmp(command, "profile") == 0)
+    {
+        size_t len = Profiler::formatReport(consoleReport, sizeof(consoleReport));
+        if (len == 0)
+        {
+            Serial.println("Profiling is off; build the profile environment");
+        }
+        else
+        {
+            Serial.write((const uint8_t *)consoleReport, len);
+        }
+    }
+    else if (strcmp(command, "profile reset") == 0)
+    {
+        Profiler::reset();
+    }
+    else if (strcmp(command, "overlay") == 0)
+    {
+        DisplayManager::setOverlay(!DisplayManager::isOverlayOn());
+        Serial.printf("Overlay %s\n", DisplayManager::isOverlayOn() ? "on" : "off");
+    }
+    else if (strcmp(command, "portal") == 0)
+    {
+        HeapGuard::Allow allow("wifi portal");
+        FtWiFiManager::openPortal();
+    }
+    else
+    {
+        Serial.printf("Unknown command '%s'. Commands: telemetry, fetch, cpu, boost <MHz>, time, profile [reset], overlay, portal\n", command);
+    }
+}
+
+void pollConsole()
+{
+    FT_PROFILE_ZONE("console");
+    while (Serial.available())
+    {
+        char c = Serial.read();
+        if (c == '\r' || c == '\n')
+        {
+            if (!consoleLine.isEmpty())
+            {
+                runConsoleCommand(consoleLine.c_str());
+                consoleLine.clear();
+            }
+        }
+        else
+        {
+            consoleLine += c;
+        }
+    }
 }
 
 void refreshDisplay()
 {
+    FT_PROFILE_ZONE("display refresh");
+    HeapGuard::Tag tag("display refresh");
+    // A few digits and bars: not worth a boost. Full redraws take one of
+    // their own (flight fetch, portal close, panel wake), or happen in
+    // setup() before the clock drops.
     DisplayManager::displayTime();
     DisplayManager::displayWiFiStrength();
     appState.lastDisplayRefresh = millis();
+
+    appState.renderedMinute = TimeService::minuteStamp();
+    appState.renderedConnected = FtWiFiManager::isConnected();
+    appState.renderedBars = appState.renderedConnected
+                                ? DisplayManager::calculateWiFiBars(FtWiFiManager::getRSSI())
+                                : -1;
+    appState.lastRssiSample = millis();
+    appState.snapshotPending = false;
+    appState.renderCount++;
 }
 
 void loop()
 {
-    // Update weather data periodically
-    if (shouldUpdateWeather())
+    unsigned long wakeStart = millis();
+    appState.wakeCount++;
+    TimeService::update();
+    pollConsole();
+
+    bool portalWasOpen = FtWiFiManager::isPortalOpen();
     {
-        updateWeatherData();
+        HeapGuard::Allow allow("wifi link");
+        FT_PROFILE_ZONE("wifi link");
+        FtWiFiManager::update();
+        TimeSync::update();
+    }
+    if (portalWasOpen && !FtWiFiManager::isPortalOpen())
+    {
+        // Start over as after boot: the setup screen replaced everything
+        CpuGovernor::Boost boost("portal closed");
+        DisplayManager::clearScreen();
+        appState.isInitialized = false;
+        appState.flightFetched = false;
+        appState.weatherFetched = false;
     }
 
-    // Update display (time and WiFi signal) frequently
-    if (shouldRefreshDisplay())
+    if (Telemetry::sampleDue(millis()))
     {
-        refreshDisplay();
+        FT_PROFILE_ZONE("telemetry");
+        Telemetry::sample(millis());
     }
 
-    // Update flight data based on time of day
-    if (shouldUpdateFlight())
+    // The setup screen stays up while the portal is open
+    if (!FtWiFiManager::isPortalOpen())
     {
-        updateFlightData();
-        // Refresh display after flight data update
-        refreshDisplay();
+        // Update weather data periodically
+        if (shouldUpdateWeather())
+        {
+            updateWeatherData();
+        }
+
+        // Update flight data based on time of day
+        if (shouldUpdateFlight())
+        {
+            updateFlightData();
+        }
+
+        // Update display (time and WiFi signal) when something visible changed
+        if (shouldRefreshDisplay())
+        {
+            refreshDisplay();
+        }
     }
 
     // Mark system as initialized after first cycle
     if (!appState.isInitialized)
     {
         appState.isInitialized = true;
-        Serial.println("Application fully initialized");
+        FT_LOGI(TAG, "Application fully initialized");
     }
 
-    // Small delay to prevent excessive CPU usage
-    delay(10);
+    bool night = isNightHours();
+    DisplayManager::updatePanelPower(night);
+    DisplayManager::updateOverlay();
+
+    appState.awakeMillis += millis() - wakeStart;
+    reportLoopStats();
+    HeapGuard::report();
+
+    if (FtWiFiManager::isConnected())
+    {
+        // Once: the server's sockets and its task stack
+        HeapGuard::Allow allow("diag server");
+        DiagServer::begin();
+    }
+
+    // Sleep until the nearest deadline. By day WiFi state changes notify us
+    // early; at night a long wait becomes light sleep while the panel is
+    // lit and deep sleep while it's dark.
+    PowerScheduler::Inputs power;
+    power.night = night;
+    power.errorShown = DisplayManager::isShowingError();
+    power.radioBusy = FtWiFiManager::isBusy() || TimeSync::isQuerying();
+    power.panelLit = !DisplayManager::isPanelAsleep();
+    power.idleMs = millisUntilNextEvent();
+    PowerScheduler::Decision decision = PowerScheduler::decide(power);
+    if (decision.action == PowerScheduler::DEEP_SLEEP)
+    {
+        enterDeepSleep(decision.sleepMs);
+    }
+    if (decision.action == PowerScheduler::LIGHT_SLEEP)
+    {
+        // As after a deep sleep, the next due fetch brings the radio back
+        {
+            HeapGuard::Allow allow("wifi link");
+            FtWiFiManager::park();
+        }
+        PowerScheduler::lightSleep(decision.sleepMs);
+        return;
+    }
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(decision.sleepMs));
 }
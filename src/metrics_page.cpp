@@ -0,0 +1,158 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include "metrics_page.h"
+#include "fetch_metrics.h"
+#include "ft_log.h"
+
+// Label values; FetchMetrics::stageName() has spaces, which read badly in PromQL
+static const char *const STAGE_LABELS[FetchMetrics::STAGE_COUNT] = {"dns", "connect", "first_byte", "body",
+                                                                    "total"};
+static const uint8_t QUANTILES[] = {50, 95};
+
+// Appends whole lines. The first one that doesn't fit ends the page, so what
+// was written is still a valid exposition.
+struct PageWriter
+{
+    char *buffer;
+    size_t size;
+    size_t len;
+    bool complete;
+
+    void line(const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+    void family(const char *name, const char *type, const char *help)
+    {
+        line("# HELP %s %s\n", name, help);
+        line("# TYPE %s %s\n", name, type);
+    }
+};
+
+void PageWriter::line(const char *format, ...)
+{
+    if (!complete)
+    {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer + len, size - len, format, args);
+    va_end(args);
+    if (n > 0 && (size_t)n < size - len)
+    {
+        len += n;
+    }
+    else
+    {
+        buffer[len] = '\0';
+        complete = false;
+    }
+}
+
+// Milliseconds as seconds with three decimals, without floating point
+#define SECONDS_FMT "%u.%03u"
+#define SECONDS_ARG(ms) (unsigned)((ms) / 1000), (unsigned)((ms) % 1000)
+
+static void writeFetch(PageWriter &w)
+{
+    w.family("ft_fetch_total", "counter", "Data fetches by result");
+    for (uint8_t e = 0; e < FetchMetrics::ENDPOINT_COUNT; e++)
+    {
+        uint32_t failed = 0;
+        for (uint8_t s = 0; s < FetchMetrics::STAGE_COUNT; s++)
+        {
+            failed += FetchMetrics::failures((FetchMetrics::Endpoint)e, (FetchMetrics::Stage)s);
+        }
+        const char *endpoint = FetchMetrics::endpointName(e);
+        w.line("ft_fetch_total{endpoint=\"%s\",result=\"ok\"} %u\n", endpoint,
+               (unsigned)FetchMetrics::successes((FetchMetrics::Endpoint)e));
+        w.line("ft_fetch_total{endpoint=\"%s\",result=\"failed\"} %u\n", endpoint, (unsigned)failed);
+    }
+
+    w.family("ft_fetch_failures_total", "counter", "Failed fetches by the stage that didn't complete");
+    for (uint8_t e = 0; e < FetchMetrics::ENDPOINT_COUNT; e++)
+    {
+        for (uint8_t s = 0; s < FetchMetrics::STAGE_TOTAL; s++)
+        {
+            w.line("ft_fetch_failures_total{endpoint=\"%s\",stage=\"%s\"} %u\n", FetchMetrics::endpointName(e),
+                   STAGE_LABELS[s], (unsigned)FetchMetrics::failures((FetchMetrics::Endpoint)e, (FetchMetrics::Stage)s));
+        }
+    }
+
+    // Quantiles are histogram bucket edges, so within 25% of the true value
+    w.family("ft_fetch_stage_seconds", "summary", "Fetch latency by stage since boot");
+    for (uint8_t e = 0; e < FetchMetrics::ENDPOINT_COUNT; e++)
+    {
+        for (uint8_t s = 0; s < FetchMetrics::STAGE_COUNT; s++)
+        {
+            LatencyHistogram h = FetchMetrics::histogram((FetchMetrics::Endpoint)e, (FetchMetrics::Stage)s);
+            const char *endpoint = FetchMetrics::endpointName(e);
+            for (uint8_t q : QUANTILES)
+            {
+                uint32_t ms = h.percentile(q);
+                w.line("ft_fetch_stage_seconds{endpoint=\"%s\",stage=\"%s\",quantile=\"0.%02u\"} " SECONDS_FMT "\n",
+                       endpoint, STAGE_LABELS[s], (unsigned)q, SECONDS_ARG(ms));
+            }
+            w.line("ft_fetch_stage_seconds_sum{endpoint=\"%s\",stage=\"%s\"} " SECONDS_FMT "\n", endpoint,
+                   STAGE_LABELS[s], SECONDS_ARG(h.sum()));
+            w.line("ft_fetch_stage_seconds_count{endpoint=\"%s\",stage=\"%s\"} %u\n", endpoint, STAGE_LABELS[s],
+                   (unsigned)h.count());
+        }
+    }
+}
+
+static void writeSystem(PageWriter &w, const MetricsPage::System &sys)
+{
+    w.family("ft_uptime_seconds", "gauge", "Time since boot");
+    w.line("ft_uptime_seconds %u\n", (unsigned)sys.uptimeS);
+
+    w.family("ft_heap_free_bytes", "gauge", "Free heap");
+    w.line("ft_heap_free_bytes %u\n", (unsigned)sys.freeHeap);
+    w.family("ft_heap_largest_block_bytes", "gauge", "Largest allocatable heap block");
+    w.line("ft_heap_largest_block_bytes %u\n", (unsigned)sys.largestBlock);
+    w.family("ft_heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+    w.line("ft_heap_min_free_bytes %u\n", (unsigned)sys.minFreeHeap);
+
+    w.family("ft_wifi_connected", "gauge", "1 while the station is associated");
+    w.line("ft_wifi_connected %u\n", sys.connected ? 1u : 0u);
+    // No sample at all while disconnected, rather than a made-up RSSI
+    if (sys.connected)
+    {
+        w.family("ft_wifi_rssi_dbm", "gauge", "Received signal strength");
+        w.line("ft_wifi_rssi_dbm %d\n", (int)sys.rssi);
+    }
+    w.family("ft_wifi_connects_total", "counter", "Station connects by path");
+    w.line("ft_wifi_connects_total{path=\"fast\"} %u\n", (unsigned)sys.fastConnects);
+    w.line("ft_wifi_connects_total{path=\"full\"} %u\n", (unsigned)sys.fullConnects);
+    w.family("ft_wifi_fast_connect_misses_total", "counter", "Fast connects that fell back to the full path");
+    w.line("ft_wifi_fast_connect_misses_total %u\n", (unsigned)sys.fastMisses);
+
+    w.family("ft_display_frames_total", "counter", "Frames flushed to the panel");
+    w.line("ft_display_frames_total %u\n", (unsigned)sys.frames);
+    w.family("ft_display_pixels_total", "counter", "Pixels flushed to the panel");
+    w.line("ft_display_pixels_total %u\n", (unsigned)sys.pixels);
+    w.family("ft_display_bus_bytes_total", "counter", "Bytes sent on the panel SPI bus");
+    w.line("ft_display_bus_bytes_total %u\n", (unsigned)sys.busBytes);
+
+    Log::Stats log = Log::stats();
+    w.family("ft_log_lines_total", "counter", "Log lines queued, or dropped with the ring full");
+    w.line("ft_log_lines_total{result=\"queued\"} %u\n", (unsigned)log.written);
+    w.line("ft_log_lines_total{result=\"dropped\"} %u\n", (unsigned)log.dropped);
+    w.family("ft_log_truncated_total", "counter", "Log lines cut to Log::LINE_SIZE");
+    w.line("ft_log_truncated_total %u\n", (unsigned)log.truncated);
+}
+
+size_t MetricsPage::format(char *buffer, size_t size, const System &sys, bool *complete)
+{
+    PageWriter w = {buffer, size, 0, size > 0};
+    if (size > 0)
+    {
+        buffer[0] = '\0';
+        writeFetch(w);
+        writeSystem(w, sys);
+    }
+    if (complete)
+    {
+        *complete = w.complete;
+    }
+    return w.len;
+}
@@ -0,0 +1,242 @@
+#include "panel_bus.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <driver/gpio.h>
+
+SpiPanelBus::SpiPanelBus(SPIClass &spi, int8_t cs, int8_t dc, int8_t rst, uint32_t freq)
+    : spi(spi), csPin(cs), dcPin(dc), rstPin(rst), settings(freq, MSBFIRST, SPI_MODE0), sent(0)
+{
+}
+
+void SpiPanelBus::begin()
+{
+    pinMode(csPin, OUTPUT);
+    digitalWrite(csPin, HIGH);
+    pinMode(dcPin, OUTPUT);
+    digitalWrite(dcPin, HIGH);
+    if (rstPin >= 0)
+    {
+        // Keep the panel out of reset; after deep sleep this matches the held level
+        pinMode(rstPin, OUTPUT);
+        digitalWrite(rstPin, HIGH);
+    }
+}
+
+void SpiPanelBus::hardwareReset()
+{
+    if (rstPin < 0)
+    {
+        return;
+    }
+    pinMode(rstPin, OUTPUT);
+    digitalWrite(rstPin, HIGH);
+    delay(100);
+    digitalWrite(rstPin, LOW);
+    delay(100);
+    digitalWrite(rstPin, HIGH);
+    delay(200);
+}
+
+void SpiPanelBus::beginTransaction()
+{
+    spi.beginTransaction(settings);
+    digitalWrite(csPin, LOW);
+}
+
+void SpiPanelBus::endTransaction()
+{
+    digitalWrite(csPin, HIGH);
+    spi.endTransaction();
+}
+
+void SpiPanelBus::writeCommand(uint8_t cmd)
+{
+    digitalWrite(dcPin, LOW);
+    spi.write(cmd);
+    digitalWrite(dcPin, HIGH);
+    sent++;
+}
+
+void SpiPanelBus::writeData(const uint8_t *data, size_t len)
+{
+    spi.writeBytes(data, len);
+    sent += len;
+}
+
+void SpiPanelBus::writePixels(const uint16_t *pixels, size_t count)
+{
+    // The ESP32 SPI driver swaps each 16-bit word to big-endian on the wire
+    spi.writePixels(pixels, count * 2);
+    sent += count * 2;
+}
+
+void SpiPanelBus::writeRepeat(uint16_t color, uint32_t count)
+{
+    uint8_t pixel[2] = {(uint8_t)(color >> 8), (uint8_t)color};
+    spi.writePattern(pixel, 2, count);
+    sent += count * 2;
+}
+
+void SpiPanelBus::delayMs(uint32_t ms)
+{
+    delay(ms);
+}
+
+void SpiPanelBus::holdPins(bool hold)
+{
+    const int8_t pins[] = {csPin, dcPin, rstPin};
+    for (int8_t pin : pins)
+    {
+        if (pin < 0)
+        {
+            continue;
+        }
+        if (hold)
+        {
+            gpio_hold_en((gpio_num_t)pin);
+        }
+        else
+        {
+            gpio_hold_dis((gpio_num_t)pin);
+        }
+    }
+    if (hold)
+    {
+        gpio_deep_sleep_hold_en();
+    }
+}
+#endif
+
+TracePanelBus::TracePanelBus(PanelBus *forward) : next(forward)
+{
+    clear();
+}
+
+void TracePanelBus::clear()
+{
+    used = 0;
+    dropped = 0;
+    sums = Totals();
+    lastWasData = true;
+}
+
+void TracePanelBus::record(PanelBusEvent::Type type, uint8_t value, uint32_t count)
+{
+    if (used >= MAX_EVENTS)
+    {
+        dropped++;
+        return;
+    }
+    events[used].type = type;
+    events[used].value = value;
+    events[used].count = count;
+    used++;
+}
+
+void TracePanelBus::noteMode(bool isData)
+{
+    if (isData != lastWasData)
+    {
+        sums.dcToggles++;
+        lastWasData = isData;
+    }
+}
+
+void TracePanelBus::begin()
+{
+    if (next)
+    {
+        next->begin();
+    }
+}
+
+void TracePanelBus::hardwareReset()
+{
+    if (next)
+    {
+        next->hardwareReset();
+    }
+}
+
+void TracePanelBus::beginTransaction()
+{
+    sums.transactions++;
+    record(PanelBusEvent::BEGIN, 0, 0);
+    if (next)
+    {
+        next->beginTransaction();
+    }
+}
+
+void TracePanelBus::endTransaction()
+{
+    record(PanelBusEvent::END, 0, 0);
+    if (next)
+    {
+        next->endTransaction();
+    }
+}
+
+void TracePanelBus::writeCommand(uint8_t cmd)
+{
+    sums.commands++;
+    noteMode(false);
+    record(PanelBusEvent::COMMAND, cmd, 1);
+    if (next)
+    {
+        next->writeCommand(cmd);
+    }
+}
+
+void TracePanelBus::writeData(const uint8_t *data, size_t len)
+{
+    sums.dataBytes += len;
+    noteMode(true);
+    record(PanelBusEvent::DATA, len ? data[0] : 0, len);
+    if (next)
+    {
+        next->writeData(data, len);
+    }
+}
+
+void TracePanelBus::writePixels(const uint16_t *pixels, size_t count)
+{
+    sums.pixelBytes += count * 2;
+    sums.bursts++;
+    noteMode(true);
+    record(PanelBusEvent::PIXELS, 0, count);
+    if (next)
+    {
+        next->writePixels(pixels, count);
+    }
+}
+
+void TracePanelBus::writeRepeat(uint16_t color, uint32_t count)
+{
+    sums.pixelBytes += count * 2;
+    sums.bursts++;
+    noteMode(true);
+    record(PanelBusEvent::REPEAT, 0, count);
+    if (next)
+    {
+        next->writeRepeat(color, count);
+    }
+}
+
+void TracePanelBus::delayMs(uint32_t ms)
+{
+    record(PanelBusEvent::DELAY, 0, ms);
+    if (next)
+    {
+        next->delayMs(ms);
+    }
+}
+
+void TracePanelBus::holdPins(bool hold)
+{
+    if (next)
+    {
+        next->holdPins(hold);
+    }
+}
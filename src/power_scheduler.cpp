@@ -0,0 +1,81 @@
+#include "power_scheduler.h"
+#include "ft_log.h"
+
+// The desktop simulator (host/) restarts itself to emulate deep sleep
+#if defined(ARDUINO) || defined(FT_SIM)
+#include <Arduino.h>
+#include <esp_sleep.h>
+#include <esp_attr.h>
+#else
+#define RTC_DATA_ATTR
+#endif
+
+static constexpr char TAG[] = "power";
+
+static const uint32_t RETAINED_MAGIC = 0x46545253; // "FTRS"
+
+// Zeroed on power-on, kept through deep sleep
+RTC_DATA_ATTR static PowerScheduler::Retained rtcState;
+
+bool PowerScheduler::wasResumed = false;
+uint32_t PowerScheduler::lightSleepCount = 0;
+
+PowerScheduler::Decision PowerScheduler::decide(const Inputs &in)
+{
+    if (!in.night || in.errorShown || in.radioBusy || in.idleMs < MIN_DEEP_SLEEP_MS)
+    {
+        return {IDLE, in.idleMs};
+    }
+    // Light sleep resumes in about a millisecond, so no lead
+    if (in.panelLit)
+    {
+        return {LIGHT_SLEEP, in.idleMs};
+    }
+    return {DEEP_SLEEP, in.idleMs - WAKE_LEAD_MS};
+}
+
+bool PowerScheduler::begin()
+{
+#if defined(ARDUINO) || defined(FT_SIM)
+    wasResumed = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER && rtcState.magic == RETAINED_MAGIC;
+#else
+    wasResumed = rtcState.magic == RETAINED_MAGIC;
+#endif
+    if (!wasResumed)
+    {
+        rtcState = Retained();
+    }
+    // Invalid again until the next deliberate deep sleep
+    rtcState.magic = 0;
+    return wasResumed;
+}
+
+PowerScheduler::Retained &PowerScheduler::retained()
+{
+    return rtcState;
+}
+
+void PowerScheduler::deepSleep(unsigned long ms)
+{
+    rtcState.magic = RETAINED_MAGIC;
+    rtcState.deepSleeps++;
+    rtcState.sleptMs = ms;
+#if defined(ARDUINO) || defined(FT_SIM)
+    FT_LOGI(TAG, "Deep sleep for %lu ms (#%u)", ms, (unsigned)rtcState.deepSleeps);
+    Log::flush();
+    esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000ULL);
+    esp_deep_sleep_start();
+#endif
+}
+
+void PowerScheduler::lightSleep(unsigned long ms)
+{
+    lightSleepCount++;
+#if defined(ARDUINO) || defined(FT_SIM)
+    FT_LOGD(TAG, "Light sleep for %lu ms (#%u)", ms, (unsigned)lightSleepCount);
+    // The UART stops with the clocks; don't cut a line short
+    Serial.flush();
+    esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000ULL);
+    esp_light_sleep_start();
+#endif
+}
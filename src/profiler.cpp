@@ -0,0 +1,192 @@
+#ifdef FT_PROFILE
+
+#include <stdio.h>
+#include "profiler.h"
+#include "report_buffer.h"
+#include "stats_lock.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <time.h>
+#endif
+
+static Profiler::Zone *zones[Profiler::MAX_ZONES];
+static uint8_t zonesUsed = 0;
+static uint32_t unlistedZones = 0;
+static uint32_t windowStartMs = 0;
+
+#ifdef ARDUINO
+// The cycle counter wraps every 27 s at 160 MHz, so it is folded into a
+// 64-bit nanosecond count on every read. Zones are far shorter than a wrap;
+// a long gap between reads only shifts the base, which nothing relies on.
+static uint32_t lastCycles = 0;
+static uint64_t elapsedNs = 0;
+// ns per cycle in 1/256ths: exact at 80 and 160 MHz
+static uint32_t nsPerCycleQ8 = 0;
+
+uint64_t Profiler::now()
+{
+    uint32_t cycles = ESP.getCycleCount();
+    if (nsPerCycleQ8 == 0)
+    {
+        nsPerCycleQ8 = 256000 / getCpuFrequencyMhz();
+    }
+    elapsedNs += ((uint64_t)(cycles - lastCycles) * nsPerCycleQ8) >> 8;
+    lastCycles = cycles;
+    return elapsedNs;
+}
+
+// now() keeps state for the loop task; the report window uses millis() so
+// /diag can format the report from its own task
+static uint32_t windowMs()
+{
+    return millis();
+}
+
+void Profiler::clockChanged(uint32_t mhz)
+{
+    now();
+    nsPerCycleQ8 = 256000 / mhz;
+}
+#else
+uint64_t Profiler::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void Profiler::clockChanged(uint32_t mhz)
+{
+    (void)mhz;
+}
+
+static uint32_t windowMs()
+{
+    return (uint32_t)(Profiler::now() / 1000000);
+}
+#endif
+
+void Profiler::record(Zone &zone, uint64_t ns)
+{
+    StatsLock lock;
+    if (!zone.listed)
+    {
+        zone.listed = true;
+        if (zonesUsed == 0)
+        {
+            windowStartMs = windowMs() - (uint32_t)(ns / 1000000);
+        }
+        if (zonesUsed < MAX_ZONES)
+        {
+            zones[zonesUsed++] = &zone;
+        }
+        else
+        {
+            unlistedZones++;
+        }
+    }
+    zone.calls++;
+    zone.totalNs += ns;
+    uint32_t clamped = ns > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)ns;
+    if (clamped > zone.maxNs)
+    {
+        zone.maxNs = clamped;
+    }
+}
+
+void Profiler::reset()
+{
+    StatsLock lock;
+    for (uint8_t i = 0; i < zonesUsed; i++)
+    {
+        zones[i]->calls = 0;
+        zones[i]->totalNs = 0;
+        zones[i]->maxNs = 0;
+    }
+    windowStartMs = windowMs();
+}
+
+uint8_t Profiler::zoneCount()
+{
+    return zonesUsed;
+}
+
+const Profiler::Zone &Profiler::zone(uint8_t index)
+{
+    return *zones[index];
+}
+
+uint32_t Profiler::unlisted()
+{
+    return unlistedZones;
+}
+
+size_t Profiler::formatReport(char *buffer, size_t size)
+{
+    size_t len = 0;
+    if (size == 0)
+    {
+        return 0;
+    }
+    buffer[0] = '\0';
+
+    // Totals as of now to sort by; each row is copied again as it's written
+    uint64_t totals[MAX_ZONES];
+    uint8_t used;
+    uint32_t unlisted;
+    uint32_t nowMs = windowMs();
+    uint32_t window;
+    {
+        StatsLock lock;
+        used = zonesUsed;
+        unlisted = unlistedZones;
+        window = used ? nowMs - windowStartMs : 0;
+        for (uint8_t i = 0; i < used; i++)
+        {
+            totals[i] = zones[i]->totalNs;
+        }
+    }
+
+    // Busiest first; insertion sort over at most MAX_ZONES entries
+    uint8_t order[MAX_ZONES];
+    for (uint8_t i = 0; i < used; i++)
+    {
+        uint8_t j = i;
+        while (j > 0 && totals[order[j - 1]] < totals[i])
+        {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    uint64_t windowNs = (uint64_t)window * 1000000;
+    appendf(buffer, size, len, "profile: %u zones over %u ms (nested zones count in their parents)\n",
+            (unsigned)used, (unsigned)window);
+    if (unlisted)
+    {
+        appendf(buffer, size, len, "  %u zones not listed, raise Profiler::MAX_ZONES\n", (unsigned)unlisted);
+    }
+    appendf(buffer, size, len, "  %-16s %8s %10s %9s %9s %7s\n", "zone", "calls", "total ms", "mean us", "max us",
+            "share");
+    for (uint8_t i = 0; i < used; i++)
+    {
+        Zone z("");
+        {
+            StatsLock lock;
+            z = *zones[order[i]];
+        }
+        // Totals in tenths of a millisecond and of a percent of the window
+        uint32_t total = (uint32_t)(z.totalNs / 100000);
+        unsigned share = windowNs ? (unsigned)(z.totalNs * 1000 / windowNs) : 0;
+        appendf(buffer, size, len, "  %-16s %8u %8u.%u %9u %9u %4u.%u%%\n", z.name, (unsigned)z.calls,
+                (unsigned)(total / 10), (unsigned)(total % 10),
+                z.calls ? (unsigned)(z.totalNs / 1000 / z.calls) : 0u, (unsigned)(z.maxNs / 1000), share / 10,
+                share % 10);
+    }
+    return len;
+}
+
+#endif // FT_PROFILE
@@ -0,0 +1,26 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include "report_buffer.h"
+
+bool appendf(char *buffer, size_t size, size_t &len, const char *format, ...)
+{
+    if (len + 1 >= size)
+    {
+        return false;
+    }
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer + len, size - len, format, args);
+    va_end(args);
+    if (n < 0)
+    {
+        return false;
+    }
+    if ((size_t)n >= size - len)
+    {
+        len = size - 1;
+        return false;
+    }
+    len += (size_t)n;
+    return true;
+}
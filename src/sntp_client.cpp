@@ -0,0 +1,297 @@
+#include <string.h>
+#include "sntp_client.h"
+
+// Seconds from 1900 (NTP era 0) to 1970
+static const uint64_t NTP_UNIX_OFFSET = 2208988800ULL;
+
+static uint64_t readTimestamp(const uint8_t *p)
+{
+    uint64_t value = 0;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+static void writeTimestamp(uint8_t *p, uint64_t value)
+{
+    for (int8_t i = 7; i >= 0; i--)
+    {
+        p[i] = (uint8_t)value;
+        value >>= 8;
+    }
+}
+
+static int64_t magnitude(int64_t value)
+{
+    return value < 0 ? -value : value;
+}
+
+SntpClient::SntpClient(SntpDriver &driver, Retained &state)
+    : driver(driver), state(state), serverCount(0), querying(false), attempted(false), lastFailed(false),
+      queryStart(0), lastAttempt(0), firstReply(0), replies(0), haveBest(false), best()
+{
+}
+
+uint64_t SntpClient::toNtp(int64_t unixUs)
+{
+    uint64_t seconds = (uint64_t)(unixUs / 1000000) + NTP_UNIX_OFFSET;
+    uint64_t fraction = ((uint64_t)(unixUs % 1000000) << 32) / 1000000;
+    return (seconds << 32) | fraction;
+}
+
+int64_t SntpClient::fromNtp(uint64_t ntp)
+{
+    int64_t seconds = (int64_t)(ntp >> 32) - (int64_t)NTP_UNIX_OFFSET;
+    int64_t micros = (int64_t)(((ntp & 0xFFFFFFFFULL) * 1000000) >> 32);
+    return seconds * 1000000 + micros;
+}
+
+void SntpClient::buildRequest(uint8_t *packet, uint64_t transmit)
+{
+    memset(packet, 0, PACKET_SIZE);
+    packet[0] = (0 << 6) | (4 << 3) | 3; // LI 0, version 4, mode 3 (client)
+    writeTimestamp(packet + 40, transmit);
+}
+
+bool SntpClient::parseReply(const uint8_t *packet, size_t len, uint64_t originate, int64_t t1Us, int64_t t4Us,
+                            SntpSample &out)
+{
+    if (len < PACKET_SIZE)
+    {
+        return false;
+    }
+    uint8_t leap = packet[0] >> 6;
+    uint8_t mode = packet[0] & 0x07;
+    uint8_t stratum = packet[1];
+    // Unsynchronised server, not a server reply, or a kiss-o'-death (stratum 0)
+    if (leap == 3 || mode != 4 || stratum == 0 || stratum > 15)
+    {
+        return false;
+    }
+    // Must answer our request, not an old or spoofed one
+    if (readTimestamp(packet + 24) != originate)
+    {
+        return false;
+    }
+    uint64_t receiveTs = readTimestamp(packet + 32);
+    uint64_t transmitTs = readTimestamp(packet + 40);
+    if (receiveTs == 0 || transmitTs == 0)
+    {
+        return false;
+    }
+
+    int64_t t2 = fromNtp(receiveTs);
+    int64_t t3 = fromNtp(transmitTs);
+    out.offsetUs = ((t2 - t1Us) + (t3 - t4Us)) / 2;
+    out.delayUs = (t4Us - t1Us) - (t3 - t2);
+    if (out.delayUs < 0)
+    {
+        out.delayUs = 0;
+    }
+    out.stratum = stratum;
+    return true;
+}
+
+void SntpClient::setServerCount(uint8_t count)
+{
+    serverCount = count < MAX_SERVERS ? count : MAX_SERVERS;
+}
+
+void SntpClient::request(unsigned long nowMs)
+{
+    if (!querying)
+    {
+        startQuery(nowMs);
+    }
+}
+
+void SntpClient::startQuery(unsigned long nowMs)
+{
+    attempted = true;
+    lastAttempt = nowMs;
+    if (serverCount == 0 || !driver.open())
+    {
+        lastFailed = true;
+        state.failures++;
+        return;
+    }
+    querying = true;
+    queryStart = nowMs;
+    replies = 0;
+    haveBest = false;
+
+    uint8_t packet[PACKET_SIZE];
+    for (uint8_t i = 0; i < serverCount; i++)
+    {
+        sentUs[i] = driver.nowUs();
+        // Stamped with the local time; the reply must echo it back
+        sentNtp[i] = toNtp(sentUs[i]);
+        buildRequest(packet, sentNtp[i]);
+        if (!driver.send(i, packet, PACKET_SIZE))
+        {
+            sentNtp[i] = 0;
+        }
+    }
+}
+
+void SntpClient::update(unsigned long nowMs, bool online)
+{
+    if (querying)
+    {
+        uint8_t packet[PACKET_SIZE];
+        uint8_t server;
+        size_t len;
+        while ((len = driver.receive(packet, sizeof(packet), server)) > 0)
+        {
+            int64_t received = driver.nowUs();
+            SntpSample sample;
+            if (server >= serverCount || sentNtp[server] == 0 ||
+                !parseReply(packet, len, sentNtp[server], sentUs[server], received, sample))
+            {
+                continue;
+            }
+            sentNtp[server] = 0; // one reply per server
+            sample.server = server;
+            if (replies++ == 0)
+            {
+                firstReply = nowMs;
+            }
+            if (!haveBest || sample.delayUs < best.delayUs)
+            {
+                best = sample;
+                haveBest = true;
+            }
+        }
+
+        // Fast first sync: any valid answer beats a 1970 clock
+        bool done = (haveBest && !state.synced) || replies == serverCount ||
+                    (haveBest && nowMs - firstReply >= SELECT_WINDOW) || nowMs - queryStart >= QUERY_TIMEOUT;
+        if (done)
+        {
+            finishQuery(nowMs);
+        }
+        return;
+    }
+
+    compensate();
+    if (online && due(nowMs))
+    {
+        startQuery(nowMs);
+    }
+}
+
+void SntpClient::finishQuery(unsigned long nowMs)
+{
+    (void)nowMs;
+    querying = false;
+    driver.close();
+    lastFailed = !haveBest;
+    if (haveBest)
+    {
+        apply(best);
+    }
+    else
+    {
+        state.failures++;
+    }
+}
+
+void SntpClient::apply(const SntpSample &sample)
+{
+    int64_t now = driver.nowUs();
+    if (state.synced)
+    {
+        int64_t elapsed = now - state.lastSyncUs;
+        if (elapsed >= (int64_t)MIN_DRIFT_SPAN * 1000000)
+        {
+            // The clock gained -offset since the last sync, of which
+            // compensatedUs were our own corrections
+            float raw = (float)(-sample.offsetUs - state.compensatedUs) * 1e6f / (float)elapsed;
+            state.driftPpm = state.driftKnown ? 0.75f * state.driftPpm + 0.25f * raw : raw;
+            state.driftKnown = true;
+
+            // What compensation left over decides the next interval
+            float residualPpm = (float)magnitude(sample.offsetUs) * 1e6f / (float)elapsed;
+            float interval = residualPpm > 0 ? (float)TARGET_ERROR_US / residualPpm : (float)MAX_INTERVAL;
+            state.intervalS = interval > MAX_INTERVAL   ? MAX_INTERVAL
+                              : interval < MIN_INTERVAL ? MIN_INTERVAL
+                                                        : (uint32_t)interval;
+        }
+    }
+    if (state.intervalS == 0)
+    {
+        state.intervalS = MIN_INTERVAL;
+    }
+
+    bool step = !state.synced || magnitude(sample.offsetUs) > STEP_THRESHOLD_US;
+    driver.adjust(sample.offsetUs, step);
+
+    state.synced = true;
+    state.lastSyncUs = now + sample.offsetUs;
+    state.lastCompensationUs = state.lastSyncUs;
+    state.compensatedUs = 0;
+    state.lastOffsetUs = sample.offsetUs;
+    state.lastDelayUs = sample.delayUs;
+    state.syncs++;
+}
+
+void SntpClient::compensate()
+{
+    if (!state.synced || !state.driftKnown)
+    {
+        return;
+    }
+    int64_t now = driver.nowUs();
+    int64_t correction = -(int64_t)(state.driftPpm * (float)(now - state.lastCompensationUs) / 1e6f);
+    if (magnitude(correction) < COMPENSATE_STEP_US)
+    {
+        return;
+    }
+    driver.adjust(correction, false);
+    state.compensatedUs += correction;
+    state.lastCompensationUs = now;
+}
+
+bool SntpClient::due(unsigned long nowMs)
+{
+    if (attempted && lastFailed && nowMs - lastAttempt < (state.synced ? RETRY_SYNCED : RETRY_UNSYNCED))
+    {
+        return false;
+    }
+    if (!state.synced)
+    {
+        return true;
+    }
+    return driver.nowUs() - state.lastSyncUs >= (int64_t)state.intervalS * 1000000;
+}
+
+unsigned long SntpClient::millisUntilNextStep(unsigned long nowMs, bool online)
+{
+    if (querying)
+    {
+        return 20; // poll for replies
+    }
+    if (!online)
+    {
+        return 0xFFFFFFFFUL;
+    }
+    if (attempted && lastFailed)
+    {
+        unsigned long retry = state.synced ? RETRY_SYNCED : RETRY_UNSYNCED;
+        unsigned long elapsed = nowMs - lastAttempt;
+        if (elapsed < retry)
+        {
+            return retry - elapsed;
+        }
+    }
+    if (!state.synced)
+    {
+        return 0;
+    }
+    int64_t remaining = state.lastSyncUs + (int64_t)state.intervalS * 1000000 - driver.nowUs();
+    // Rounded up: under a millisecond to go must not read as due now, or
+    // the loop spins until the query is actually due
+    return remaining <= 0 ? 0 : (unsigned long)((remaining + 999) / 1000);
+}
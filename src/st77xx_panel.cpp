@@ -0,0 +1,465 @@
+#include "st77xx_panel.h"
+
+// ST7735 command set (subset used here)
+#define ST77XX_SWRESET 0x01
+#define ST77XX_SLPIN 0x10
+#define ST77XX_SLPOUT 0x11
+#define ST77XX_NORON 0x13
+#define ST77XX_INVOFF 0x20
+#define ST77XX_INVON 0x21
+#define ST77XX_DISPOFF 0x28
+#define ST77XX_DISPON 0x29
+#define ST77XX_CASET 0x2A
+#define ST77XX_RASET 0x2B
+#define ST77XX_RAMWR 0x2C
+#define ST77XX_MADCTL 0x36
+#define ST77XX_COLMOD 0x3A
+#define ST7735_FRMCTR1 0xB1
+#define ST7735_FRMCTR2 0xB2
+#define ST7735_FRMCTR3 0xB3
+#define ST7735_INVCTR 0xB4
+#define ST7735_PWCTR1 0xC0
+#define ST7735_PWCTR2 0xC1
+#define ST7735_PWCTR3 0xC2
+#define ST7735_PWCTR4 0xC3
+#define ST7735_PWCTR5 0xC4
+#define ST7735_VMCTR1 0xC5
+#define ST7735_GMCTRP1 0xE0
+#define ST7735_GMCTRN1 0xE1
+
+#define CMD_DELAY 0x80
+
+// 7735R green tab init sequence, equivalent to Adafruit's Rcmd1 + Rcmd2green +
+// Rcmd3 + setRotation(0). Format: count, then {cmd, nargs|CMD_DELAY, args.., [ms]}
+static const uint8_t INIT_GREENTAB[] = {
+    19,
+    ST77XX_SWRESET, CMD_DELAY, 150,
+    ST77XX_SLPOUT, CMD_DELAY, 255,
+    ST7735_FRMCTR1, 3, 0x01, 0x2C, 0x2D,
+    ST7735_FRMCTR2, 3, 0x01, 0x2C, 0x2D,
+    ST7735_FRMCTR3, 6, 0x01, 0x2C, 0x2D, 0x01, 0x2C, 0x2D,
+    ST7735_INVCTR, 1, 0x07,
+    ST7735_PWCTR1, 3, 0xA2, 0x02, 0x84,
+    ST7735_PWCTR2, 1, 0xC5,
+    ST7735_PWCTR3, 2, 0x0A, 0x00,
+    ST7735_PWCTR4, 2, 0x8A, 0x2A,
+    ST7735_PWCTR5, 2, 0x8A, 0xEE,
+    ST7735_VMCTR1, 1, 0x0E,
+    ST77XX_INVOFF, 0,
+    ST77XX_MADCTL, 1, 0xC8, // MX | MY | BGR
+    ST77XX_COLMOD, 1, 0x05, // 16-bit colour
+    ST7735_GMCTRP1, 16,
+    0x02, 0x1c, 0x07, 0x12, 0x37, 0x32, 0x29, 0x2d,
+    0x29, 0x25, 0x2B, 0x39, 0x00, 0x01, 0x03, 0x10,
+    ST7735_GMCTRN1, 16,
+    0x03, 0x1d, 0x07, 0x06, 0x2E, 0x2C, 0x29, 0x2D,
+    0x2E, 0x2E, 0x37, 0x3F, 0x00, 0x00, 0x02, 0x10,
+    ST77XX_NORON, CMD_DELAY, 10,
+    ST77XX_DISPON, CMD_DELAY, 100};
+
+St77xxPanel::St77xxPanel(PanelBus &bus, int16_t w, int16_t h, uint8_t colStart, uint8_t rowStart)
+    : Adafruit_GFX(w, h), bus(bus), colStart(colStart), rowStart(rowStart), batching(true),
+      writeDepth(0), frameDepth(0), winX0(-1), winX1(-1), winY0(-1), winY1(-1),
+      asleep(false), streaming(false), streamX(0), streamY(0), runColor(0), runLength(0), lineUsed(0)
+{
+    resetStats();
+}
+
+void St77xxPanel::begin()
+{
+    bus.begin();
+    bus.hardwareReset();
+    runCommandList(INIT_GREENTAB);
+}
+
+void St77xxPanel::prepareDeepSleep()
+{
+    flushPixels();
+    bus.holdPins(true);
+}
+
+void St77xxPanel::resumeFromDeepSleep(bool panelAsleep)
+{
+    bus.begin();
+    bus.holdPins(false);
+    asleep = panelAsleep;
+    // The controller kept its window, but this instance doesn't know it
+    winX0 = winX1 = winY0 = winY1 = -1;
+    streaming = false;
+}
+
+void St77xxPanel::sleep()
+{
+    if (asleep)
+    {
+        return;
+    }
+    startWrite();
+    flushPixels();
+    streaming = false;
+    bus.writeCommand(ST77XX_DISPOFF);
+    bus.writeCommand(ST77XX_SLPIN);
+    endWrite();
+    // SLPIN needs 5 ms before the next command
+    bus.delayMs(5);
+    asleep = true;
+}
+
+void St77xxPanel::wake()
+{
+    if (!asleep)
+    {
+        return;
+    }
+    sendCommand(ST77XX_SLPOUT);
+    // Booster and oscillator settle time before RAM writes or DISPON
+    bus.delayMs(120);
+    asleep = false;
+}
+
+void St77xxPanel::setDisplayOn(bool on)
+{
+    sendCommand(on ? ST77XX_DISPON : ST77XX_DISPOFF);
+}
+
+void St77xxPanel::runCommandList(const uint8_t *list)
+{
+    uint8_t numCommands = *list++;
+
+    // The whole list goes out in a single transaction
+    startWrite();
+    while (numCommands--)
+    {
+        uint8_t cmd = *list++;
+        uint8_t numArgs = *list++;
+        bool hasDelay = numArgs & CMD_DELAY;
+        numArgs &= ~CMD_DELAY;
+
+        bus.writeCommand(cmd);
+        if (numArgs)
+        {
+            bus.writeData(list, numArgs);
+            list += numArgs;
+        }
+        if (hasDelay)
+        {
+            uint16_t ms = *list++;
+            bus.delayMs(ms == 255 ? 500 : ms);
+        }
+    }
+    endWrite();
+
+    // SWRESET forgets the address window
+    winX0 = winX1 = winY0 = winY1 = -1;
+    streaming = false;
+}
+
+void St77xxPanel::setBatching(bool enabled)
+{
+    flushPixels();
+    batching = enabled;
+    streaming = false;
+    winX0 = winX1 = winY0 = winY1 = -1;
+}
+
+void St77xxPanel::resetStats()
+{
+    counters = Stats();
+}
+
+void St77xxPanel::beginFrame()
+{
+    if (frameDepth++ == 0)
+    {
+        counters.frames++;
+        if (batching)
+        {
+            startWrite();
+        }
+    }
+}
+
+void St77xxPanel::endFrame()
+{
+    if (frameDepth == 0)
+    {
+        return;
+    }
+    if (--frameDepth == 0 && batching)
+    {
+        endWrite();
+    }
+}
+
+void St77xxPanel::startWrite()
+{
+    if (writeDepth++ == 0)
+    {
+        bus.beginTransaction();
+    }
+}
+
+void St77xxPanel::endWrite()
+{
+    if (writeDepth == 0)
+    {
+        return;
+    }
+    if (--writeDepth == 0)
+    {
+        flushPixels();
+        bus.endTransaction();
+    }
+}
+
+void St77xxPanel::sendCommand(uint8_t cmd, const uint8_t *args, uint8_t numArgs)
+{
+    startWrite();
+    flushPixels();
+    streaming = false;
+    bus.writeCommand(cmd);
+    if (numArgs)
+    {
+        bus.writeData(args, numArgs);
+    }
+    endWrite();
+}
+
+void St77xxPanel::openWindow(int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+    flushPixels();
+
+    if (!batching || x0 != winX0 || x1 != winX1)
+    {
+        uint16_t xa = x0 + colStart;
+        uint16_t xb = x1 + colStart;
+        uint8_t cols[4] = {(uint8_t)(xa >> 8), (uint8_t)xa, (uint8_t)(xb >> 8), (uint8_t)xb};
+        bus.writeCommand(ST77XX_CASET);
+        bus.writeData(cols, sizeof(cols));
+        winX0 = x0;
+        winX1 = x1;
+        counters.windowSets++;
+    }
+    else
+    {
+        counters.windowSkips++;
+    }
+
+    if (!batching || y0 != winY0 || y1 != winY1)
+    {
+        uint16_t ya = y0 + rowStart;
+        uint16_t yb = y1 + rowStart;
+        uint8_t rows[4] = {(uint8_t)(ya >> 8), (uint8_t)ya, (uint8_t)(yb >> 8), (uint8_t)yb};
+        bus.writeCommand(ST77XX_RASET);
+        bus.writeData(rows, sizeof(rows));
+        winY0 = y0;
+        winY1 = y1;
+        counters.windowSets++;
+    }
+    else
+    {
+        counters.windowSkips++;
+    }
+
+    bus.writeCommand(ST77XX_RAMWR);
+    streaming = true;
+    streamX = x0;
+    streamY = y0;
+}
+
+void St77xxPanel::setAddrWindow(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+    startWrite();
+    openWindow(x, y, x + w - 1, y + h - 1);
+    endWrite();
+}
+
+void St77xxPanel::pushPixels(const uint16_t *pixels, uint32_t count)
+{
+    startWrite();
+    flushPixels();
+    bus.writePixels(pixels, count);
+    counters.pixels += count;
+    // The caller owns the window layout; don't try to continue it
+    streaming = false;
+    endWrite();
+}
+
+void St77xxPanel::queuePixel(uint16_t color)
+{
+    counters.pixels++;
+    if (runLength && color == runColor)
+    {
+        runLength++;
+        return;
+    }
+    flushRun();
+    runColor = color;
+    runLength = 1;
+}
+
+void St77xxPanel::flushRun()
+{
+    if (!runLength)
+    {
+        return;
+    }
+    if (runLength >= MIN_REPEAT_RUN)
+    {
+        flushLine();
+        bus.writeRepeat(runColor, runLength);
+    }
+    else
+    {
+        while (runLength)
+        {
+            if (lineUsed == LINE_PIXELS)
+            {
+                flushLine();
+            }
+            line[lineUsed++] = runColor;
+            runLength--;
+        }
+    }
+    runLength = 0;
+}
+
+void St77xxPanel::flushLine()
+{
+    if (lineUsed)
+    {
+        bus.writePixels(line, lineUsed);
+        lineUsed = 0;
+    }
+}
+
+void St77xxPanel::flushPixels()
+{
+    flushRun();
+    flushLine();
+}
+
+bool St77xxPanel::clip(int16_t &x, int16_t &y, int16_t &w, int16_t &h) const
+{
+    if (w < 0)
+    {
+        x += w + 1;
+        w = -w;
+    }
+    if (h < 0)
+    {
+        y += h + 1;
+        h = -h;
+    }
+    if (x < 0)
+    {
+        w += x;
+        x = 0;
+    }
+    if (y < 0)
+    {
+        h += y;
+        y = 0;
+    }
+    if (x + w > _width)
+    {
+        w = _width - x;
+    }
+    if (y + h > _height)
+    {
+        h = _height - y;
+    }
+    return w > 0 && h > 0;
+}
+
+void St77xxPanel::writePixel(int16_t x, int16_t y, uint16_t color)
+{
+    if (x < 0 || y < 0 || x >= _width || y >= _height)
+    {
+        return;
+    }
+
+    if (batching && streaming && x == streamX && y == streamY)
+    {
+        counters.streamed++;
+    }
+    else if (batching)
+    {
+        // Open the rest of the row so horizontally adjacent pixels (glyph
+        // scanlines) keep streaming; the row range usually doesn't change
+        openWindow(x, y, _width - 1, y);
+    }
+    else
+    {
+        openWindow(x, y, x, y);
+    }
+
+    queuePixel(color);
+
+    if (++streamX > winX1)
+    {
+        // Past the end of the window: the controller wraps, we don't follow
+        streaming = false;
+    }
+}
+
+void St77xxPanel::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    if (!clip(x, y, w, h))
+    {
+        return;
+    }
+    openWindow(x, y, x + w - 1, y + h - 1);
+    flushPixels();
+    bus.writeRepeat(color, (uint32_t)w * h);
+    counters.pixels += (uint32_t)w * h;
+    streaming = false;
+}
+
+void St77xxPanel::writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    writeFillRect(x, y, w, 1, color);
+}
+
+void St77xxPanel::writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    writeFillRect(x, y, 1, h, color);
+}
+
+void St77xxPanel::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+    startWrite();
+    writePixel(x, y, color);
+    endWrite();
+}
+
+void St77xxPanel::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+    startWrite();
+    writeFillRect(x, y, w, 1, color);
+    endWrite();
+}
+
+void St77xxPanel::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+    startWrite();
+    writeFillRect(x, y, 1, h, color);
+    endWrite();
+}
+
+void St77xxPanel::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    startWrite();
+    writeFillRect(x, y, w, h, color);
+    endWrite();
+}
+
+void St77xxPanel::fillScreen(uint16_t color)
+{
+    fillRect(0, 0, _width, _height, color);
+}
+
+void St77xxPanel::invertDisplay(bool invert)
+{
+    sendCommand(invert ? ST77XX_INVON : ST77XX_INVOFF);
+}
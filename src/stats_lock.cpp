@@ -0,0 +1,18 @@
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include "stats_lock.h"
+
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+StatsLock::StatsLock()
+{
+    portENTER_CRITICAL(&statsMux);
+}
+
+StatsLock::~StatsLock()
+{
+    portEXIT_CRITICAL(&statsMux);
+}
+
+#endif // ARDUINO
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <string.h>
+#include "telemetry.h"
+#include "report_buffer.h"
+#include "stats_lock.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_system.h>
+#endif
+
+const char *const Telemetry::TASK_NAMES[TASK_COUNT] = {"loopTask", "arduino_events", "tiT", "wifi", "diag", "log"};
+
+Telemetry::Sample Telemetry::ring[CAPACITY];
+uint8_t Telemetry::head = 0;
+uint8_t Telemetry::used = 0;
+unsigned long Telemetry::lastSample = 0;
+bool Telemetry::sampled = false;
+uint32_t Telemetry::fetchOk = 0;
+uint32_t Telemetry::fetchFailed = 0;
+const char *Telemetry::resetReason = "unknown";
+
+void Telemetry::begin()
+{
+#ifdef ARDUINO
+    switch (esp_reset_reason())
+    {
+    case ESP_RST_POWERON:
+        resetReason = "power-on";
+        break;
+    case ESP_RST_SW:
+        resetReason = "software";
+        break;
+    case ESP_RST_PANIC:
+        resetReason = "panic";
+        break;
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+        resetReason = "watchdog";
+        break;
+    case ESP_RST_BROWNOUT:
+        resetReason = "brownout";
+        break;
+    case ESP_RST_DEEPSLEEP:
+        resetReason = "deep sleep";
+        break;
+    default:
+        resetReason = "other";
+        break;
+    }
+#else
+    resetReason = "host";
+#endif
+}
+
+bool Telemetry::sampleDue(unsigned long now)
+{
+    return !sampled || now - lastSample >= SAMPLE_INTERVAL;
+}
+
+unsigned long Telemetry::millisUntilSample(unsigned long now)
+{
+    if (sampleDue(now))
+    {
+        return 0;
+    }
+    return SAMPLE_INTERVAL - (now - lastSample);
+}
+
+void Telemetry::sample(unsigned long now)
+{
+    Sample s = {};
+    s.uptime = now / 1000;
+#ifdef ARDUINO
+    s.freeHeap = ESP.getFreeHeap();
+    s.largestBlock = ESP.getMaxAllocHeap();
+    s.minFreeHeap = ESP.getMinFreeHeap();
+    for (uint8_t i = 0; i < TASK_COUNT; i++)
+    {
+        TaskHandle_t task = xTaskGetHandle(TASK_NAMES[i]);
+        // ESP-IDF reports the high-water mark in bytes
+        s.stackFree[i] = task ? (uint16_t)uxTaskGetStackHighWaterMark(task) : 0;
+    }
+#endif
+    s.fetchFailures = (uint16_t)fetchFailed;
+    lastSample = now;
+    sampled = true;
+    record(s);
+}
+
+void Telemetry::record(const Sample &s)
+{
+    // The /diag task reads the ring while loop() writes it
+    StatsLock lock;
+    ring[head] = s;
+    head = (head + 1) % CAPACITY;
+    if (used < CAPACITY)
+    {
+        used++;
+    }
+}
+
+void Telemetry::noteFetch(bool ok)
+{
+    StatsLock lock;
+    if (ok)
+    {
+        fetchOk++;
+    }
+    else
+    {
+        fetchFailed++;
+    }
+}
+
+const Telemetry::Sample &Telemetry::at(uint8_t index)
+{
+    return ring[(head + CAPACITY - used + index) % CAPACITY];
+}
+
+size_t Telemetry::formatReport(char *buffer, size_t size)
+{
+    size_t len = 0;
+    if (size == 0)
+    {
+        return 0;
+    }
+    buffer[0] = '\0';
+
+    uint8_t count;
+    Sample latest;
+    uint32_t ok;
+    uint32_t failed;
+    {
+        StatsLock lock;
+        count = used;
+        latest = count ? at(count - 1) : Sample();
+        ok = fetchOk;
+        failed = fetchFailed;
+    }
+
+    appendf(buffer, size, len, "reset reason: %s\n", resetReason);
+    appendf(buffer, size, len, "fetches: %u ok, %u failed\n", (unsigned)ok, (unsigned)failed);
+    if (count)
+    {
+        unsigned fragmentation = latest.freeHeap
+                                     ? 100 - (unsigned)((uint64_t)latest.largestBlock * 100 / latest.freeHeap)
+                                     : 0;
+        appendf(buffer, size, len, "uptime %u s, heap %u free, %u largest (%u%% fragmented), %u min\n",
+                (unsigned)latest.uptime, (unsigned)latest.freeHeap, (unsigned)latest.largestBlock,
+                fragmentation, (unsigned)latest.minFreeHeap);
+    }
+
+    appendf(buffer, size, len, "uptime,free,largest,min");
+    for (uint8_t t = 0; t < TASK_COUNT; t++)
+    {
+        appendf(buffer, size, len, ",%s", TASK_NAMES[t]);
+    }
+    appendf(buffer, size, len, ",failures\n");
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        Sample s;
+        {
+            StatsLock lock;
+            s = at(i);
+        }
+
+        appendf(buffer, size, len, "%u,%u,%u,%u", (unsigned)s.uptime, (unsigned)s.freeHeap,
+                (unsigned)s.largestBlock, (unsigned)s.minFreeHeap);
+        for (uint8_t t = 0; t < TASK_COUNT; t++)
+        {
+            appendf(buffer, size, len, ",%u", (unsigned)s.stackFree[t]);
+        }
+        appendf(buffer, size, len, ",%u\n", (unsigned)s.fetchFailures);
+    }
+    return len;
+}
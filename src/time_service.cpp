@@ -0,0 +1,142 @@
+#include <stdlib.h>
+#include <sys/time.h>
+#include "time_service.h"
+#include "profiler.h"
+
+// How far ahead to look for the next DST change before giving up (no DST zone)
+static const time_t TRANSITION_SEARCH_LIMIT = 366L * 24 * 3600;
+
+const char *TimeService::posixZone = "UTC0";
+char TimeService::text[6] = "00:00";
+int TimeService::localHour = 0;
+int TimeService::localMinute = 0;
+time_t TimeService::minuteStart = 0;
+time_t TimeService::nextTransition = 0;
+bool TimeService::valid = false;
+
+void TimeService::begin(const char *posixTz)
+{
+    posixZone = posixTz;
+    setenv("TZ", posixTz, 1);
+    tzset();
+    valid = false;
+    update();
+}
+
+void TimeService::invalidate()
+{
+    valid = false;
+}
+
+bool TimeService::update()
+{
+    FT_PROFILE_ZONE("time update");
+    time_t now = time(nullptr);
+
+    // Common case: same minute. Unsigned maths also catches backward steps.
+    if (valid && (unsigned long)(now - minuteStart) < 60)
+    {
+        return false;
+    }
+
+    if (valid && (unsigned long)(now - minuteStart) < 120 && minuteStart + 60 < nextTransition)
+    {
+        advanceOneMinute();
+    }
+    else
+    {
+        recompute(now);
+    }
+    return true;
+}
+
+unsigned long TimeService::millisUntilNextMinute()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (59 - tv.tv_sec % 60) * 1000UL + (1000 - tv.tv_usec / 1000);
+}
+
+void TimeService::recompute(time_t now)
+{
+    struct tm local;
+    localtime_r(&now, &local);
+
+    localHour = local.tm_hour;
+    localMinute = local.tm_min;
+    minuteStart = now - local.tm_sec;
+    if (!valid || now >= nextTransition)
+    {
+        nextTransition = findNextTransition(now);
+    }
+    valid = true;
+    format();
+}
+
+void TimeService::advanceOneMinute()
+{
+    minuteStart += 60;
+    if (++localMinute == 60)
+    {
+        localMinute = 0;
+        if (++localHour == 24)
+        {
+            localHour = 0;
+        }
+    }
+    format();
+}
+
+void TimeService::format()
+{
+    text[0] = '0' + localHour / 10;
+    text[1] = '0' + localHour % 10;
+    text[2] = ':';
+    text[3] = '0' + localMinute / 10;
+    text[4] = '0' + localMinute % 10;
+    text[5] = '\0';
+}
+
+time_t TimeService::findNextTransition(time_t from)
+{
+    struct tm local;
+    localtime_r(&from, &local);
+    int isDst = local.tm_isdst;
+
+    // Walk forward a day at a time until DST flips...
+    time_t lo = from;
+    time_t hi = from;
+    bool found = false;
+    while (hi - from < TRANSITION_SEARCH_LIMIT)
+    {
+        hi += 24 * 3600;
+        localtime_r(&hi, &local);
+        if (local.tm_isdst != isDst)
+        {
+            found = true;
+            break;
+        }
+        lo = hi;
+    }
+    if (!found)
+    {
+        // No transition within a year: look again when that time comes
+        return from + TRANSITION_SEARCH_LIMIT;
+    }
+
+    // ...then bisect to the first second on the other side
+    while (hi - lo > 1)
+    {
+        time_t mid = lo + (hi - lo) / 2;
+        localtime_r(&mid, &local);
+        if (local.tm_isdst == isDst)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return hi;
+}
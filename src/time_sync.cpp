@@ -0,0 +1,176 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <esp_attr.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include "time_sync.h"
+#include "time_service.h"
+#include "ft_wifi_manager.h"
+#include "ft_log.h"
+#include "report_buffer.h"
+#include "stats_lock.h"
+
+static constexpr char TAG[] = "time";
+
+static const char *const SERVERS[] = {"pool.ntp.org", "time.google.com", "time.nist.gov"};
+static const uint8_t SERVER_COUNT = sizeof(SERVERS) / sizeof(SERVERS[0]);
+static const uint16_t NTP_PORT = 123;
+
+RTC_DATA_ATTR static SntpClient::Retained rtcState;
+
+class EspSntpDriver : public SntpDriver
+{
+public:
+    bool open() override
+    {
+        // Resolved per query: pool.ntp.org rotates, and DNS answers are cached anyway
+        for (uint8_t i = 0; i < SERVER_COUNT; i++)
+        {
+            if (!WiFi.hostByName(SERVERS[i], addresses[i]))
+            {
+                addresses[i] = IPAddress((uint32_t)0);
+            }
+        }
+        return udp.begin(0) != 0;
+    }
+
+    void close() override
+    {
+        udp.stop();
+    }
+
+    bool send(uint8_t server, const uint8_t *packet, size_t len) override
+    {
+        if ((uint32_t)addresses[server] == 0)
+        {
+            return false;
+        }
+        return udp.beginPacket(addresses[server], NTP_PORT) && udp.write(packet, len) == len && udp.endPacket();
+    }
+
+    size_t receive(uint8_t *packet, size_t size, uint8_t &server) override
+    {
+        while (udp.parsePacket() > 0)
+        {
+            IPAddress from = udp.remoteIP();
+            size_t len = udp.read(packet, size);
+            for (server = 0; server < SERVER_COUNT; server++)
+            {
+                if (addresses[server] == from)
+                {
+                    return len;
+                }
+            }
+        }
+        return 0;
+    }
+
+    int64_t nowUs() override
+    {
+        struct timeval tv;
+        gettimeofday(&tv, nullptr);
+        return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+    }
+
+    void adjust(int64_t deltaUs, bool step) override
+    {
+        if (step)
+        {
+            int64_t target = nowUs() + deltaUs;
+            struct timeval tv = {(time_t)(target / 1000000), (suseconds_t)(target % 1000000)};
+            settimeofday(&tv, nullptr);
+            TimeService::invalidate();
+        }
+        else
+        {
+            struct timeval tv = {(time_t)(deltaUs / 1000000), (suseconds_t)(deltaUs % 1000000)};
+            adjtime(&tv, nullptr);
+        }
+    }
+
+private:
+    WiFiUDP udp;
+    IPAddress addresses[SERVER_COUNT];
+};
+
+static EspSntpDriver driver;
+static SntpClient client(driver, rtcState);
+// Copy of the client's state for formatReport(), which runs on the diag
+// task; the client itself is only touched from loop()
+static SntpClient::Retained published;
+
+static void publish()
+{
+    StatsLock lock;
+    published = client.stats();
+}
+
+void TimeSync::begin()
+{
+    // RTC memory survives resets that lose the clock; don't trust it then
+    if (!TimeService::isSet())
+    {
+        rtcState = SntpClient::Retained();
+    }
+    client.setServerCount(SERVER_COUNT);
+    publish();
+}
+
+void TimeSync::request()
+{
+    client.request(millis());
+}
+
+void TimeSync::update()
+{
+    uint32_t syncs = client.stats().syncs;
+    client.update(millis(), FtWiFiManager::isConnected());
+    if (client.stats().syncs != syncs)
+    {
+        FT_LOGI(TAG, "Clock synced: offset %lld us, error <= %lld us, drift %.2f ppm, next in %u s",
+                (long long)client.stats().lastOffsetUs, (long long)(client.stats().lastDelayUs / 2),
+                client.stats().driftPpm, (unsigned)client.stats().intervalS);
+    }
+    publish();
+}
+
+unsigned long TimeSync::millisUntilNextStep()
+{
+    return client.millisUntilNextStep(millis(), FtWiFiManager::isConnected());
+}
+
+bool TimeSync::isQuerying()
+{
+    return client.isQuerying();
+}
+
+bool TimeSync::isSynced()
+{
+    return client.isSynced();
+}
+
+const SntpClient::Retained &TimeSync::stats()
+{
+    return client.stats();
+}
+
+size_t TimeSync::formatReport(char *buffer, size_t size)
+{
+    size_t len = 0;
+    if (size == 0)
+    {
+        return 0;
+    }
+    buffer[0] = '\0';
+    SntpClient::Retained s;
+    {
+        StatsLock lock;
+        s = published;
+    }
+    appendf(buffer, size, len,
+            "time: %s, offset %lld us, error <= %lld us, drift %.2f ppm%s, resync every %u s, %u syncs, %u failed\n",
+            s.synced ? "synced" : "not synced", (long long)s.lastOffsetUs, (long long)(s.lastDelayUs / 2), s.driftPpm,
+            s.driftKnown ? "" : " (not measured)", (unsigned)s.intervalS, (unsigned)s.syncs, (unsigned)s.failures);
+    return len;
+}
@@ -1,44 +1,102 @@
 #include <sys/time.h>
 #include "weather_manager.h"
 #include "display_manager.h"
+#include "json_arena.h"
+#include "cpu_governor.h"
 #include <Arduino.h>
+#include "ft_log.h"
+#include "profiler.h"
 
-HTTPClient WeatherManager::httpClient;
+static constexpr char TAG[] = "weather";
+
+HttpFetch WeatherManager::http(FetchMetrics::ENDPOINT_WEATHER);
+SnapshotGate WeatherManager::gate;
+char WeatherManager::lastTemperature[16] = "";
+char WeatherManager::lastHumidity[16] = "";
+
+void WeatherManager::apply(const char *temperature, const char *humidity)
+{
+    strncpy(lastTemperature, temperature, sizeof(lastTemperature) - 1);
+    strncpy(lastHumidity, humidity, sizeof(lastHumidity) - 1);
+    DisplayManager::setWeatherInfo(lastTemperature, lastHumidity);
+}
+
+void WeatherManager::buildFilter(JsonDocument &filter)
+{
+    filter["current"]["temperature_2m"] = true;
+    filter["current"]["relative_humidity_2m"] = true;
+}
+
+static void formatValue(JsonVariantConst value, FieldText &out)
+{
+    out.clear();
+    if (value.is<float>())
+    {
+        serializeJson(value, out.data(), FieldText::CAPACITY + 1);
+        out.resync();
+    }
+}
 
 bool WeatherManager::fetchData()
 {
-    String API_URL = "https://api.open-meteo.com/v1/forecast?latitude=28.652107&longitude=-17.7754653&current=temperature_2m,relative_humidity_2m";
+    FT_PROFILE_ZONE("weather fetch");
+    const char *API_URL = "https://api.open-meteo.com/v1/forecast?latitude=28.652107&longitude=-17.7754653&current=temperature_2m,relative_humidity_2m";
 
-    Serial.println("Attempting to fetch data from URL: " + String(API_URL));
-    httpClient.begin(API_URL);
-    int httpCode = httpClient.GET();
-    Serial.print("HTTP GET request sent. Response code: ");
-    Serial.println(httpCode);
+    FT_LOGD(TAG, "Attempting to fetch data from URL: %s", API_URL);
+    int httpCode = http.get(API_URL);
+    FT_LOGD(TAG, "HTTP GET request sent. Response code: %d", httpCode);
+    if (http.timer().reached(FetchMetrics::STAGE_CONNECT))
+    {
+        CpuGovernor::noteHandshake(http.timer().stageMs(FetchMetrics::STAGE_CONNECT));
+    }
 
     if (httpCode > 0)
     {
-        String payload = httpClient.getString();
-        httpClient.end();
-        JsonDocument doc;
+        JsonArena::reset();
 
-        DeserializationError error = deserializeJson(doc, payload);
+        JsonDocument filter(JsonArena::allocator());
+        buildFilter(filter);
+
+        JsonDocument doc(JsonArena::allocator());
+        DeserializationError error;
+        {
+            // Streamed from the socket, so this includes the body transfer
+            FT_PROFILE_ZONE("weather json");
+            error = deserializeJson(doc, http.body(), DeserializationOption::Filter(filter));
+        }
+        http.end(!error);
+        JsonArena::report("Weather");
         if (error)
         {
-            Serial.print(F("deserializeJson() failed: "));
-            Serial.println(error.c_str());
+            FT_LOGE(TAG, "deserializeJson() failed: %s", error.c_str());
             return false;
         }
-        Serial.println("JSON parsing successful.");
-        DisplayManager::setWeatherInfo(
-            doc["current"]["temperature_2m"].as<String>(),
-            doc["current"]["relative_humidity_2m"].as<String>());
+        FT_LOGD(TAG, "JSON parsing successful.");
+
+        // Serialize the numbers straight into inline buffers: same text as
+        // as<String>() without the two heap copies
+        FieldText temperature;
+        FieldText humidity;
+        formatValue(doc["current"]["temperature_2m"], temperature);
+        formatValue(doc["current"]["relative_humidity_2m"], humidity);
+        // drawTime() re-renders from the stored values after a clear, so the
+        // screen epoch doesn't matter here
+        if (gate.changed(SnapshotHash().add(temperature.c_str()).add(humidity.c_str()).result()))
+        {
+            apply(temperature.c_str(), humidity.c_str());
+        }
+        else
+        {
+            FT_LOGD(TAG, "Weather snapshot unchanged, update skipped.");
+        }
+        FT_LOGD(TAG, "Weather snapshots: %u applied, %u suppressed",
+                (unsigned)gate.appliedCount(), (unsigned)gate.suppressedCount());
         return true;
     }
     else
     {
-        Serial.print("HTTP GET request failed, error: ");
-        Serial.println(httpClient.errorToString(httpCode).c_str());
-        httpClient.end();
+        FT_LOGW(TAG, "HTTP GET request failed, error: %s", HTTPClient::errorToString(httpCode).c_str());
+        http.end(false);
         return false;
     }
 }
@@ -0,0 +1,166 @@
+#include "wifi_link.h"
+
+WiFiLink::WiFiLink(WiFiDriver &driver)
+    : driver(driver), current(LINK_OFF), since(0), budget(0), failed(0), dropCount(0), attemptCount(0)
+{
+}
+
+void WiFiLink::begin(unsigned long now, bool radioOn)
+{
+    current = LINK_OFF;
+    if (radioOn)
+    {
+        request(now);
+    }
+}
+
+void WiFiLink::request(unsigned long now)
+{
+    if (current == LINK_OFF)
+    {
+        startAttempt(now);
+    }
+}
+
+void WiFiLink::park()
+{
+    if (current == LINK_CONNECTED || current == LINK_BACKOFF)
+    {
+        driver.powerOff();
+        current = LINK_OFF;
+    }
+}
+
+void WiFiLink::openPortal(unsigned long now)
+{
+    if (current == LINK_PORTAL)
+    {
+        return;
+    }
+    current = LINK_PORTAL;
+    since = now;
+    driver.beginPortal();
+}
+
+void WiFiLink::startAttempt(unsigned long now)
+{
+    if (!driver.hasCredentials())
+    {
+        // Nothing to retry with; setup is the only way forward
+        openPortal(now);
+        return;
+    }
+    current = LINK_CONNECTING;
+    since = now;
+    budget = driver.beginAttempt();
+    attemptCount++;
+}
+
+unsigned long WiFiLink::backoffDelay() const
+{
+    unsigned long delay = INITIAL_BACKOFF;
+    for (uint8_t i = 1; i < failed && delay < MAX_BACKOFF; i++)
+    {
+        delay *= 2;
+    }
+    return delay < MAX_BACKOFF ? delay : MAX_BACKOFF;
+}
+
+void WiFiLink::enterBackoff(unsigned long now)
+{
+    if (failed < 0xFF)
+    {
+        failed++;
+    }
+    current = LINK_BACKOFF;
+    since = now;
+    budget = backoffDelay();
+}
+
+void WiFiLink::update(unsigned long now)
+{
+    switch (current)
+    {
+    case LINK_OFF:
+        break;
+
+    case LINK_CONNECTING:
+        if (driver.isConnected())
+        {
+            current = LINK_CONNECTED;
+            failed = 0;
+            driver.onConnected(now - since);
+        }
+        else if (now - since >= budget)
+        {
+            if (driver.abortAttempt())
+            {
+                startAttempt(now);
+            }
+            else
+            {
+                enterBackoff(now);
+            }
+        }
+        break;
+
+    case LINK_CONNECTED:
+        if (!driver.isConnected())
+        {
+            // The driver reconnects on its own first; only step in if that stalls
+            dropCount++;
+            current = LINK_CONNECTING;
+            since = now;
+            budget = DROP_GRACE;
+        }
+        break;
+
+    case LINK_BACKOFF:
+        if (driver.isConnected())
+        {
+            current = LINK_CONNECTED;
+            failed = 0;
+            driver.onConnected(now - since);
+        }
+        else if (now - since >= budget)
+        {
+            startAttempt(now);
+        }
+        break;
+
+    case LINK_PORTAL:
+        if (!driver.processPortal())
+        {
+            failed = 0;
+            if (driver.isConnected())
+            {
+                // Saved and joined from the portal
+                current = LINK_CONNECTED;
+                driver.onConnected(now - since);
+            }
+            else
+            {
+                // Timed out: back to trying the stored network
+                startAttempt(now);
+            }
+        }
+        break;
+    }
+}
+
+unsigned long WiFiLink::millisUntilNextStep(unsigned long now) const
+{
+    switch (current)
+    {
+    case LINK_CONNECTING:
+    case LINK_BACKOFF:
+    {
+        unsigned long elapsed = now - since;
+        return elapsed >= budget ? 0 : budget - elapsed;
+    }
+    case LINK_PORTAL:
+        return PORTAL_POLL;
+    default:
+        return NO_DEADLINE;
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef TEST_RAM_PANEL_BUS_H
+#define TEST_RAM_PANEL_BUS_H
+
+#include <stdint.h>
+#include "panel_bus.h"
+
+// The controller's frame memory for the display suites: CASET/RASET/RAMWR
+// land pixels in `ram`, everything else is accepted and ignored. No column
+// or row offset, so build the panel with colStart = rowStart = 0.
+class RamPanelBus : public PanelBus
+{
+public:
+    static const int16_t WIDTH = 128;
+    static const int16_t HEIGHT = 128;
+
+    uint16_t ram[HEIGHT][WIDTH];
+
+    void begin() override {}
+    void beginTransaction() override {}
+    void endTransaction() override {}
+    void delayMs(uint32_t) override {}
+
+    void writeCommand(uint8_t cmd) override
+    {
+        command = cmd;
+        argCount = 0;
+        if (cmd == 0x2C) // RAMWR
+        {
+            x = x0;
+            y = y0;
+        }
+    }
+
+    void writeData(const uint8_t *data, size_t len) override
+    {
+        for (size_t i = 0; i < len && argCount < 4; i++)
+        {
+            args[argCount++] = data[i];
+        }
+        if (argCount == 4 && (command == 0x2A || command == 0x2B)) // CASET, RASET
+        {
+            int16_t a = args[0] << 8 | args[1];
+            int16_t b = args[2] << 8 | args[3];
+            (command == 0x2A ? x0 : y0) = a;
+            (command == 0x2A ? x1 : y1) = b;
+        }
+    }
+
+    void writePixels(const uint16_t *pixels, size_t count) override
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            pixel(pixels[i]);
+        }
+    }
+
+    void writeRepeat(uint16_t color, uint32_t count) override
+    {
+        while (count--)
+        {
+            pixel(color);
+        }
+    }
+
+private:
+    void pixel(uint16_t color)
+    {
+        if (y > y1)
+        {
+            return;
+        }
+        ram[y][x] = color;
+        if (++x > x1)
+        {
+            x = x0;
+            y++;
+        }
+    }
+
+    uint8_t command = 0;
+    uint8_t args[4] = {};
+    uint8_t argCount = 0;
+    int16_t x0 = 0, x1 = WIDTH - 1, y0 = 0, y1 = HEIGHT - 1;
+    int16_t x = 0, y = 0;
+};
+
+#endif // TEST_RAM_PANEL_BUS_H
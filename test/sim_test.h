@@ -0,0 +1,113 @@
+#ifndef TEST_SIM_TEST_H
+#define TEST_SIM_TEST_H
+
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "ft_log.h"
+#include "sim.h"
+
+// Shared by the suites that run firmware code in the desktop simulator
+// (host/sim.h). Each suite is its own program, so it powers on once and
+// runs setup()/loop() in virtual time like host/sim_main.cpp, without the
+// stand-in server or the restart at deep sleep:
+//
+//   SimTest::powerOn(SimTest::LONDON_NOON);
+//   setup();
+//   TEST_ASSERT_TRUE(SimTest::runUntil(600)); // false: deep sleep came first
+
+void setup();
+void loop();
+
+namespace SimTest
+{
+
+// 2025-07-01 12:00 UTC, 13:00 in London (BST)
+static const int64_t LONDON_NOON = 1751371200;
+
+static const char FLIGHT_BODY[] =
+    "{\"flightDataAvailable\":true,\"callsign\":\"IBB8121\",\"originAirportIata\":\"TFN\","
+    "\"destinationAirportIata\":\"SPC\",\"aircraftCode\":\"AT76\",\"registration\":\"EC-MJI\",\"altitude\":9500}";
+static const char WEATHER_BODY[] = "{\"current\":{\"time\":\"2025-07-01T12:00\",\"temperature_2m\":23.4,"
+                                   "\"relative_humidity_2m\":61}}";
+
+// Same replies every time: /v1/forecast gets the weather, anything else the flight
+inline const char *serve(const char *host, const char *path)
+{
+    (void)host;
+    return strncmp(path, "/v1/forecast", 12) == 0 ? WEATHER_BODY : FLIGHT_BODY;
+}
+
+inline void drainLog()
+{
+    Log::drain();
+}
+
+// Everything logged since Log::begin(captureLog), as one string (the
+// first LOG_CAPTURE_SIZE - 1 bytes of it)
+static const size_t LOG_CAPTURE_SIZE = 65536;
+
+inline char *capturedLog()
+{
+    static char text[LOG_CAPTURE_SIZE];
+    return text;
+}
+
+inline void captureLog(const char *data, size_t size)
+{
+    static size_t used;
+    if (size > LOG_CAPTURE_SIZE - 1 - used)
+    {
+        size = LOG_CAPTURE_SIZE - 1 - used;
+    }
+    memcpy(capturedLog() + used, data, size);
+    used += size;
+    capturedLog()[used] = '\0';
+}
+
+inline jmp_buf &sleepJump()
+{
+    static jmp_buf jump;
+    return jump;
+}
+
+inline void leaveAtDeepSleep()
+{
+    longjmp(sleepJump(), 1);
+}
+
+// Power-on at `startUtc` with saved credentials, replies from serve(), no
+// frames on disk and NVS in a fresh directory
+inline void powerOn(int64_t startUtc)
+{
+    static char nvs[] = "/tmp/ft-test-nvs-XXXXXX";
+    SimOptions &o = Sim::options;
+    o.startUtc = startUtc;
+    o.framesDir = nullptr;
+    o.nvsDir = mkdtemp(nvs);
+    o.respond = serve;
+    o.onDeepSleep = leaveAtDeepSleep;
+    Sim::boot(0, -startUtc * 1000000, false);
+    Sim::onIdle(drainLog);
+}
+
+// loop() until `seconds` after power-on. False if the firmware went into
+// deep sleep first; it can't go on from there in the same process.
+inline bool runUntil(uint32_t seconds)
+{
+    if (setjmp(sleepJump()))
+    {
+        return false;
+    }
+    while (Sim::runUs() < (uint64_t)seconds * 1000000)
+    {
+        loop();
+    }
+    Sim::runIdle();
+    return true;
+}
+
+} // namespace SimTest
+
+#endif // TEST_SIM_TEST_H
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "../../bench/payloads.h"
+#include "flight_data_manager.h"
+#include "json_arena.h"
+#include "weather_manager.h"
+
+// The bench's response bodies, through the managers' own filters: each one
+// must parse and carry the values the firmware reads, or the json/* and
+// record/* figures would be timing an error path
+
+typedef void (*FilterBuilder)(JsonDocument &filter);
+
+static JsonDocument doc(JsonArena::allocator());
+
+static void parse(FilterBuilder buildFilter, const char *payload)
+{
+    JsonArena::reset();
+    JsonDocument filter(JsonArena::allocator());
+    buildFilter(filter);
+    doc.clear();
+    TEST_ASSERT_TRUE(deserializeJson(doc, payload, DeserializationOption::Filter(filter)) == DeserializationError::Ok);
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_flight_payload_fills_the_record()
+{
+    uint32_t overflows = JsonArena::stats().overflows;
+    parse(FlightDataManager::buildFilter, FLIGHT_PAYLOAD);
+    TEST_ASSERT_EQUAL_UINT32(overflows, JsonArena::stats().overflows);
+    FlightRecord r;
+    FlightDataManager::parseRecord(doc, r);
+    TEST_ASSERT_TRUE(r.available);
+    TEST_ASSERT_EQUAL_STRING("IBB8121", r.callsign);
+    TEST_ASSERT_EQUAL_STRING("TFN", r.origin);
+    TEST_ASSERT_EQUAL_STRING("SPC", r.destination);
+    TEST_ASSERT_EQUAL_STRING("AT76", r.aircraft);
+    // The extra fields are in the body to be skipped, not kept
+    TEST_ASSERT_FALSE(doc["squawk"].is<const char *>());
+    TEST_ASSERT_FALSE(doc["latitude"].is<float>());
+
+    char message[64];
+    snprintf(message, sizeof(message), "flight: %u byte body, %u arena bytes", (unsigned)strlen(FLIGHT_PAYLOAD),
+             (unsigned)JsonArena::stats().used);
+    TEST_MESSAGE(message);
+}
+
+void test_no_flight_payload_reads_as_no_flight()
+{
+    parse(FlightDataManager::buildFilter, NO_FLIGHT_PAYLOAD);
+    FlightRecord r;
+    FlightDataManager::parseRecord(doc, r);
+    TEST_ASSERT_FALSE(r.available);
+    TEST_ASSERT_EQUAL_STRING("?", r.callsign);
+}
+
+void test_weather_payload_keeps_only_the_current_values()
+{
+    uint32_t overflows = JsonArena::stats().overflows;
+    parse(WeatherManager::buildFilter, WEATHER_PAYLOAD);
+    TEST_ASSERT_EQUAL_UINT32(overflows, JsonArena::stats().overflows);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 23.4f, doc["current"]["temperature_2m"].as<float>());
+    TEST_ASSERT_EQUAL_INT(61, doc["current"]["relative_humidity_2m"].as<int>());
+    TEST_ASSERT_FALSE(doc["latitude"].is<float>());
+    TEST_ASSERT_FALSE(doc["current"]["interval"].is<int>());
+    TEST_ASSERT_FALSE(doc["current_units"]["time"].is<const char *>());
+
+    char message[64];
+    snprintf(message, sizeof(message), "weather: %u byte body, %u arena bytes", (unsigned)strlen(WEATHER_PAYLOAD),
+             (unsigned)JsonArena::stats().used);
+    TEST_MESSAGE(message);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_flight_payload_fills_the_record);
+    RUN_TEST(test_no_flight_payload_reads_as_no_flight);
+    RUN_TEST(test_weather_payload_keeps_only_the_current_values);
+    return UNITY_END();
+}
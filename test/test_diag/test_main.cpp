@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include "../sim_test.h"
+#include "WebServer.h"
+#include "cpu_governor.h"
+#include "diag_server.h"
+#include "fetch_metrics.h"
+#include "profiler.h"
+#include "telemetry.h"
+#include "time_sync.h"
+
+// /diag after an hour of fetching: every section present, in order, each
+// sent whole, and no truncation warning in the log
+
+// Copy of the page: the server's buffer is reused by the next request
+static char page[WebServer::PAGE_SIZE + 1];
+static size_t pageLength;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static size_t countLines(const char *from, const char *to)
+{
+    size_t lines = 0;
+    for (const char *p = from; p < to; p++)
+    {
+        lines += *p == '\n';
+    }
+    return lines;
+}
+
+void test_served_page_has_every_section_in_order()
+{
+    Log::begin(SimTest::captureLog);
+    SimTest::powerOn(SimTest::LONDON_NOON);
+    setup();
+    TEST_ASSERT_TRUE(SimTest::runUntil(3630));
+
+    const char *body;
+    TEST_ASSERT_EQUAL(200, WebServer::get("/diag", &body, &pageLength));
+    TEST_ASSERT_LESS_THAN(sizeof(page), pageLength);
+    memcpy(page, body, pageLength);
+    page[pageLength] = '\0';
+    TEST_ASSERT_EQUAL('\n', page[pageLength - 1]);
+
+    static const char *const headings[] = {"reset reason: ", "uptime,free,largest,min", "cpu now ", "time: synced",
+                                           "fetch flight: ", "fetch weather: "};
+    const char *at = page;
+    for (const char *heading : headings)
+    {
+        const char *found = strstr(at, heading);
+        TEST_ASSERT_NOT_NULL_MESSAGE(found, heading);
+        at = found;
+    }
+
+    // A full hour of telemetry rows between the CSV header and the CPU lines
+    const char *csv = strstr(page, "uptime,free,largest,min");
+    const char *cpu = strstr(page, "cpu ");
+    TEST_ASSERT_EQUAL(Telemetry::CAPACITY + 1, countLines(csv, cpu));
+
+    TEST_ASSERT_NULL_MESSAGE(strstr(SimTest::capturedLog(), "truncated"), "a /diag section overflowed the report buffer");
+
+    char message[96];
+    snprintf(message, sizeof(message), "/diag: %u bytes (report buffer %u bytes per section)", (unsigned)pageLength,
+             (unsigned)DiagServer::REPORT_SIZE);
+    TEST_MESSAGE(message);
+}
+
+void test_page_is_the_reports_back_to_back()
+{
+    // What the single-buffer page was, with a buffer big enough for all of it
+    static char joined[WebServer::PAGE_SIZE];
+    size_t len = Telemetry::formatReport(joined, sizeof(joined));
+    len += CpuGovernor::formatReport(joined + len, sizeof(joined) - len);
+    len += TimeSync::formatReport(joined + len, sizeof(joined) - len);
+    len += FetchMetrics::formatReport(joined + len, sizeof(joined) - len);
+    len += Profiler::formatReport(joined + len, sizeof(joined) - len);
+    TEST_ASSERT_EQUAL(len, pageLength);
+    TEST_ASSERT_EQUAL(0, memcmp(joined, page, len));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_served_page_has_every_section_in_order);
+    RUN_TEST(test_page_is_the_reports_back_to_back);
+    return UNITY_END();
+}
@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+#include "../sim_test.h"
+#include "flight_data_manager.h"
+
+// How often loop() redraws the clock and WiFi bars over an hour of day
+// fetches, read from its hourly "Last 3600 s: N renders, M wakes" line
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_an_hour_of_unchanged_flights_renders_once_a_minute()
+{
+    Log::begin(SimTest::captureLog);
+    SimTest::powerOn(SimTest::LONDON_NOON);
+    setup();
+    TEST_ASSERT_TRUE(SimTest::runUntil(3630));
+
+    const char *line = strstr(SimTest::capturedLog(), "Last 3600 s: ");
+    TEST_ASSERT_NOT_NULL_MESSAGE(line, "no hourly loop report");
+    unsigned long renders = 0;
+    unsigned long wakes = 0;
+    TEST_ASSERT_EQUAL(2, sscanf(line, "Last 3600 s: %lu renders, %lu wakes", &renders, &wakes));
+
+    // The same flight all hour: one applied snapshot, the rest suppressed
+    const SnapshotGate &gate = FlightDataManager::snapshots();
+    TEST_ASSERT_EQUAL_UINT32(1, gate.appliedCount());
+    TEST_ASSERT_GREATER_OR_EQUAL(170, gate.suppressedCount());
+
+    // A minute tick each, plus the boot screen and the first flight; none
+    // for the suppressed fetches
+    TEST_ASSERT_LESS_OR_EQUAL(65, renders);
+    TEST_ASSERT_GREATER_OR_EQUAL(60, renders);
+
+    char message[96];
+    snprintf(message, sizeof(message), "per hour: %lu renders, %lu wakes, %u fetches suppressed", renders, wakes,
+             (unsigned)gate.suppressedCount());
+    TEST_MESSAGE(message);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_an_hour_of_unchanged_flights_renders_once_a_minute);
+    return UNITY_END();
+}
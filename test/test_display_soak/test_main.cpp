@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include "../sim_test.h"
+#include "fixed_string.h"
+#include "flight_data_manager.h"
+#include "heap_guard.h"
+#include "weather_manager.h"
+
+// The display state without Arduino String: FixedString itself, then a day
+// in the simulator with the flight changing every few polls and the
+// weather on every fetch, so the display really redraws. HeapGuard counts
+// every allocation loop() makes outside the fetches' Allow scopes.
+
+// 2025-07-01 07:00 in London (BST)
+static const int64_t LONDON_MORNING = SimTest::LONDON_NOON - 6 * 3600;
+
+// Short, long and overlong fields, and one with nothing overhead
+static const char *const FLIGHTS[] = {
+    "{\"flightDataAvailable\":true,\"callsign\":\"IBB8121\",\"originAirportIata\":\"TFN\","
+    "\"destinationAirportIata\":\"SPC\",\"aircraftCode\":\"AT76\"}",
+    "{\"flightDataAvailable\":true,\"callsign\":\"BAW2LC\",\"originAirportIata\":\"LHR\","
+    "\"destinationAirportIata\":\"MAD\",\"aircraftCode\":\"A320\"}",
+    "{\"flightDataAvailable\":true,\"callsign\":\"OVERLONGCALLSIGN\",\"originAirportIata\":\"LONGCODE\","
+    "\"destinationAirportIata\":null,\"aircraftCode\":\"B738-MAX-LONG\"}",
+    "{\"flightDataAvailable\":false}",
+};
+static const unsigned POLLS_PER_FLIGHT = 9;
+
+static unsigned flightPolls;
+static unsigned weatherPolls;
+
+static const char *serve(const char *host, const char *path)
+{
+    (void)host;
+    if (strncmp(path, "/v1/forecast", 12) == 0)
+    {
+        static char weather[128];
+        weatherPolls++;
+        snprintf(weather, sizeof(weather),
+                 "{\"current\":{\"temperature_2m\":%u.%u,\"relative_humidity_2m\":%u}}", 15 + weatherPolls % 12,
+                 weatherPolls % 10, 40 + weatherPolls % 50);
+        return weather;
+    }
+    return FLIGHTS[flightPolls++ / POLLS_PER_FLIGHT % (sizeof(FLIGHTS) / sizeof(FLIGHTS[0]))];
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_fixed_string_truncates_instead_of_growing()
+{
+    FixedString<6> s("ab");
+    s += "cd";
+    s += 'e';
+    TEST_ASSERT_EQUAL_STRING("abcde", s.c_str());
+    TEST_ASSERT_FALSE(s.truncated());
+    s += 'f';
+    s += "gh";
+    TEST_ASSERT_EQUAL_STRING("abcde", s.c_str());
+    TEST_ASSERT_EQUAL(5, s.length());
+    TEST_ASSERT_TRUE(s.truncated());
+
+    s = "xy";
+    TEST_ASSERT_FALSE(s.truncated());
+    TEST_ASSERT_TRUE(s == "xy");
+    TEST_ASSERT_TRUE(s != FixedString<16>("xyz"));
+    TEST_ASSERT_TRUE(FixedString<4>() == nullptr);
+
+    snprintf(s.data(), 6, "%d", 12345678);
+    s.resync();
+    TEST_ASSERT_EQUAL(5, s.length());
+}
+
+void test_a_day_of_changing_flights_and_weather_stays_off_the_heap()
+{
+    SimTest::powerOn(LONDON_MORNING);
+    Sim::options.respond = serve;
+    setup();
+    uint32_t violations = HeapGuard::violations();
+    TEST_ASSERT_FALSE(SimTest::runUntil(16 * 3600));
+
+    const SnapshotGate &flights = FlightDataManager::snapshots();
+    const SnapshotGate &weather = WeatherManager::snapshots();
+    // The rotation really reached the screen, truncated fields included
+    TEST_ASSERT_GREATER_OR_EQUAL(flightPolls / POLLS_PER_FLIGHT - 1, flights.appliedCount());
+    TEST_ASSERT_GREATER_THAN(50, weather.appliedCount());
+    TEST_ASSERT_EQUAL_UINT32(violations, HeapGuard::violations());
+
+    char message[160];
+    snprintf(message, sizeof(message),
+             "07:00 to deep sleep: %u flight polls, %u flight and %u weather redraws, %u loop allocations",
+             flightPolls, (unsigned)flights.appliedCount(), (unsigned)weather.appliedCount(),
+             (unsigned)(HeapGuard::violations() - violations));
+    TEST_MESSAGE(message);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fixed_string_truncates_instead_of_growing);
+    RUN_TEST(test_a_day_of_changing_flights_and_weather_stays_off_the_heap);
+    return UNITY_END();
+}
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <unity.h>
+#include "../sim_test.h"
+#include "ft_wifi_manager.h"
+
+// The cached fast path (channel, BSSID, static lease) and its fallback, on
+// the firmware in the simulator: the AP moving makes the cache miss, and
+// the full connect after it, or after MAX_FAST_RECONNECTS fast ones, must
+// scan and take a DHCP lease
+
+static uint32_t runS = 0;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// Drop the link and give WiFiLink a minute (grace, backoff, connect)
+static void reconnect()
+{
+    FtWiFiManager::disconnect();
+    runS += 60;
+    TEST_ASSERT_TRUE(SimTest::runUntil(runS));
+    TEST_ASSERT_TRUE(FtWiFiManager::isConnected());
+}
+
+void test_first_connect_scans_and_takes_a_lease()
+{
+    SimTest::powerOn(SimTest::LONDON_NOON);
+    setup();
+    runS = 60;
+    TEST_ASSERT_TRUE(SimTest::runUntil(runS));
+    TEST_ASSERT_TRUE(FtWiFiManager::isConnected());
+    TEST_ASSERT_EQUAL_UINT32(1, Sim::radio.scans);
+    TEST_ASSERT_EQUAL_UINT32(1, Sim::radio.dhcpLeases);
+    TEST_ASSERT_EQUAL_UINT32(1, FtWiFiManager::connectStats().fullConnects);
+}
+
+void test_reconnect_takes_the_fast_path()
+{
+    reconnect();
+    const FtWiFiManager::ConnectStats &stats = FtWiFiManager::connectStats();
+    TEST_ASSERT_TRUE(stats.lastWasFast);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.fastHits);
+    TEST_ASSERT_EQUAL_UINT32(1, Sim::radio.directJoins);
+    TEST_ASSERT_EQUAL_UINT32(1, Sim::radio.dhcpLeases);
+    TEST_ASSERT_EQUAL_UINT32(Sim::options.fastConnectMs, stats.lastConnectMs);
+}
+
+void test_miss_falls_back_to_a_full_scan()
+{
+    Sim::options.apChannel = 11;
+    reconnect();
+    const FtWiFiManager::ConnectStats &stats = FtWiFiManager::connectStats();
+    TEST_ASSERT_FALSE(stats.lastWasFast);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.fastMisses);
+    TEST_ASSERT_EQUAL_UINT32(1, Sim::radio.missedJoins);
+    // The fallback went without the stale channel and BSSID, and with DHCP
+    TEST_ASSERT_EQUAL_UINT32(2, Sim::radio.scans);
+    TEST_ASSERT_EQUAL_UINT32(2, Sim::radio.dhcpLeases);
+    TEST_ASSERT_EQUAL_INT32(11, WiFi.channel());
+
+    char message[64];
+    snprintf(message, sizeof(message), "fast miss then full connect: %lu ms",
+             (unsigned long)(FtWiFiManager::FAST_CONNECT_TIMEOUT + stats.lastConnectMs));
+    TEST_MESSAGE(message);
+
+    // Cached again from the full connect
+    reconnect();
+    TEST_ASSERT_TRUE(FtWiFiManager::connectStats().lastWasFast);
+}
+
+void test_run_of_fast_connects_ends_in_a_lease_renewal()
+{
+    const FtWiFiManager::ConnectStats &stats = FtWiFiManager::connectStats();
+    uint32_t fullBefore = stats.fullConnects;
+    uint32_t leasesBefore = Sim::radio.dhcpLeases;
+    uint32_t fast = stats.fastSinceFull;
+    while (fast < FtWiFiManager::MAX_FAST_RECONNECTS)
+    {
+        reconnect();
+        TEST_ASSERT_TRUE(stats.lastWasFast);
+        fast++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(leasesBefore, Sim::radio.dhcpLeases);
+
+    reconnect();
+    TEST_ASSERT_FALSE(stats.lastWasFast);
+    TEST_ASSERT_EQUAL_UINT32(fullBefore + 1, stats.fullConnects);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.fastSinceFull);
+    TEST_ASSERT_EQUAL_UINT32(leasesBefore + 1, Sim::radio.dhcpLeases);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_first_connect_scans_and_takes_a_lease);
+    RUN_TEST(test_reconnect_takes_the_fast_path);
+    RUN_TEST(test_miss_falls_back_to_a_full_scan);
+    RUN_TEST(test_run_of_fast_connects_ends_in_a_lease_renewal);
+    return UNITY_END();
+}
@@ -0,0 +1,98 @@
+#include <string.h>
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "flight_data_manager.h"
+#include "json_arena.h"
+
+// FlightDataManager::parseRecord(): one pass from the API response to the
+// record the display draws, through the same filter fetchData() uses
+
+static JsonDocument doc(JsonArena::allocator());
+
+static FlightRecord parse(const char *json)
+{
+    JsonArena::reset();
+    JsonDocument filter(JsonArena::allocator());
+    FlightDataManager::buildFilter(filter);
+    doc.clear();
+    TEST_ASSERT_TRUE(deserializeJson(doc, json, DeserializationOption::Filter(filter)) == DeserializationError::Ok);
+    FlightRecord record;
+    memset(&record, 'x', sizeof(record));
+    FlightDataManager::parseRecord(doc, record);
+    return record;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_full_response()
+{
+    FlightRecord r = parse("{\"flightDataAvailable\":true,\"callsign\":\"IBB8121\",\"flightNumber\":\"NT8121\","
+                           "\"originAirportIata\":\"TFN\",\"destinationAirportIata\":\"SPC\","
+                           "\"aircraftCode\":\"AT76\",\"registration\":\"EC-MJI\",\"altitude\":9500}");
+    TEST_ASSERT_TRUE(r.available);
+    TEST_ASSERT_EQUAL_STRING("IBB8121", r.callsign);
+    TEST_ASSERT_EQUAL_STRING("TFN", r.origin);
+    TEST_ASSERT_EQUAL_STRING("SPC", r.destination);
+    TEST_ASSERT_EQUAL_STRING("AT76", r.aircraft);
+}
+
+void test_missing_empty_and_null_fields_read_as_question_marks()
+{
+    FlightRecord r = parse("{\"callsign\":\"BAW2LC\",\"originAirportIata\":\"\","
+                           "\"destinationAirportIata\":null,\"aircraftCode\":\"null\"}");
+    TEST_ASSERT_TRUE(r.available);
+    TEST_ASSERT_EQUAL_STRING("?", r.origin);
+    TEST_ASSERT_EQUAL_STRING("?", r.destination);
+    TEST_ASSERT_EQUAL_STRING("?", r.aircraft);
+}
+
+void test_no_flight()
+{
+    FlightRecord r = parse("{\"flightDataAvailable\":false}");
+    TEST_ASSERT_FALSE(r.available);
+    TEST_ASSERT_EQUAL_STRING("?", r.callsign);
+    TEST_ASSERT_EQUAL_STRING("?", r.aircraft);
+
+    r = parse("{\"flightDataAvailable\":true,\"callsign\":null,\"aircraftCode\":\"A320\"}");
+    TEST_ASSERT_FALSE(r.available);
+    TEST_ASSERT_EQUAL_STRING("A320", r.aircraft);
+
+    r = parse("[]");
+    TEST_ASSERT_FALSE(r.available);
+}
+
+void test_long_fields_are_cut_to_the_record()
+{
+    FlightRecord r = parse("{\"callsign\":\"OVERLONGCALLSIGN\",\"originAirportIata\":\"LONGCODE\","
+                           "\"aircraftCode\":\"B738-MAX-LONG\"}");
+    TEST_ASSERT_TRUE(r.available);
+    TEST_ASSERT_EQUAL_STRING("OVERLONG", r.callsign);
+    TEST_ASSERT_EQUAL_STRING("LONG", r.origin);
+    TEST_ASSERT_EQUAL_STRING("B738-MAX", r.aircraft);
+    TEST_ASSERT_EQUAL(FlightRecord::CALLSIGN_SIZE - 1, strlen(r.callsign));
+}
+
+void test_fields_outside_the_filter_are_dropped()
+{
+    parse("{\"callsign\":\"IBB8121\",\"registration\":\"EC-MJI\",\"latitude\":28.5,\"track\":287}");
+    TEST_ASSERT_TRUE(doc["callsign"].is<const char *>());
+    TEST_ASSERT_TRUE(doc["registration"].isNull());
+    TEST_ASSERT_TRUE(doc["latitude"].isNull());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_full_response);
+    RUN_TEST(test_missing_empty_and_null_fields_read_as_question_marks);
+    RUN_TEST(test_no_flight);
+    RUN_TEST(test_long_fields_are_cut_to_the_record);
+    RUN_TEST(test_fields_outside_the_filter_are_dropped);
+    return UNITY_END();
+}
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+#include "../sim_test.h"
+#include "ft_log.h"
+#include "heap_guard.h"
+#include "power_scheduler.h"
+
+// No heap after boot, over a day in the simulator: from 07:00 London to
+// an hour into the night, light sleeping with a flight on screen, loop()
+// allocates only inside Allow scopes (the network stacks). Built with
+// FT_HEAP_GUARD in [env:native].
+
+// 2025-07-01 07:00 in London (BST)
+static const int64_t LONDON_MORNING = SimTest::LONDON_NOON - 6 * 3600;
+
+// Keeps the control allocation from being optimised away
+static void *volatile sink;
+
+static char logged[512];
+
+static void capture(const char *text, size_t len)
+{
+    size_t used = strlen(logged);
+    size_t n = len < sizeof(logged) - 1 - used ? len : sizeof(logged) - 1 - used;
+    memcpy(logged + used, text, n);
+    logged[used + n] = '\0';
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_a_day_of_loop_passes_stays_off_the_heap()
+{
+    SimTest::powerOn(LONDON_MORNING);
+    setup();
+    TEST_ASSERT_TRUE(HeapGuard::bootComplete());
+    // To 23:00; the flight keeps the panel lit, so the night light sleeps
+    TEST_ASSERT_TRUE(SimTest::runUntil(16 * 3600));
+    TEST_ASSERT_GREATER_THAN(0, PowerScheduler::lightSleeps());
+    HeapGuard::report();
+
+    for (uint8_t i = 0; i < HeapGuard::siteCount(); i++)
+    {
+        const HeapGuard::Site &s = HeapGuard::site(i);
+        char message[96];
+        snprintf(message, sizeof(message), "%u allocations from %p [%s]", (unsigned)s.count, s.caller, s.tag);
+        TEST_MESSAGE(message);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, HeapGuard::violations());
+    // The fetches did run, and their allocations were let through
+    TEST_ASSERT_GREATER_THAN(0, HeapGuard::allowedAllocations());
+
+    char message[96];
+    snprintf(message, sizeof(message), "07:00 to 23:00: 0 violations, %u allowed allocations, %u light sleeps",
+             (unsigned)HeapGuard::allowedAllocations(), (unsigned)PowerScheduler::lightSleeps());
+    TEST_MESSAGE(message);
+}
+
+void test_an_unscoped_allocation_is_caught()
+{
+    uint32_t before = HeapGuard::violations();
+    sink = malloc(32);
+    free(sink);
+    {
+        HeapGuard::Allow allow("test");
+        sink = malloc(32);
+        free(sink);
+    }
+    TEST_ASSERT_EQUAL_UINT32(before + 1, HeapGuard::violations());
+    TEST_ASSERT_EQUAL_STRING("untagged", HeapGuard::site(HeapGuard::siteCount() - 1).tag);
+
+    // The report is queued on the log ring, not written out while it waits
+    Log::begin(capture);
+    Log::flush();
+    logged[0] = '\0';
+    uint8_t pending = Log::pending();
+    HeapGuard::report();
+    TEST_ASSERT_EQUAL(pending + 2, Log::pending());
+    TEST_ASSERT_EQUAL_STRING("", logged);
+    Log::flush();
+    TEST_ASSERT_NOT_NULL(strstr(logged, "HeapGuard: new site 0x"));
+    TEST_ASSERT_NOT_NULL(strstr(logged, "[untagged], 32 B"));
+    TEST_ASSERT_NOT_NULL(strstr(logged, "violations at"));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_a_day_of_loop_passes_stays_off_the_heap);
+    RUN_TEST(test_an_unscoped_allocation_is_caught);
+    return UNITY_END();
+}
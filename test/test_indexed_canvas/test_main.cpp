@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <unity.h>
+#include "../ram_panel_bus.h"
+#include "indexed_canvas.h"
+
+// IndexedCanvas flushed into a model of the panel's RAM: the same picture
+// as drawing straight to the panel, only dirty rows sent, accent swaps
+// without redrawing, and the memory and flush time against RGB565
+
+static const int16_t W = RamPanelBus::WIDTH;
+static const int16_t H = RamPanelBus::HEIGHT;
+
+static RamPanelBus canvasRam;
+static RamPanelBus directRam;
+static TracePanelBus trace(&canvasRam);
+static St77xxPanel panel(trace, W, H, 0, 0);
+static IndexedCanvas canvas(W, H);
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void drawScene(Adafruit_GFX &gfx)
+{
+    gfx.fillScreen(ST77XX_BLACK);
+    gfx.drawRect(0, 0, W, H, ST77XX_GREEN);
+    gfx.fillRect(2, 2, W - 4, 12, ST77XX_BLUE);
+    gfx.setTextColor(ST77XX_WHITE);
+    gfx.setTextSize(1);
+    gfx.setCursor(4, 4);
+    gfx.print("13:07");
+    gfx.setTextColor(ST77XX_GREEN);
+    gfx.setTextSize(2);
+    gfx.setCursor(4, 30);
+    gfx.print("TFN-SPC");
+    gfx.drawFastHLine(2, 80, W - 4, ST77XX_YELLOW);
+    gfx.drawLine(90, 94, 110, 114, ST77XX_RED);
+}
+
+void test_flushed_canvas_matches_drawing_on_the_panel()
+{
+    drawScene(canvas);
+    uint32_t sent = canvas.flush(panel);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)W * H, sent);
+    TEST_ASSERT_FALSE(canvas.isDirty());
+
+    TracePanelBus directTrace(&directRam);
+    St77xxPanel direct(directTrace, W, H, 0, 0);
+    direct.beginFrame();
+    drawScene(direct);
+    direct.endFrame();
+    TEST_ASSERT_EQUAL_MEMORY(directRam.ram, canvasRam.ram, sizeof(canvasRam.ram));
+}
+
+void test_unchanged_redraw_sends_nothing()
+{
+    // The periodic border, separator and text redraws: the same pixels again
+    canvas.drawRect(0, 0, W, H, ST77XX_GREEN);
+    canvas.drawFastHLine(2, 80, W - 4, ST77XX_YELLOW);
+    canvas.setTextColor(ST77XX_GREEN);
+    canvas.setTextSize(2);
+    canvas.setCursor(4, 30);
+    canvas.print("TFN-SPC");
+    TEST_ASSERT_FALSE(canvas.isDirty());
+    TEST_ASSERT_EQUAL_UINT32(0, canvas.flush(panel));
+}
+
+void test_small_change_sends_only_its_rows()
+{
+    canvas.fillRect(4, 60, 10, 3, ST77XX_WHITE);
+    uint32_t sent = canvas.flush(panel);
+    TEST_ASSERT_GREATER_OR_EQUAL(30, sent);
+    TEST_ASSERT_LESS_OR_EQUAL(3 * W, sent);
+    TEST_ASSERT_EQUAL_HEX16(ST77XX_WHITE, canvasRam.ram[61][8]);
+}
+
+void test_accent_swap_recolours_without_drawing()
+{
+    // Green was the accent when the border and the route were drawn
+    canvas.setAccent(ST77XX_YELLOW);
+    TEST_ASSERT_TRUE(canvas.isDirty());
+    canvas.flush(panel);
+    TEST_ASSERT_EQUAL_HEX16(ST77XX_YELLOW, canvasRam.ram[0][0]);
+    TEST_ASSERT_EQUAL_HEX16(ST77XX_YELLOW, canvasRam.ram[H - 1][W / 2]);
+    TEST_ASSERT_EQUAL_HEX16(ST77XX_BLUE, canvasRam.ram[5][W / 2]);
+
+    canvas.setAccent(ST77XX_GREEN);
+    canvas.flush(panel);
+    TEST_ASSERT_EQUAL_HEX16(ST77XX_GREEN, canvasRam.ram[0][0]);
+    // The separator was drawn yellow, not in the accent, so it stays
+    TEST_ASSERT_EQUAL_HEX16(ST77XX_YELLOW, canvasRam.ram[80][W / 2]);
+}
+
+void test_memory_and_full_flush_time()
+{
+    TEST_ASSERT_EQUAL(8192, IndexedCanvas::bufferBytes(W, H));
+
+    TracePanelBus sink;
+    St77xxPanel sinkPanel(sink, W, H, 0, 0);
+    const int ROUNDS = 1000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ROUNDS; i++)
+    {
+        canvas.markAllDirty();
+        canvas.flush(sinkPanel);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double us = std::chrono::duration<double, std::micro>(elapsed).count() / ROUNDS;
+
+    char message[128];
+    snprintf(message, sizeof(message), "canvas %u bytes (RGB565: %u), full flush %.1f us on the host",
+             (unsigned)IndexedCanvas::bufferBytes(W, H), (unsigned)(W * H * sizeof(uint16_t)), us);
+    TEST_MESSAGE(message);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_flushed_canvas_matches_drawing_on_the_panel);
+    RUN_TEST(test_unchanged_redraw_sends_nothing);
+    RUN_TEST(test_small_change_sends_only_its_rows);
+    RUN_TEST(test_accent_swap_recolours_without_drawing);
+    RUN_TEST(test_memory_and_full_flush_time);
+    return UNITY_END();
+}
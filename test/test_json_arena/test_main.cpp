@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+#include "flight_data_manager.h"
+#include "heap_guard.h"
+#include "json_arena.h"
+#include "weather_manager.h"
+
+// The fetchers' bump arena: block reuse at the top, overflow instead of
+// growth, room for a filter and its document, a parse loop that stays
+// flat, and the heap traffic it saves over the default allocator
+
+static ArduinoJson::Allocator *arena;
+
+static const char FLIGHT[] =
+    "{\"flightDataAvailable\":true,\"callsign\":\"IBB8121\",\"flightNumber\":\"NT8121\","
+    "\"originAirportIata\":\"TFN\",\"destinationAirportIata\":\"SPC\",\"aircraftCode\":\"AT76\","
+    "\"registration\":\"EC-MJI\",\"latitude\":28.5412,\"longitude\":-17.6931,\"altitude\":9500,"
+    "\"groundSpeed\":245,\"track\":287}";
+
+void setUp()
+{
+    arena = JsonArena::allocator();
+    JsonArena::reset();
+}
+
+void tearDown()
+{
+}
+
+void test_reset_empties_the_arena()
+{
+    uint32_t resets = JsonArena::stats().resets;
+    TEST_ASSERT_NOT_NULL(arena->allocate(100));
+    TEST_ASSERT_GREATER_THAN(100, JsonArena::stats().used);
+    JsonArena::reset();
+    TEST_ASSERT_EQUAL(0, JsonArena::stats().used);
+    TEST_ASSERT_EQUAL_UINT32(resets + 1, JsonArena::stats().resets);
+}
+
+void test_blocks_are_aligned_and_disjoint()
+{
+    uint8_t *a = (uint8_t *)arena->allocate(3);
+    uint8_t *b = (uint8_t *)arena->allocate(17);
+    TEST_ASSERT_NOT_NULL(a);
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)a % 8);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)b % 8);
+    TEST_ASSERT_TRUE(b >= a + 3);
+    memset(a, 0xAA, 3);
+    memset(b, 0x55, 17);
+    TEST_ASSERT_EQUAL_HEX8(0xAA, a[2]);
+}
+
+void test_newest_block_frees_and_grows_in_place()
+{
+    void *a = arena->allocate(64);
+    size_t afterA = JsonArena::stats().used;
+    void *b = arena->allocate(64);
+    TEST_ASSERT_EQUAL_PTR(b, arena->reallocate(b, 512));
+    TEST_ASSERT_EQUAL_PTR(b, arena->reallocate(b, 32));
+    arena->deallocate(b);
+    TEST_ASSERT_EQUAL(afterA, JsonArena::stats().used);
+    // a is the newest again
+    TEST_ASSERT_EQUAL_PTR(a, arena->reallocate(a, 256));
+}
+
+void test_older_block_moves_to_grow_and_keeps_its_bytes()
+{
+    char *a = (char *)arena->allocate(8);
+    memcpy(a, "abcdefg", 8);
+    arena->allocate(8);
+    TEST_ASSERT_EQUAL_PTR(a, arena->reallocate(a, 4)); // shrinkToFit stays put
+    char *moved = (char *)arena->reallocate(a, 64);
+    TEST_ASSERT_NOT_NULL(moved);
+    TEST_ASSERT_TRUE(moved != a);
+    TEST_ASSERT_EQUAL_STRING("abcdefg", moved);
+    // Freeing an older block is a no-op until reset()
+    size_t used = JsonArena::stats().used;
+    arena->deallocate(a);
+    TEST_ASSERT_EQUAL(used, JsonArena::stats().used);
+}
+
+void test_overflow_fails_instead_of_growing()
+{
+    uint32_t overflows = JsonArena::stats().overflows;
+    void *big = arena->allocate(JsonArena::CAPACITY - 64);
+    TEST_ASSERT_NOT_NULL(big);
+    TEST_ASSERT_NULL(arena->allocate(128));
+    TEST_ASSERT_NULL(arena->reallocate(big, JsonArena::CAPACITY));
+    TEST_ASSERT_EQUAL_UINT32(overflows + 2, JsonArena::stats().overflows);
+    TEST_ASSERT_LESS_OR_EQUAL(JsonArena::CAPACITY, JsonArena::stats().highWater);
+
+    // A document that can't fit reports NoMemory rather than taking the heap
+    JsonArena::reset();
+    arena->allocate(JsonArena::CAPACITY - 64);
+    JsonDocument doc(arena);
+    TEST_ASSERT_TRUE(deserializeJson(doc, FLIGHT) == DeserializationError::NoMemory);
+}
+
+// As the fetchers parse: the filter and the document each take a pool
+static size_t filteredParse(void (*buildFilter)(JsonDocument &filter), const char *json)
+{
+    JsonArena::reset();
+    JsonDocument filter(arena);
+    buildFilter(filter);
+    JsonDocument doc(arena);
+    TEST_ASSERT_TRUE(deserializeJson(doc, json, DeserializationOption::Filter(filter)) == DeserializationError::Ok);
+    return JsonArena::stats().used;
+}
+
+void test_filter_and_document_fit_together()
+{
+    uint32_t overflows = JsonArena::stats().overflows;
+    size_t flight = filteredParse(FlightDataManager::buildFilter, FLIGHT);
+    size_t weather = filteredParse(WeatherManager::buildFilter,
+                                   "{\"current\":{\"temperature_2m\":23.4,\"relative_humidity_2m\":61}}");
+    TEST_ASSERT_EQUAL_UINT32(overflows, JsonArena::stats().overflows);
+    TEST_ASSERT_GREATER_OR_EQUAL(2 * JsonArena::POOL_BYTES, flight);
+
+    char message[96];
+    snprintf(message, sizeof(message), "filtered parse: flight %u, weather %u of %u bytes",
+             (unsigned)flight, (unsigned)weather, (unsigned)JsonArena::CAPACITY);
+    TEST_MESSAGE(message);
+}
+
+void test_parse_loop_stays_flat()
+{
+    size_t firstUsed = 0;
+    uint32_t overflows = JsonArena::stats().overflows;
+    for (int i = 0; i < 10000; i++)
+    {
+        JsonArena::reset();
+        JsonDocument doc(arena);
+        TEST_ASSERT_TRUE(deserializeJson(doc, FLIGHT) == DeserializationError::Ok);
+        TEST_ASSERT_EQUAL_STRING("IBB8121", doc["callsign"].as<const char *>());
+        if (i == 0)
+        {
+            firstUsed = JsonArena::stats().used;
+        }
+        TEST_ASSERT_EQUAL(firstUsed, JsonArena::stats().used);
+    }
+    TEST_ASSERT_EQUAL_UINT32(overflows, JsonArena::stats().overflows);
+
+    char message[80];
+    snprintf(message, sizeof(message), "flight document: %u of %u bytes per parse, 10000 parses",
+             (unsigned)firstUsed, (unsigned)JsonArena::CAPACITY);
+    TEST_MESSAGE(message);
+    JsonArena::report("test");
+}
+
+// The default allocator's traffic, for comparison: what reaches malloc
+class CountingAllocator : public ArduinoJson::Allocator
+{
+public:
+    size_t bytes = 0;
+
+    void *allocate(size_t size) override
+    {
+        bytes += size;
+        return malloc(size);
+    }
+    void deallocate(void *ptr) override { free(ptr); }
+    void *reallocate(void *ptr, size_t newSize) override
+    {
+        bytes += newSize;
+        return realloc(ptr, newSize);
+    }
+};
+
+// The fetch loop's parses once boot is over, as HeapGuard sees them: on
+// the heap every one allocates and frees, on the arena none does
+void test_soak_heap_against_arena()
+{
+    const int parses = 10000;
+    CountingAllocator heap;
+    HeapGuard::markBootComplete();
+
+    uint32_t before = HeapGuard::violations();
+    for (int i = 0; i < parses; i++)
+    {
+        JsonDocument filter(&heap);
+        FlightDataManager::buildFilter(filter);
+        JsonDocument doc(&heap);
+        TEST_ASSERT_TRUE(deserializeJson(doc, FLIGHT, DeserializationOption::Filter(filter)) == DeserializationError::Ok);
+    }
+    uint32_t heapAllocations = HeapGuard::violations() - before;
+
+    before = HeapGuard::violations();
+    size_t highWater = JsonArena::stats().highWater;
+    for (int i = 0; i < parses; i++)
+    {
+        filteredParse(FlightDataManager::buildFilter, FLIGHT);
+    }
+    uint32_t arenaAllocations = HeapGuard::violations() - before;
+
+    TEST_ASSERT_GREATER_OR_EQUAL(parses * 3, heapAllocations);
+    TEST_ASSERT_EQUAL_UINT32(0, arenaAllocations);
+    TEST_ASSERT_EQUAL(highWater, JsonArena::stats().highWater);
+
+    char message[160];
+    snprintf(message, sizeof(message),
+             "%d filtered flight parses: heap %u allocations, %u bytes (%u and %u per parse); arena 0, %u bytes static",
+             parses, (unsigned)heapAllocations, (unsigned)heap.bytes, (unsigned)(heapAllocations / parses),
+             (unsigned)(heap.bytes / parses), (unsigned)JsonArena::CAPACITY);
+    TEST_MESSAGE(message);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_reset_empties_the_arena);
+    RUN_TEST(test_blocks_are_aligned_and_disjoint);
+    RUN_TEST(test_newest_block_frees_and_grows_in_place);
+    RUN_TEST(test_older_block_moves_to_grow_and_keeps_its_bytes);
+    RUN_TEST(test_overflow_fails_instead_of_growing);
+    RUN_TEST(test_filter_and_document_fit_together);
+    RUN_TEST(test_parse_loop_stays_flat);
+    RUN_TEST(test_soak_heap_against_arena);
+    return UNITY_END();
+}
@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include "layout.h"
+
+// The one part of Layout the compiler can't check: FreeMonoBold12pt7b's
+// table is plain const data, so Layout::MONO copies its figures by hand.
+// A font update that changes them fails here instead of clipping fields.
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_mono_metrics_match_the_font()
+{
+    const GFXfont &font = FreeMonoBold12pt7b;
+    Layout::FontMetrics m = Layout::measure(font.glyph, font.first, Layout::MONO_CHARSET);
+
+    char message[96];
+    snprintf(message, sizeof(message), "FreeMonoBold12pt7b over MONO_CHARSET: advance %d, top %d, bottom %d",
+             m.advance, m.top, m.bottom);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL_MESSAGE(Layout::MONO.advance, m.advance, "Layout::MONO.advance");
+    TEST_ASSERT_EQUAL_MESSAGE(Layout::MONO.top, m.top, "Layout::MONO.top");
+    TEST_ASSERT_EQUAL_MESSAGE(Layout::MONO.bottom, m.bottom, "Layout::MONO.bottom");
+}
+
+void test_mono_ink_stays_inside_its_cells()
+{
+    TEST_ASSERT_TRUE(Layout::fontFits(FreeMonoBold12pt7b, Layout::MONO, Layout::MONO_CHARSET));
+}
+
+void test_charset_covers_what_the_mono_fields_show()
+{
+    // Temperature, humidity, aircraft type and flight number, plus the "?"
+    // a missing value shows as
+    const char *samples[] = {"-10.5C", "23.4C", "100%", "A20N", "B38M", "BAW123", "IBB8121", "?"};
+    for (const char *s : samples)
+    {
+        for (const char *c = s; *c; c++)
+        {
+            TEST_ASSERT_NOT_NULL_MESSAGE(strchr(Layout::MONO_CHARSET, *c), s);
+        }
+    }
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_mono_metrics_match_the_font);
+    RUN_TEST(test_mono_ink_stays_inside_its_cells);
+    RUN_TEST(test_charset_covers_what_the_mono_fields_show);
+    return UNITY_END();
+}
@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <unity.h>
+#include "ft_log.h"
+
+// The log ring on its own: a full ring drops and counts instead of
+// waiting, long lines are cut, levels above FT_LOG_LEVEL cost nothing,
+// several producers can share it, and what a loop pass pays to log
+
+static constexpr char TAG[] = "test";
+
+static char lastLine[Log::LINE_SIZE + 64];
+static uint32_t lines;
+static uint32_t droppedReported;
+
+static void capture(const char *text, size_t len)
+{
+    size_t n = len < sizeof(lastLine) - 1 ? len : sizeof(lastLine) - 1;
+    memcpy(lastLine, text, n);
+    lastLine[n] = '\0';
+    unsigned count;
+    if (sscanf(lastLine, "[log] %u lines dropped", &count) == 1)
+    {
+        droppedReported += count;
+        return;
+    }
+    lines++;
+}
+
+void setUp()
+{
+    Log::begin(capture);
+    Log::flush();
+    lines = 0;
+    droppedReported = 0;
+}
+
+void tearDown()
+{
+}
+
+void test_full_ring_drops_and_reports_the_gap()
+{
+    Log::Stats before = Log::stats();
+    for (int i = 0; i < Log::SLOTS + 10; i++)
+    {
+        FT_LOGI(TAG, "line %d", i);
+    }
+    Log::Stats after = Log::stats();
+    TEST_ASSERT_EQUAL_UINT32(Log::SLOTS, after.written - before.written);
+    TEST_ASSERT_EQUAL_UINT32(10, after.dropped - before.dropped);
+    TEST_ASSERT_EQUAL(Log::SLOTS, Log::pending());
+
+    Log::flush();
+    TEST_ASSERT_EQUAL_UINT32(Log::SLOTS, lines);
+    TEST_ASSERT_EQUAL_UINT32(10, droppedReported);
+    // The oldest lines were kept, the newest dropped
+    TEST_ASSERT_NOT_NULL(strstr(lastLine, "I test: line 31\n"));
+    TEST_ASSERT_EQUAL(0, Log::pending());
+
+    // Room again once drained, and the gap is reported only once
+    FT_LOGI(TAG, "after");
+    Log::flush();
+    TEST_ASSERT_EQUAL_UINT32(10, droppedReported);
+    TEST_ASSERT_NOT_NULL(strstr(lastLine, "after\n"));
+}
+
+void test_long_line_is_cut_and_keeps_its_newline()
+{
+    static char text[Log::LINE_SIZE * 2];
+    memset(text, 'x', sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+    uint32_t truncated = Log::stats().truncated;
+    FT_LOGW(TAG, "%s", text);
+    Log::flush();
+    TEST_ASSERT_EQUAL_UINT32(truncated + 1, Log::stats().truncated);
+    size_t len = strlen(lastLine);
+    TEST_ASSERT_EQUAL('\n', lastLine[len - 1]);
+    TEST_ASSERT_EQUAL('x', lastLine[len - 2]);
+    TEST_ASSERT_LESS_THAN(sizeof(text), len);
+}
+
+static int evaluated;
+
+static int sideEffect()
+{
+    return ++evaluated;
+}
+
+void test_levels_above_the_build_level_compile_out()
+{
+    TEST_ASSERT_EQUAL(FT_LOG_INFO, FT_LOG_LEVEL);
+    uint32_t written = Log::stats().written;
+    FT_LOGD(TAG, "%d", sideEffect());
+    FT_LOGV(TAG, "%d", sideEffect());
+    TEST_ASSERT_EQUAL(0, evaluated);
+    TEST_ASSERT_EQUAL_UINT32(written, Log::stats().written);
+    FT_LOGI(TAG, "%d", sideEffect());
+    TEST_ASSERT_EQUAL(1, evaluated);
+    TEST_ASSERT_EQUAL_UINT32(written + 1, Log::stats().written);
+}
+
+// Producers number their lines; the drain checks each one's stay in order
+static const int PRODUCERS = 4;
+static const int PER_PRODUCER = 20000;
+static int nextExpected[PRODUCERS];
+static uint32_t outOfOrder;
+static uint32_t received;
+
+static void checkOrder(const char *text, size_t len)
+{
+    (void)len;
+    int producer;
+    int n;
+    const char *message = strstr(text, "p");
+    if (message && sscanf(message, "p%d n%d", &producer, &n) == 2 && producer >= 0 && producer < PRODUCERS)
+    {
+        if (n < nextExpected[producer])
+        {
+            outOfOrder++;
+        }
+        nextExpected[producer] = n + 1;
+        received++;
+    }
+}
+
+// Four threads write while this one drains. Paced, they wait while the
+// ring is more than half full, as producers slower than the drain would
+// be; unpaced they outrun it and the overflow is counted instead.
+static void runProducers(bool paced, uint32_t &dropped)
+{
+    memset(nextExpected, 0, sizeof(nextExpected));
+    outOfOrder = 0;
+    received = 0;
+    Log::begin(checkOrder);
+    Log::Stats before = Log::stats();
+    std::atomic<int> running(PRODUCERS);
+    std::thread producers[PRODUCERS];
+    for (int p = 0; p < PRODUCERS; p++)
+    {
+        producers[p] = std::thread([p, paced, &running]() {
+            for (int n = 0; n < PER_PRODUCER; n++)
+            {
+                while (paced && Log::pending() > Log::SLOTS / 2)
+                {
+                    std::this_thread::yield();
+                }
+                FT_LOGI(TAG, "p%d n%d", p, n);
+            }
+            running--;
+        });
+    }
+    while (running > 0)
+    {
+        Log::drain();
+    }
+    for (std::thread &t : producers)
+    {
+        t.join();
+    }
+    Log::flush();
+    Log::begin(capture);
+
+    Log::Stats after = Log::stats();
+    dropped = after.dropped - before.dropped;
+    TEST_ASSERT_EQUAL_UINT32(0, outOfOrder);
+    TEST_ASSERT_EQUAL_UINT32(PRODUCERS * PER_PRODUCER, received + dropped);
+    TEST_ASSERT_EQUAL_UINT32(received, after.written - before.written);
+}
+
+void test_paced_producers_share_the_ring_without_loss()
+{
+    uint32_t dropped;
+    runProducers(true, dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, dropped);
+    TEST_ASSERT_EQUAL_UINT32(PRODUCERS * PER_PRODUCER, received);
+}
+
+void test_burst_from_producers_is_dropped_and_counted()
+{
+    uint32_t dropped;
+    runProducers(false, dropped);
+    TEST_ASSERT_GREATER_OR_EQUAL(Log::SLOTS, received);
+
+    char message[96];
+    snprintf(message, sizeof(message), "%d unpaced producers: %u lines through, %u dropped", PRODUCERS,
+             (unsigned)received, (unsigned)dropped);
+    TEST_MESSAGE(message);
+}
+
+// One loop pass's logging, as the field redraw does it: the pair at info
+// (queued, then drained as the log task would) or at debug (compiled out)
+static int volatile work;
+
+static double passNs(bool logged, int passes)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < passes; i++)
+    {
+        work = i;
+        if (logged)
+        {
+            FT_LOGI(TAG, "Drawing new text: '%s' at (%d,%d)", "13:07", 4, 20);
+            FT_LOGI(TAG, "Time update: %02d:%02d", 13, i % 60);
+            Log::drain();
+        }
+        else
+        {
+            FT_LOGD(TAG, "Drawing new text: '%s' at (%d,%d)", "13:07", 4, 20);
+            FT_LOGD(TAG, "Time update: %02d:%02d", 13, i % 60);
+        }
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / passes;
+}
+
+void test_loop_pass_cost_with_logging_on_and_off()
+{
+    const int passes = 100000;
+    uint32_t dropped = Log::stats().dropped;
+    passNs(true, 1000);
+    double on = passNs(true, passes);
+    double off = passNs(false, passes);
+    TEST_ASSERT_EQUAL_UINT32(dropped, Log::stats().dropped);
+    // Microseconds, not the milliseconds a blocking UART write would take
+    TEST_ASSERT_TRUE(on < 20000);
+
+    char message[96];
+    snprintf(message, sizeof(message), "per pass: %.0f ns with the pair queued and drained, %.1f ns compiled out",
+             on, off);
+    TEST_MESSAGE(message);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_full_ring_drops_and_reports_the_gap);
+    RUN_TEST(test_long_line_is_cut_and_keeps_its_newline);
+    RUN_TEST(test_levels_above_the_build_level_compile_out);
+    RUN_TEST(test_paced_producers_share_the_ring_without_loss);
+    RUN_TEST(test_burst_from_producers_is_dropped_and_counted);
+    RUN_TEST(test_loop_pass_cost_with_logging_on_and_off);
+    return UNITY_END();
+}
@@ -0,0 +1,205 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+#include "../sim_test.h"
+#include "WebServer.h"
+#include "metrics_page.h"
+
+// /metrics in the Prometheus text format (0.0.4): the page the firmware
+// serves after a few minutes of fetching, and MetricsPage on its own
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// Checks one page line by line: every family has HELP then TYPE before its
+// samples, is declared once, and every sample belongs to the family above
+// it, with labels in quotes and a numeric value. Returns the sample count;
+// a malformed line fails the test with its text.
+static int checkExposition(const char *page, size_t length)
+{
+    char family[64] = "";
+    char type[16] = "";
+    char declared[64][64];
+    int families = 0;
+    int samples = 0;
+    bool helped = false;
+
+    const char *end = page + length;
+    TEST_ASSERT_TRUE_MESSAGE(length > 0 && end[-1] == '\n', "page doesn't end in a whole line");
+    for (const char *p = page; p < end;)
+    {
+        const char *eol = (const char *)memchr(p, '\n', end - p);
+        char line[256];
+        size_t n = eol - p;
+        TEST_ASSERT_LESS_THAN(sizeof(line), n);
+        memcpy(line, p, n);
+        line[n] = '\0';
+        p = eol + 1;
+
+        char name[64];
+        if (strncmp(line, "# HELP ", 7) == 0)
+        {
+            TEST_ASSERT_EQUAL_MESSAGE(1, sscanf(line + 7, "%63s", name), line);
+            for (int i = 0; i < families; i++)
+            {
+                TEST_ASSERT_FALSE_MESSAGE(strcmp(declared[i], name) == 0, line);
+            }
+            TEST_ASSERT_LESS_THAN(64, families);
+            strcpy(declared[families++], name);
+            strcpy(family, name);
+            type[0] = '\0';
+            helped = true;
+            continue;
+        }
+        if (strncmp(line, "# TYPE ", 7) == 0)
+        {
+            TEST_ASSERT_TRUE_MESSAGE(helped, line);
+            TEST_ASSERT_EQUAL_MESSAGE(2, sscanf(line + 7, "%63s %15s", name, type), line);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(family, name, line);
+            TEST_ASSERT_TRUE_MESSAGE(strcmp(type, "counter") == 0 || strcmp(type, "gauge") == 0 ||
+                                         strcmp(type, "summary") == 0,
+                                     line);
+            if (strcmp(type, "counter") == 0)
+            {
+                size_t len = strlen(name);
+                TEST_ASSERT_TRUE_MESSAGE(len > 6 && strcmp(name + len - 6, "_total") == 0, line);
+            }
+            helped = false;
+            continue;
+        }
+        TEST_ASSERT_TRUE_MESSAGE(line[0] != '#', line);
+        TEST_ASSERT_TRUE_MESSAGE(type[0] != '\0', line);
+
+        // name{label="value",...} value
+        size_t nameLen = strcspn(line, "{ ");
+        TEST_ASSERT_LESS_THAN(sizeof(name), nameLen);
+        memcpy(name, line, nameLen);
+        name[nameLen] = '\0';
+        size_t familyLen = strlen(family);
+        bool ours = strcmp(name, family) == 0;
+        if (!ours && strcmp(type, "summary") == 0 && strncmp(name, family, familyLen) == 0)
+        {
+            ours = strcmp(name + familyLen, "_sum") == 0 || strcmp(name + familyLen, "_count") == 0;
+        }
+        TEST_ASSERT_TRUE_MESSAGE(ours, line);
+
+        const char *v = line + nameLen;
+        if (*v == '{')
+        {
+            v++;
+            while (*v != '}')
+            {
+                const char *eq = strchr(v, '=');
+                TEST_ASSERT_NOT_NULL_MESSAGE(eq, line);
+                TEST_ASSERT_EQUAL_MESSAGE('"', eq[1], line);
+                const char *close = strchr(eq + 2, '"');
+                TEST_ASSERT_NOT_NULL_MESSAGE(close, line);
+                v = close + 1;
+                if (*v == ',')
+                {
+                    v++;
+                }
+                TEST_ASSERT_TRUE_MESSAGE(*v != '\0', line);
+            }
+            v++;
+        }
+        TEST_ASSERT_EQUAL_MESSAGE(' ', *v, line);
+        char *valueEnd;
+        strtod(v + 1, &valueEnd);
+        TEST_ASSERT_TRUE_MESSAGE(valueEnd != v + 1 && *valueEnd == '\0', line);
+        samples++;
+    }
+    return samples;
+}
+
+// Value of the sample line starting with `prefix` (name and labels), or -1
+static double sample(const char *page, const char *prefix)
+{
+    size_t len = strlen(prefix);
+    for (const char *p = page; *p;)
+    {
+        if (strncmp(p, prefix, len) == 0 && p[len] == ' ')
+        {
+            return strtod(p + len + 1, nullptr);
+        }
+        const char *eol = strchr(p, '\n');
+        if (!eol)
+        {
+            break;
+        }
+        p = eol + 1;
+    }
+    return -1;
+}
+
+static const char *page;
+static size_t pageLength;
+
+void test_served_page_is_valid_exposition()
+{
+    SimTest::powerOn(SimTest::LONDON_NOON);
+    setup();
+    TEST_ASSERT_TRUE(SimTest::runUntil(300));
+
+    TEST_ASSERT_EQUAL(200, WebServer::get("/metrics", &page, &pageLength));
+    int samples = checkExposition(page, pageLength);
+    char message[64];
+    snprintf(message, sizeof(message), "%u bytes, %d samples", (unsigned)pageLength, samples);
+    TEST_MESSAGE(message);
+}
+
+void test_served_page_carries_the_run()
+{
+    TEST_ASSERT_GREATER_OR_EQUAL(10, sample(page, "ft_fetch_total{endpoint=\"flight\",result=\"ok\"}"));
+    TEST_ASSERT_EQUAL(0, sample(page, "ft_fetch_total{endpoint=\"flight\",result=\"failed\"}"));
+    TEST_ASSERT_GREATER_OR_EQUAL(1, sample(page, "ft_fetch_total{endpoint=\"weather\",result=\"ok\"}"));
+    TEST_ASSERT_EQUAL(sample(page, "ft_fetch_total{endpoint=\"flight\",result=\"ok\"}"),
+                      sample(page, "ft_fetch_stage_seconds_count{endpoint=\"flight\",stage=\"total\"}"));
+    TEST_ASSERT_EQUAL(1, sample(page, "ft_wifi_connected"));
+    TEST_ASSERT_TRUE(sample(page, "ft_wifi_rssi_dbm") < 0);
+    TEST_ASSERT_GREATER_OR_EQUAL(299, sample(page, "ft_uptime_seconds"));
+    TEST_ASSERT_GREATER_THAN(0, sample(page, "ft_display_frames_total"));
+}
+
+void test_page_cut_short_keeps_whole_lines()
+{
+    static char full[16384];
+    static char cut[700];
+    MetricsPage::System sys = {};
+    bool complete = false;
+    size_t fullLen = MetricsPage::format(full, sizeof(full), sys, &complete);
+    TEST_ASSERT_TRUE(complete);
+
+    size_t cutLen = MetricsPage::format(cut, sizeof(cut), sys, &complete);
+    TEST_ASSERT_FALSE(complete);
+    TEST_ASSERT_LESS_THAN(fullLen, cutLen);
+    TEST_ASSERT_EQUAL('\n', cut[cutLen - 1]);
+    TEST_ASSERT_EQUAL(0, strncmp(full, cut, cutLen));
+    checkExposition(cut, cutLen);
+}
+
+void test_disconnected_page_has_no_rssi()
+{
+    static char buffer[16384];
+    MetricsPage::System sys = {};
+    sys.rssi = -60;
+    size_t len = MetricsPage::format(buffer, sizeof(buffer), sys);
+    checkExposition(buffer, len);
+    TEST_ASSERT_EQUAL(0, sample(buffer, "ft_wifi_connected"));
+    TEST_ASSERT_NULL(strstr(buffer, "ft_wifi_rssi_dbm"));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_served_page_is_valid_exposition);
+    RUN_TEST(test_served_page_carries_the_run);
+    RUN_TEST(test_page_cut_short_keeps_whole_lines);
+    RUN_TEST(test_disconnected_page_has_no_rssi);
+    return UNITY_END();
+}
@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include "../ram_panel_bus.h"
+#include "../sim_test.h"
+#include "cpu_governor.h"
+#include "display_manager.h"
+#include "sim_panel.h"
+#include "st77xx_panel.h"
+
+// Panel sleep and wake: St77xxPanel's command sequence against a model of
+// the controller's RAM, the sleep policy on its own, and DisplayManager
+// in the simulator keeping what is drawn while asleep for the wake
+
+static const int16_t W = RamPanelBus::WIDTH;
+static const int16_t H = RamPanelBus::HEIGHT;
+
+static RamPanelBus ram;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// Index of the first `type` event with `value` at or after `from`, or -1
+static int findEvent(const TracePanelBus &trace, PanelBusEvent::Type type, uint8_t value, size_t from = 0)
+{
+    for (size_t i = from; i < trace.eventCount(); i++)
+    {
+        if (trace.event(i).type == type && trace.event(i).value == value)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+void test_sleep_and_wake_commands_keep_frame_memory()
+{
+    TracePanelBus trace(&ram);
+    St77xxPanel panel(trace, W, H, 0, 0);
+    panel.begin();
+    panel.fillScreen(ST77XX_BLUE);
+    panel.fillRect(10, 20, 30, 40, ST77XX_YELLOW);
+    static uint16_t before[H][W];
+    memcpy(before, ram.ram, sizeof(before));
+
+    trace.clear();
+    panel.sleep();
+    TEST_ASSERT_TRUE(panel.isAsleep());
+    int off = findEvent(trace, PanelBusEvent::COMMAND, 0x28); // DISPOFF
+    int slpin = findEvent(trace, PanelBusEvent::COMMAND, 0x10);
+    TEST_ASSERT_TRUE(off >= 0 && slpin > off);
+    // SLPIN's 5 ms comes last, outside the transaction
+    TEST_ASSERT_EQUAL(PanelBusEvent::DELAY, trace.event(trace.eventCount() - 1).type);
+    TEST_ASSERT_EQUAL_UINT32(5, trace.event(trace.eventCount() - 1).count);
+    TEST_ASSERT_EQUAL_UINT32(0, trace.totals().pixelBytes);
+
+    // Twice is a no-op
+    size_t events = trace.eventCount();
+    panel.sleep();
+    TEST_ASSERT_EQUAL(events, trace.eventCount());
+
+    trace.clear();
+    panel.wake();
+    TEST_ASSERT_FALSE(panel.isAsleep());
+    int slpout = findEvent(trace, PanelBusEvent::COMMAND, 0x11);
+    TEST_ASSERT_TRUE(slpout >= 0);
+    TEST_ASSERT_EQUAL(PanelBusEvent::DELAY, trace.event(trace.eventCount() - 1).type);
+    TEST_ASSERT_EQUAL_UINT32(120, trace.event(trace.eventCount() - 1).count);
+    // DISPON is the caller's, once the picture is up to date
+    TEST_ASSERT_EQUAL(-1, findEvent(trace, PanelBusEvent::COMMAND, 0x29));
+    TEST_ASSERT_EQUAL_MEMORY(before, ram.ram, sizeof(before));
+
+    events = trace.eventCount();
+    panel.wake();
+    TEST_ASSERT_EQUAL(events, trace.eventCount());
+    panel.setDisplayOn(true);
+    TEST_ASSERT_TRUE(findEvent(trace, PanelBusEvent::COMMAND, 0x29, events) >= 0);
+}
+
+void test_policy_decides_when_the_panel_is_wanted()
+{
+    // Always on by day and for an error, whatever the policy
+    for (int policy = PANEL_ALWAYS_ON; policy <= PANEL_SLEEP_AT_NIGHT_EXCEPT_FLIGHTS; policy++)
+    {
+        PanelSleepPolicy p = (PanelSleepPolicy)policy;
+        TEST_ASSERT_TRUE(DisplayManager::panelWanted(p, false, false, false));
+        TEST_ASSERT_TRUE(DisplayManager::panelWanted(p, false, true, false));
+        TEST_ASSERT_TRUE(DisplayManager::panelWanted(p, true, false, true));
+    }
+    TEST_ASSERT_TRUE(DisplayManager::panelWanted(PANEL_ALWAYS_ON, true, false, false));
+    TEST_ASSERT_FALSE(DisplayManager::panelWanted(PANEL_SLEEP_AT_NIGHT, true, false, false));
+    TEST_ASSERT_FALSE(DisplayManager::panelWanted(PANEL_SLEEP_AT_NIGHT, true, true, false));
+    TEST_ASSERT_FALSE(DisplayManager::panelWanted(PANEL_SLEEP_AT_NIGHT_EXCEPT_FLIGHTS, true, false, false));
+    TEST_ASSERT_TRUE(DisplayManager::panelWanted(PANEL_SLEEP_AT_NIGHT_EXCEPT_FLIGHTS, true, true, false));
+}
+
+static unsigned clockSwitches()
+{
+    char report[256];
+    CpuGovernor::formatReport(report, sizeof(report));
+    const char *line = strstr(report, "cpu now");
+    unsigned switches = 0;
+    TEST_ASSERT_NOT_NULL(line);
+    TEST_ASSERT_EQUAL(1, sscanf(strstr(line, "MHz, ") + 5, "%u switches", &switches));
+    return switches;
+}
+
+void test_drawing_while_asleep_goes_out_on_wake()
+{
+    SimTest::powerOn(SimTest::LONDON_NOON);
+    setup();
+    TEST_ASSERT_TRUE(SimTest::runUntil(60));
+    DisplayManager::setPanelSleepPolicy(PANEL_SLEEP_AT_NIGHT);
+    SimPanelBus &bus = *SimPanelBus::instance();
+
+    uint32_t bytes = bus.bytesSent();
+    DisplayManager::updatePanelPower(true);
+    TEST_ASSERT_TRUE(DisplayManager::isPanelAsleep());
+    TEST_ASSERT_EQUAL_UINT32(1, DisplayManager::panelPowerStats().sleeps);
+    // DISPOFF and SLPIN, nothing else
+    TEST_ASSERT_EQUAL_UINT32(bytes + 2, bus.bytesSent());
+    DisplayManager::updatePanelPower(true);
+    TEST_ASSERT_EQUAL_UINT32(1, DisplayManager::panelPowerStats().sleeps);
+
+    // A new flight lands on the canvas only
+    bytes = bus.bytesSent();
+    DisplayManager::drawFlight("LHR", "A320", "BAW123");
+    TEST_ASSERT_EQUAL_UINT32(bytes, bus.bytesSent());
+
+    unsigned long start = millis();
+    unsigned switches = clockSwitches();
+    DisplayManager::updatePanelPower(false);
+    // The catch-up flush runs boosted: up and back down
+    TEST_ASSERT_EQUAL(switches + 2, clockSwitches());
+    TEST_ASSERT_FALSE(DisplayManager::isPanelAsleep());
+    const PanelPowerStats &stats = DisplayManager::panelPowerStats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.wakes);
+    // SLPOUT's settle time is all of it in virtual time; the flush is free
+    TEST_ASSERT_GREATER_OR_EQUAL(120000, stats.lastWakeUs);
+    TEST_ASSERT_EQUAL_UINT32(stats.lastWakeUs, stats.maxWakeUs);
+    TEST_ASSERT_GREATER_OR_EQUAL(120, millis() - start);
+    // SLPOUT, the dirty rows, DISPON
+    uint32_t wakeBytes = bus.bytesSent() - bytes;
+    TEST_ASSERT_GREATER_THAN(2, wakeBytes);
+
+    char message[96];
+    snprintf(message, sizeof(message), "wake: %lu us, %u bytes caught up before DISPON",
+             (unsigned long)stats.lastWakeUs, (unsigned)wakeBytes);
+    TEST_MESSAGE(message);
+}
+
+void test_error_wakes_a_sleeping_panel()
+{
+    DisplayManager::updatePanelPower(true);
+    TEST_ASSERT_TRUE(DisplayManager::isPanelAsleep());
+    DisplayManager::drawError("WiFi lost");
+    DisplayManager::updatePanelPower(true);
+    TEST_ASSERT_FALSE(DisplayManager::isPanelAsleep());
+    TEST_ASSERT_EQUAL_UINT32(2, DisplayManager::panelPowerStats().sleeps);
+    TEST_ASSERT_EQUAL_UINT32(2, DisplayManager::panelPowerStats().wakes);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_sleep_and_wake_commands_keep_frame_memory);
+    RUN_TEST(test_policy_decides_when_the_panel_is_wanted);
+    RUN_TEST(test_drawing_while_asleep_goes_out_on_wake);
+    RUN_TEST(test_error_wakes_a_sleeping_panel);
+    return UNITY_END();
+}
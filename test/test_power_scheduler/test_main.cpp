@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <unity.h>
+#include "power_scheduler.h"
+
+// PowerScheduler::decide() on its own, then a virtual-time day through it
+// for the modeled awake fraction. The simulator can't give that figure:
+// its clock only moves while the firmware waits, so work costs nothing.
+
+static PowerScheduler::Decision decide(bool night, unsigned long idleMs, bool errorShown = false,
+                                       bool radioBusy = false, bool panelLit = false)
+{
+    PowerScheduler::Inputs in;
+    in.night = night;
+    in.errorShown = errorShown;
+    in.radioBusy = radioBusy;
+    in.panelLit = panelLit;
+    in.idleMs = idleMs;
+    return PowerScheduler::decide(in);
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_day_always_idles_for_the_whole_wait()
+{
+    PowerScheduler::Decision d = decide(false, 3600000);
+    TEST_ASSERT_EQUAL(PowerScheduler::IDLE, d.action);
+    TEST_ASSERT_EQUAL_UINT32(3600000, d.sleepMs);
+    TEST_ASSERT_EQUAL(PowerScheduler::IDLE, decide(false, 3600000, false, false, true).action);
+}
+
+void test_night_deep_sleeps_and_wakes_ahead_of_the_deadline()
+{
+    PowerScheduler::Decision d = decide(true, 1800000);
+    TEST_ASSERT_EQUAL(PowerScheduler::DEEP_SLEEP, d.action);
+    TEST_ASSERT_EQUAL_UINT32(1800000 - PowerScheduler::WAKE_LEAD_MS, d.sleepMs);
+
+    d = decide(true, PowerScheduler::MIN_DEEP_SLEEP_MS);
+    TEST_ASSERT_EQUAL(PowerScheduler::DEEP_SLEEP, d.action);
+}
+
+void test_night_light_sleeps_for_the_whole_wait_while_the_panel_is_lit()
+{
+    // Deep sleep would reboot and redraw for every clock minute
+    PowerScheduler::Decision d = decide(true, 60000, false, false, true);
+    TEST_ASSERT_EQUAL(PowerScheduler::LIGHT_SLEEP, d.action);
+    TEST_ASSERT_EQUAL_UINT32(60000, d.sleepMs);
+
+    TEST_ASSERT_EQUAL(PowerScheduler::IDLE, decide(true, PowerScheduler::MIN_DEEP_SLEEP_MS - 1, false, false, true).action);
+    TEST_ASSERT_EQUAL(PowerScheduler::IDLE, decide(true, 60000, true, false, true).action);
+    TEST_ASSERT_EQUAL(PowerScheduler::IDLE, decide(true, 60000, false, true, true).action);
+}
+
+void test_night_stays_up_when_sleep_would_not_pay_or_must_not_happen()
+{
+    PowerScheduler::Decision d = decide(true, PowerScheduler::MIN_DEEP_SLEEP_MS - 1);
+    TEST_ASSERT_EQUAL(PowerScheduler::IDLE, d.action);
+    TEST_ASSERT_EQUAL_UINT32(PowerScheduler::MIN_DEEP_SLEEP_MS - 1, d.sleepMs);
+    // An error screen stays live; a connect or the portal needs the radio
+    TEST_ASSERT_EQUAL(PowerScheduler::IDLE, decide(true, 1800000, true).action);
+    TEST_ASSERT_EQUAL(PowerScheduler::IDLE, decide(true, 1800000, false, true).action);
+}
+
+// The loop's schedule, as in main.cpp
+static const unsigned long DAY_FLIGHT_INTERVAL = 20000;
+static const unsigned long NIGHT_FLIGHT_INTERVAL = 3600000;
+static const unsigned long WEATHER_INTERVAL = 600000;
+static const unsigned long MAX_DARK_SLEEP = 1800000;
+static const int NIGHT_START_HOUR = 22;
+static const int NIGHT_END_HOUR = 7;
+
+// Assumed costs of the work the model wakes for
+static const unsigned long REDRAW_MS = 15;        // clock minute, flush included
+static const unsigned long FETCH_MS = 800;        // TLS request and parse, radio up
+static const unsigned long WIFI_RESUME_MS = 2500; // radio back on at night
+static const unsigned long BOOT_MS = 350;         // deep-sleep wake to loop()
+static const unsigned long LIGHT_WAKE_MS = 1;     // light-sleep wake to loop()
+
+static const unsigned long HOUR_MS = 3600000;
+static const unsigned long DAY_MS = 24 * HOUR_MS;
+
+struct AwakeModel
+{
+    unsigned long awakeMs[2]; // [night]
+    unsigned long spanMs[2];
+    unsigned nightWaits;
+    unsigned deepSleeps;
+    unsigned lightSleeps;
+};
+
+static unsigned long untilDue(unsigned long now, unsigned long last, unsigned long interval)
+{
+    return now - last >= interval ? 0 : interval - (now - last);
+}
+
+// A local day from midnight: WiFi is parked between night fetches, and
+// every wait goes through decide(). The panel is dark at night (no clock)
+// unless `litAtNight`, when the clock keeps its minutes all night.
+static AwakeModel runDay(bool litAtNight)
+{
+    AwakeModel m = {};
+    unsigned long now = 0;
+    unsigned long lastFlight = 0;
+    unsigned long lastWeather = 0;
+    bool first = true;
+    while (now < DAY_MS)
+    {
+        int hour = (int)(now / HOUR_MS);
+        bool night = hour >= NIGHT_START_HOUR || hour < NIGHT_END_HOUR;
+        unsigned long work = 0;
+
+        unsigned long flightInterval = night ? NIGHT_FLIGHT_INTERVAL : DAY_FLIGHT_INTERVAL;
+        if (first || untilDue(now, lastFlight, flightInterval) == 0)
+        {
+            work += FETCH_MS + (night ? WIFI_RESUME_MS : 0);
+            lastFlight = now;
+        }
+        if (first || untilDue(now, lastWeather, WEATHER_INTERVAL) == 0)
+        {
+            work += FETCH_MS + (night ? WIFI_RESUME_MS : 0);
+            lastWeather = now;
+        }
+        bool lit = !night || litAtNight;
+        if (lit && now % 60000 == 0)
+        {
+            work += REDRAW_MS;
+        }
+        first = false;
+
+        unsigned long wait = lit ? 60000 - now % 60000 : MAX_DARK_SLEEP;
+        if (night)
+        {
+            unsigned long endOfNight = (hour < NIGHT_END_HOUR ? NIGHT_END_HOUR : 24 + NIGHT_END_HOUR) * HOUR_MS;
+            wait = std::min(wait, endOfNight - now);
+        }
+        wait = std::min(wait, untilDue(now, lastFlight, flightInterval));
+        wait = std::min(wait, untilDue(now, lastWeather, WEATHER_INTERVAL));
+
+        PowerScheduler::Decision d = decide(night, wait, false, false, lit);
+        m.nightWaits += night;
+        if (d.action == PowerScheduler::DEEP_SLEEP)
+        {
+            work += BOOT_MS;
+            m.deepSleeps++;
+        }
+        else if (d.action == PowerScheduler::LIGHT_SLEEP)
+        {
+            work += LIGHT_WAKE_MS;
+            m.lightSleeps++;
+        }
+        m.awakeMs[night] += work;
+        m.spanMs[night] += wait;
+        now += wait;
+    }
+    return m;
+}
+
+void test_modeled_day_awake_fraction()
+{
+    AwakeModel m = runDay(false);
+    double day = 100.0 * m.awakeMs[0] / m.spanMs[0];
+    double night = 100.0 * m.awakeMs[1] / m.spanMs[1];
+    double all = 100.0 * (m.awakeMs[0] + m.awakeMs[1]) / DAY_MS;
+    TEST_ASSERT_EQUAL_UINT32(DAY_MS, m.spanMs[0] + m.spanMs[1]);
+    // Every night wait is long enough to deep sleep, and no day wait is
+    TEST_ASSERT_GREATER_OR_EQUAL(9 * 6, m.nightWaits);
+    TEST_ASSERT_EQUAL(m.nightWaits, m.deepSleeps);
+    TEST_ASSERT_EQUAL(0, m.lightSleeps);
+    TEST_ASSERT_TRUE(night < day / 2);
+    TEST_ASSERT_TRUE(all < 5.0);
+
+    char message[128];
+    snprintf(message, sizeof(message), "modeled awake: %.2f%% by day, %.2f%% at night, %.2f%% over 24 h, %u deep sleeps",
+             day, night, all, m.deepSleeps);
+    TEST_MESSAGE(message);
+}
+
+// The clock lit all night (always-on policy, or a flight on screen): no
+// reboot per minute, the radio parked between fetches as in deep sleep
+void test_modeled_lit_night_light_sleeps()
+{
+    AwakeModel m = runDay(true);
+    double night = 100.0 * m.awakeMs[1] / m.spanMs[1];
+    TEST_ASSERT_EQUAL(0, m.deepSleeps);
+    // Every night minute but the few cut short by a fetch deadline
+    TEST_ASSERT_GREATER_OR_EQUAL(9 * 60, m.lightSleeps);
+    TEST_ASSERT_EQUAL(m.nightWaits, m.lightSleeps);
+
+    char message[160];
+    snprintf(message, sizeof(message),
+             "lit night: %.2f%% awake, %u light sleeps; deep sleep in their place would add %lu s of boots",
+             night, m.lightSleeps, (unsigned long)m.lightSleeps * BOOT_MS / 1000);
+    TEST_MESSAGE(message);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_day_always_idles_for_the_whole_wait);
+    RUN_TEST(test_night_deep_sleeps_and_wakes_ahead_of_the_deadline);
+    RUN_TEST(test_night_light_sleeps_for_the_whole_wait_while_the_panel_is_lit);
+    RUN_TEST(test_night_stays_up_when_sleep_would_not_pay_or_must_not_happen);
+    RUN_TEST(test_modeled_day_awake_fraction);
+    RUN_TEST(test_modeled_lit_night_light_sleeps);
+    return UNITY_END();
+}
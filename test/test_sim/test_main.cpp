@@ -0,0 +1,112 @@
+#include <unity.h>
+#include "../sim_test.h"
+#include "display_manager.h"
+#include "fetch_metrics.h"
+#include "flight_data_manager.h"
+#include "ft_wifi_manager.h"
+#include "power_scheduler.h"
+#include "time_service.h"
+#include "time_sync.h"
+
+// The simulator itself: virtual time, then the firmware run through an
+// evening into the night: light sleep while a flight keeps the panel lit,
+// deep sleep once the panel goes dark
+
+static char fired[8];
+static uint8_t firedCount;
+
+static void eventA()
+{
+    fired[firedCount++] = 'A';
+}
+
+static void eventB()
+{
+    fired[firedCount++] = 'B';
+}
+
+static void notifyLoop()
+{
+    Sim::notify();
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_wait_jumps_to_deadline_and_runs_events_in_order()
+{
+    firedCount = 0;
+    uint64_t start = Sim::nowUs();
+    Sim::after(300, eventB);
+    Sim::after(100, eventA);
+    Sim::after(5000, eventB); // past the wait
+    TEST_ASSERT_FALSE(Sim::wait(1000, false));
+    TEST_ASSERT_EQUAL_UINT64(start + 1000000, Sim::nowUs());
+    TEST_ASSERT_EQUAL(2, firedCount);
+    TEST_ASSERT_EQUAL('A', fired[0]);
+    TEST_ASSERT_EQUAL('B', fired[1]);
+    Sim::wait(5000, false);
+    TEST_ASSERT_EQUAL(3, firedCount);
+}
+
+void test_notification_ends_the_wait_at_the_event()
+{
+    uint64_t start = Sim::nowUs();
+    Sim::after(250, notifyLoop);
+    TEST_ASSERT_TRUE(Sim::wait(60000, true));
+    TEST_ASSERT_EQUAL_UINT64(start + 250000, Sim::nowUs());
+    TEST_ASSERT_TRUE(Sim::takeNotification());
+}
+
+void test_evening_connects_syncs_and_fetches()
+{
+    // 21:50 BST, ten minutes before the night schedule starts
+    SimTest::powerOn(SimTest::LONDON_NOON + 8 * 3600 + 50 * 60);
+    setup();
+    TEST_ASSERT_TRUE(SimTest::runUntil(310));
+
+    TEST_ASSERT_TRUE(FtWiFiManager::isConnected());
+    TEST_ASSERT_TRUE(TimeSync::isSynced());
+    TEST_ASSERT_EQUAL_STRING("21:55", TimeService::timeString());
+    TEST_ASSERT_GREATER_OR_EQUAL(1, FetchMetrics::successes(FetchMetrics::ENDPOINT_WEATHER));
+    // One every 20 s by day
+    TEST_ASSERT_GREATER_OR_EQUAL(10, FetchMetrics::successes(FetchMetrics::ENDPOINT_FLIGHT));
+    TEST_ASSERT_EQUAL_STRING("IBB8121", FlightDataManager::lastRecord().callsign);
+}
+
+void test_lit_night_light_sleeps_with_the_radio_parked()
+{
+    // A flight is on screen, so the panel stays on and the clock wants
+    // every minute: no reboot for each one
+    TEST_ASSERT_TRUE(SimTest::runUntil(3600));
+    TEST_ASSERT_EQUAL(22, TimeService::hour());
+    TEST_ASSERT_EQUAL_UINT32(0, PowerScheduler::retained().deepSleeps);
+    TEST_ASSERT_GREATER_OR_EQUAL(40, PowerScheduler::lightSleeps());
+    TEST_ASSERT_TRUE(FtWiFiManager::isRadioOff());
+}
+
+void test_dark_night_ends_in_deep_sleep()
+{
+    DisplayManager::setPanelSleepPolicy(PANEL_SLEEP_AT_NIGHT);
+    TEST_ASSERT_FALSE(SimTest::runUntil(7200));
+    TEST_ASSERT_EQUAL(22, TimeService::hour());
+    TEST_ASSERT_TRUE(DisplayManager::isPanelAsleep());
+    TEST_ASSERT_EQUAL_UINT32(1, PowerScheduler::retained().deepSleeps);
+    TEST_ASSERT_GREATER_OR_EQUAL(PowerScheduler::MIN_DEEP_SLEEP_MS, PowerScheduler::retained().sleptMs);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_wait_jumps_to_deadline_and_runs_events_in_order);
+    RUN_TEST(test_notification_ends_the_wait_at_the_event);
+    RUN_TEST(test_evening_connects_syncs_and_fetches);
+    RUN_TEST(test_lit_night_light_sleeps_with_the_radio_parked);
+    RUN_TEST(test_dark_night_ends_in_deep_sleep);
+    return UNITY_END();
+}
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include "../sim_test.h"
+#include "flight_data_manager.h"
+#include "snapshot_hash.h"
+#include "weather_manager.h"
+
+// Snapshot hashing: the hash and gate on their own, then a scripted replay
+// of flight and weather responses through the firmware in the simulator,
+// where only the polls that change what's shown may reach the display
+
+static const char FLIGHT_A[] = "{\"flightDataAvailable\":true,\"callsign\":\"IBB8121\",\"originAirportIata\":\"TFN\","
+                               "\"destinationAirportIata\":\"SPC\",\"aircraftCode\":\"AT76\"}";
+// Same flight, a field the display doesn't show changed
+static const char FLIGHT_A_MOVED[] = "{\"flightDataAvailable\":true,\"callsign\":\"IBB8121\",\"originAirportIata\":"
+                                     "\"TFN\",\"destinationAirportIata\":\"SPC\",\"aircraftCode\":\"AT76\","
+                                     "\"altitude\":11000}";
+static const char FLIGHT_B[] = "{\"flightDataAvailable\":true,\"callsign\":\"BAW2LC\",\"originAirportIata\":\"LHR\","
+                               "\"destinationAirportIata\":\"SPC\",\"aircraftCode\":\"A320\"}";
+static const char NO_FLIGHT[] = "{\"flightDataAvailable\":false}";
+
+// One entry per 20 s poll; the last repeats. Changes at 0, 5, 8, 10 and 14.
+static const char *const FLIGHT_SCRIPT[] = {
+    FLIGHT_A, FLIGHT_A,  FLIGHT_A_MOVED, FLIGHT_A,  FLIGHT_A, FLIGHT_B, FLIGHT_B,
+    FLIGHT_B, FLIGHT_A,  FLIGHT_A,       NO_FLIGHT, NO_FLIGHT, NO_FLIGHT, NO_FLIGHT,
+    FLIGHT_A, FLIGHT_A,  FLIGHT_A,       FLIGHT_A,  FLIGHT_A, FLIGHT_A,
+};
+static const unsigned FLIGHT_POLLS = sizeof(FLIGHT_SCRIPT) / sizeof(FLIGHT_SCRIPT[0]);
+static const uint32_t FLIGHT_CHANGES = 5;
+
+// One entry per 10 min fetch: 21.0, 21.0, 22.5, 22.5, 22.5, 21.0
+static const char *const WEATHER_SCRIPT[] = {
+    "{\"current\":{\"temperature_2m\":21.0,\"relative_humidity_2m\":60}}",
+    "{\"current\":{\"temperature_2m\":21.0,\"relative_humidity_2m\":60}}",
+    "{\"current\":{\"temperature_2m\":22.5,\"relative_humidity_2m\":60}}",
+    "{\"current\":{\"temperature_2m\":22.5,\"relative_humidity_2m\":60}}",
+    "{\"current\":{\"temperature_2m\":22.5,\"relative_humidity_2m\":60}}",
+    "{\"current\":{\"temperature_2m\":21.0,\"relative_humidity_2m\":60}}",
+};
+static const unsigned WEATHER_FETCHES = sizeof(WEATHER_SCRIPT) / sizeof(WEATHER_SCRIPT[0]);
+static const uint32_t WEATHER_CHANGES = 3;
+
+static unsigned flightPolls;
+static unsigned weatherFetches;
+
+static const char *replay(const char *host, const char *path)
+{
+    (void)host;
+    if (strncmp(path, "/v1/forecast", 12) == 0)
+    {
+        unsigned i = weatherFetches++;
+        return WEATHER_SCRIPT[i < WEATHER_FETCHES ? i : WEATHER_FETCHES - 1];
+    }
+    unsigned i = flightPolls++;
+    return FLIGHT_SCRIPT[i < FLIGHT_POLLS ? i : FLIGHT_POLLS - 1];
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_hash_separates_fields_and_gate_counts()
+{
+    uint64_t abc = SnapshotHash().add("AB").add("C").result();
+    TEST_ASSERT_TRUE(abc != SnapshotHash().add("A").add("BC").result());
+    TEST_ASSERT_TRUE(abc == SnapshotHash().add("AB").add("C").result());
+    TEST_ASSERT_TRUE(SnapshotHash().add(1u).result() != SnapshotHash().add(256u).result());
+
+    SnapshotGate gate;
+    TEST_ASSERT_TRUE(gate.changed(abc));
+    TEST_ASSERT_FALSE(gate.changed(abc));
+    gate.invalidate();
+    TEST_ASSERT_TRUE(gate.changed(abc));
+    TEST_ASSERT_EQUAL_UINT32(2, gate.appliedCount());
+    TEST_ASSERT_EQUAL_UINT32(1, gate.suppressedCount());
+}
+
+void test_replay_applies_only_the_changes()
+{
+    Log::begin(SimTest::captureLog);
+    SimTest::powerOn(SimTest::LONDON_NOON);
+    Sim::options.respond = replay;
+    setup();
+    // Past the hour so the weather script plays out and the stats line is logged
+    TEST_ASSERT_TRUE(SimTest::runUntil(3630));
+    TEST_ASSERT_GREATER_OR_EQUAL(FLIGHT_POLLS, flightPolls);
+    TEST_ASSERT_GREATER_OR_EQUAL(WEATHER_FETCHES, weatherFetches);
+
+    const SnapshotGate &flights = FlightDataManager::snapshots();
+    const SnapshotGate &weather = WeatherManager::snapshots();
+    TEST_ASSERT_EQUAL_UINT32(FLIGHT_CHANGES, flights.appliedCount());
+    TEST_ASSERT_EQUAL_UINT32(flightPolls - FLIGHT_CHANGES, flights.suppressedCount());
+    TEST_ASSERT_EQUAL_UINT32(WEATHER_CHANGES, weather.appliedCount());
+    TEST_ASSERT_EQUAL_UINT32(weatherFetches - WEATHER_CHANGES, weather.suppressedCount());
+    TEST_ASSERT_EQUAL_STRING("IBB8121", FlightDataManager::lastRecord().callsign);
+    TEST_ASSERT_EQUAL_STRING("21", WeatherManager::temperature());
+
+    // The hourly stats carry the counts as of the hour
+    const char *line = strstr(SimTest::capturedLog(), "Snapshots: ");
+    TEST_ASSERT_NOT_NULL_MESSAGE(line, "no snapshot counts in the hourly stats");
+    unsigned flightApplied, flightSuppressed, weatherApplied, weatherSuppressed;
+    TEST_ASSERT_EQUAL(4, sscanf(line, "Snapshots: flight %u applied, %u suppressed; weather %u applied, %u suppressed",
+                                &flightApplied, &flightSuppressed, &weatherApplied, &weatherSuppressed));
+    TEST_ASSERT_EQUAL(FLIGHT_CHANGES, flightApplied);
+    TEST_ASSERT_EQUAL(WEATHER_CHANGES, weatherApplied);
+    TEST_ASSERT_LESS_OR_EQUAL(flights.suppressedCount(), flightSuppressed);
+    TEST_ASSERT_GREATER_THAN(FLIGHT_POLLS - FLIGHT_CHANGES, flightSuppressed);
+
+    char message[128];
+    snprintf(message, sizeof(message), "%u flight polls: %u applied, %u suppressed; %u weather fetches: %u applied",
+             flightPolls, (unsigned)flights.appliedCount(), (unsigned)flights.suppressedCount(), weatherFetches,
+             (unsigned)weather.appliedCount());
+    TEST_MESSAGE(message);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_hash_separates_fields_and_gate_counts);
+    RUN_TEST(test_replay_applies_only_the_changes);
+    return UNITY_END();
+}
@@ -0,0 +1,291 @@
+#include <unity.h>
+#include <string.h>
+#include <new>
+#include "sntp_client.h"
+
+// SntpClient against a stand-in for the network and the system clock: three
+// servers on the true clock with fixed round trips, and a local clock that
+// can start off, drift, and be stepped or slewed by the client
+
+static const int64_t TRUE_START_US = 1751371200LL * 1000000; // 2025-07-01 12:00 UTC
+
+class FakeNtp : public SntpDriver
+{
+public:
+    static const uint8_t SERVERS = 3;
+
+    int64_t trueUs;
+    double localOffsetUs; // local - true
+    double ppm;           // local clock rate error, positive = fast
+    uint32_t rttMs[SERVERS];
+    bool kiss[SERVERS];
+    uint32_t opens;
+    uint32_t sends;
+
+    FakeNtp() { reset(); }
+
+    void reset()
+    {
+        trueUs = TRUE_START_US;
+        localOffsetUs = -(double)TRUE_START_US; // power-on: 1970
+        ppm = 0;
+        const uint32_t rtts[SERVERS] = {40, 10, 200};
+        memcpy(rttMs, rtts, sizeof(rttMs));
+        memset(kiss, 0, sizeof(kiss));
+        opens = sends = 0;
+        queued = 0;
+    }
+
+    unsigned long millis() const { return (unsigned long)((trueUs - TRUE_START_US) / 1000); }
+
+    void advance(uint32_t ms)
+    {
+        trueUs += (int64_t)ms * 1000;
+        localOffsetUs += ms * 1000.0 * ppm / 1e6;
+    }
+
+    // Local clock error in microseconds
+    int64_t errorUs() const { return (int64_t)localOffsetUs; }
+
+    bool open() override
+    {
+        opens++;
+        queued = 0;
+        return true;
+    }
+
+    void close() override
+    {
+        queued = 0;
+    }
+
+    bool send(uint8_t server, const uint8_t *packet, size_t len) override
+    {
+        if (len != SntpClient::PACKET_SIZE || queued == MAX_QUEUED)
+        {
+            return false;
+        }
+        sends++;
+        Reply &r = replies[queued++];
+        r.server = server;
+        r.arrivesUs = trueUs + (int64_t)rttMs[server] * 1000;
+        memset(r.data, 0, sizeof(r.data));
+        r.data[0] = (0 << 6) | (4 << 3) | 4;
+        r.data[1] = kiss[server] ? 0 : 2;
+        memcpy(r.data + 24, packet + 40, 8);
+        // Stamped halfway along a symmetric path
+        uint64_t at = SntpClient::toNtp(trueUs + (int64_t)rttMs[server] * 500);
+        put(r.data + 32, at);
+        put(r.data + 40, at);
+        return true;
+    }
+
+    size_t receive(uint8_t *packet, size_t size, uint8_t &server) override
+    {
+        for (uint8_t i = 0; i < queued; i++)
+        {
+            if (replies[i].arrivesUs <= trueUs)
+            {
+                server = replies[i].server;
+                size_t len = size < sizeof(replies[i].data) ? size : sizeof(replies[i].data);
+                memcpy(packet, replies[i].data, len);
+                memmove(&replies[i], &replies[i + 1], (queued - i - 1) * sizeof(Reply));
+                queued--;
+                return len;
+            }
+        }
+        return 0;
+    }
+
+    int64_t nowUs() override { return trueUs + (int64_t)localOffsetUs; }
+
+    void adjust(int64_t deltaUs, bool step) override
+    {
+        (void)step;
+        localOffsetUs += (double)deltaUs;
+    }
+
+private:
+    static const uint8_t MAX_QUEUED = 8;
+
+    struct Reply
+    {
+        uint8_t server;
+        int64_t arrivesUs;
+        uint8_t data[SntpClient::PACKET_SIZE];
+    };
+
+    static void put(uint8_t *p, uint64_t value)
+    {
+        for (int8_t i = 7; i >= 0; i--)
+        {
+            p[i] = (uint8_t)value;
+            value >>= 8;
+        }
+    }
+
+    Reply replies[MAX_QUEUED];
+    uint8_t queued;
+};
+
+static FakeNtp net;
+static SntpClient::Retained state;
+// Rebuilt for each test: the client keeps its query state privately
+static SntpClient *client;
+alignas(SntpClient) static uint8_t clientStorage[sizeof(SntpClient)];
+
+// Step the client in 1 ms ticks until the running query ends; returns its length
+static uint32_t runQuery()
+{
+    uint32_t ms = 0;
+    while (client->isQuerying() && ms < 10000)
+    {
+        net.advance(1);
+        ms++;
+        client->update(net.millis(), true);
+    }
+    return ms;
+}
+
+void setUp()
+{
+    net.reset();
+    state = SntpClient::Retained();
+    client = new (clientStorage) SntpClient(net, state);
+    client->setServerCount(FakeNtp::SERVERS);
+}
+
+void tearDown()
+{
+    client->~SntpClient();
+}
+
+void test_parse_rejects_replies_that_dont_answer_the_request()
+{
+    uint8_t request[SntpClient::PACKET_SIZE];
+    uint64_t originate = SntpClient::toNtp(TRUE_START_US);
+    SntpClient::buildRequest(request, originate);
+    TEST_ASSERT_EQUAL_HEX8(0x23, request[0]); // version 4, client
+
+    net.localOffsetUs = 0;
+    TEST_ASSERT_TRUE(net.send(0, request, sizeof(request)));
+    net.advance(40);
+    uint8_t reply[SntpClient::PACKET_SIZE];
+    uint8_t server;
+    TEST_ASSERT_EQUAL(SntpClient::PACKET_SIZE, net.receive(reply, sizeof(reply), server));
+
+    SntpSample sample;
+    TEST_ASSERT_TRUE(SntpClient::parseReply(reply, sizeof(reply), originate, TRUE_START_US, net.nowUs(), sample));
+    TEST_ASSERT_INT64_WITHIN(1, 0, sample.offsetUs);
+    TEST_ASSERT_INT64_WITHIN(1, 40000, sample.delayUs);
+
+    // Someone else's request, a short packet, a client packet, a kiss-o'-death
+    TEST_ASSERT_FALSE(SntpClient::parseReply(reply, sizeof(reply), originate + 1, TRUE_START_US, net.nowUs(), sample));
+    TEST_ASSERT_FALSE(SntpClient::parseReply(reply, 47, originate, TRUE_START_US, net.nowUs(), sample));
+    reply[0] = 0x23;
+    TEST_ASSERT_FALSE(SntpClient::parseReply(reply, sizeof(reply), originate, TRUE_START_US, net.nowUs(), sample));
+    reply[0] = 0x24;
+    reply[1] = 0;
+    TEST_ASSERT_FALSE(SntpClient::parseReply(reply, sizeof(reply), originate, TRUE_START_US, net.nowUs(), sample));
+}
+
+void test_first_sync_takes_the_first_reply()
+{
+    client->update(net.millis(), true);
+    TEST_ASSERT_TRUE(client->isQuerying());
+    TEST_ASSERT_EQUAL_UINT32(3, net.sends);
+
+    // The 10 ms server answers first and a 1970 clock can't wait for the rest
+    uint32_t ms = runQuery();
+    TEST_ASSERT_EQUAL_UINT32(10, ms);
+    TEST_ASSERT_TRUE(client->isSynced());
+    TEST_ASSERT_INT64_WITHIN(5000, 0, net.errorUs());
+    TEST_ASSERT_EQUAL_UINT32(SntpClient::MIN_INTERVAL, state.intervalS);
+    TEST_ASSERT_EQUAL_UINT32(1, state.syncs);
+}
+
+void test_synced_query_picks_the_shortest_round_trip()
+{
+    client->update(net.millis(), true);
+    runQuery();
+    // Knock the clock 300 ms off and query again: 10 ms and 40 ms answer
+    // within the select window, the slowest server too late
+    net.localOffsetUs += 300000;
+    net.rttMs[2] = 500;
+    client->request(net.millis());
+    uint32_t ms = runQuery();
+    TEST_ASSERT_EQUAL_UINT32(10 + SntpClient::SELECT_WINDOW, ms);
+    TEST_ASSERT_INT64_WITHIN(1, 10000, state.lastDelayUs);
+    TEST_ASSERT_INT64_WITHIN(1000, -300000, state.lastOffsetUs);
+    TEST_ASSERT_INT64_WITHIN(1000, 0, net.errorUs());
+}
+
+void test_failed_query_retries_after_the_unsynced_interval()
+{
+    for (uint8_t i = 0; i < FakeNtp::SERVERS; i++)
+    {
+        net.kiss[i] = true;
+    }
+    client->update(net.millis(), true);
+    uint32_t ms = runQuery();
+    TEST_ASSERT_EQUAL_UINT32(SntpClient::QUERY_TIMEOUT, ms);
+    TEST_ASSERT_FALSE(client->isSynced());
+    TEST_ASSERT_EQUAL_UINT32(1, state.failures);
+    // Counted from the start of the failed attempt
+    TEST_ASSERT_EQUAL_UINT32(SntpClient::RETRY_UNSYNCED - SntpClient::QUERY_TIMEOUT,
+                             client->millisUntilNextStep(net.millis(), true));
+    // Offline, nothing is due at all
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFFUL, client->millisUntilNextStep(net.millis(), false));
+}
+
+void test_drift_is_measured_compensated_and_stretches_the_interval()
+{
+    // A crystal 40 ppm fast, for two simulated days in 1 s steps
+    net.ppm = 40;
+    client->update(net.millis(), true);
+    runQuery();
+    int64_t worst = 0;
+    for (uint32_t s = 0; s < 2 * 86400; s++)
+    {
+        net.advance(1000);
+        client->update(net.millis(), true);
+        runQuery();
+        int64_t error = net.errorUs() < 0 ? -net.errorUs() : net.errorUs();
+        worst = error > worst ? error : worst;
+    }
+    char message[128];
+    snprintf(message, sizeof(message), "drift %.2f ppm, interval %u s, %u syncs, worst error %lld us",
+             state.driftPpm, (unsigned)state.intervalS, (unsigned)state.syncs, (long long)worst);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(state.driftKnown);
+    TEST_ASSERT_FLOAT_WITHIN(2.0, 40.0, state.driftPpm);
+    // Without compensation 40 ppm would allow 1250 s between syncs
+    TEST_ASSERT_GREATER_THAN(5 * 1250, state.intervalS);
+    TEST_ASSERT_LESS_OR_EQUAL(SntpClient::TARGET_ERROR_US, worst);
+}
+
+void test_next_step_rounds_up_to_a_whole_millisecond()
+{
+    client->update(net.millis(), true);
+    runQuery();
+    // Half a millisecond before the resync: waiting 0 ms would spin
+    int64_t due = state.lastSyncUs + (int64_t)state.intervalS * 1000000;
+    net.trueUs += due - 500 - net.nowUs();
+    TEST_ASSERT_EQUAL_UINT32(1, client->millisUntilNextStep(net.millis(), true));
+    net.trueUs += 500;
+    TEST_ASSERT_EQUAL_UINT32(0, client->millisUntilNextStep(net.millis(), true));
+    client->update(net.millis(), true);
+    TEST_ASSERT_TRUE(client->isQuerying());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_rejects_replies_that_dont_answer_the_request);
+    RUN_TEST(test_first_sync_takes_the_first_reply);
+    RUN_TEST(test_synced_query_picks_the_shortest_round_trip);
+    RUN_TEST(test_failed_query_retries_after_the_unsynced_interval);
+    RUN_TEST(test_drift_is_measured_compensated_and_stretches_the_interval);
+    RUN_TEST(test_next_step_rounds_up_to_a_whole_millisecond);
+    return UNITY_END();
+}
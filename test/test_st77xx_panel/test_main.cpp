@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include "../ram_panel_bus.h"
+#include "st77xx_panel.h"
+
+// St77xxPanel against a model of the controller's RAM: the batched stream
+// must leave the same picture as the per-primitive (Adafruit_SPITFT style)
+// one, with fewer transactions, window commands and bytes on the wire
+
+static const int16_t W = RamPanelBus::WIDTH;
+static const int16_t H = RamPanelBus::HEIGHT;
+
+static RamPanelBus batchedRam;
+static RamPanelBus plainRam;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// Roughly one flight screen: clear, a header bar, text, a separator and bars
+static void drawScene(St77xxPanel &panel)
+{
+    panel.beginFrame();
+    panel.fillScreen(ST77XX_BLACK);
+    panel.fillRect(0, 0, W, 14, ST77XX_BLUE);
+    panel.setTextColor(ST77XX_WHITE);
+    panel.setTextSize(1);
+    panel.setCursor(4, 4);
+    panel.print("13:07");
+    panel.setTextColor(ST77XX_YELLOW);
+    panel.setTextSize(2);
+    panel.setCursor(4, 30);
+    panel.print("TFN-SPC");
+    panel.setCursor(4, 54);
+    panel.print("AT76");
+    panel.drawFastHLine(0, 80, W, ST77XX_GREEN);
+    for (int16_t i = 0; i < 4; i++)
+    {
+        panel.fillRect(100 + i * 6, 120 - i * 4, 4, 4 + i * 4, ST77XX_GREEN);
+    }
+    panel.drawPixel(127, 127, ST77XX_RED);
+    panel.endFrame();
+}
+
+void test_init_list_is_one_transaction()
+{
+    TracePanelBus trace;
+    St77xxPanel panel(trace, W, H, 0, 0);
+    panel.begin();
+    TEST_ASSERT_EQUAL_UINT32(1, trace.totals().transactions);
+    TEST_ASSERT_EQUAL_UINT32(19, trace.totals().commands);
+}
+
+void test_batched_stream_draws_the_same_picture_for_less()
+{
+    TracePanelBus batchedTrace(&batchedRam);
+    TracePanelBus plainTrace(&plainRam);
+    St77xxPanel batched(batchedTrace, W, H, 0, 0);
+    St77xxPanel plain(plainTrace, W, H, 0, 0);
+    plain.setBatching(false);
+
+    drawScene(batched);
+    drawScene(plain);
+    TEST_ASSERT_EQUAL_MEMORY(plainRam.ram, batchedRam.ram, sizeof(batchedRam.ram));
+    TEST_ASSERT_EQUAL_HEX16(ST77XX_RED, batchedRam.ram[127][127]);
+    TEST_ASSERT_EQUAL_HEX16(ST77XX_GREEN, batchedRam.ram[80][64]);
+
+    const TracePanelBus::Totals &b = batchedTrace.totals();
+    const TracePanelBus::Totals &p = plainTrace.totals();
+    TEST_ASSERT_EQUAL_UINT32(1, b.transactions);
+    TEST_ASSERT_LESS_THAN(p.transactions, b.transactions);
+    TEST_ASSERT_LESS_THAN(p.commands, b.commands);
+    TEST_ASSERT_LESS_THAN(plainTrace.wireBytes(), batchedTrace.wireBytes());
+    // Same pixels either way; the saving is all in commands and windows
+    TEST_ASSERT_EQUAL_UINT32(p.pixelBytes, b.pixelBytes);
+    TEST_ASSERT_GREATER_THAN(0, batched.stats().streamed);
+
+    char message[200];
+    snprintf(message, sizeof(message),
+             "scene batched: %u transactions, %u commands, %u bytes besides pixels; per primitive: %u, %u, %u",
+             (unsigned)b.transactions, (unsigned)b.commands, (unsigned)(b.commands + b.dataBytes),
+             (unsigned)p.transactions, (unsigned)p.commands, (unsigned)(p.commands + p.dataBytes));
+    TEST_MESSAGE(message);
+}
+
+void test_unchanged_window_is_not_resent()
+{
+    TracePanelBus trace;
+    St77xxPanel panel(trace, W, H, 0, 0);
+    uint16_t row[W] = {};
+    panel.beginFrame();
+    panel.setAddrWindow(0, 10, W, 1);
+    panel.pushPixels(row, W);
+    panel.setAddrWindow(0, 10, W, 1);
+    panel.pushPixels(row, W);
+    panel.endFrame();
+    TEST_ASSERT_EQUAL_UINT32(2, panel.stats().windowSets);
+    TEST_ASSERT_EQUAL_UINT32(2, panel.stats().windowSkips);
+    // CASET, RASET, RAMWR, RAMWR
+    TEST_ASSERT_EQUAL_UINT32(4, trace.totals().commands);
+}
+
+void test_solid_fill_is_one_repeat_burst()
+{
+    TracePanelBus trace;
+    St77xxPanel panel(trace, W, H, 0, 0);
+    panel.fillScreen(ST77XX_BLACK);
+    size_t repeats = 0;
+    for (size_t i = 0; i < trace.eventCount(); i++)
+    {
+        const PanelBusEvent &e = trace.event(i);
+        if (e.type == PanelBusEvent::REPEAT)
+        {
+            repeats++;
+            TEST_ASSERT_EQUAL_UINT32((uint32_t)W * H, e.count);
+        }
+        TEST_ASSERT_NOT_EQUAL(PanelBusEvent::PIXELS, e.type);
+    }
+    TEST_ASSERT_EQUAL(1, repeats);
+    TEST_ASSERT_EQUAL_UINT32(1, trace.totals().bursts);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_init_list_is_one_transaction);
+    RUN_TEST(test_batched_stream_draws_the_same_picture_for_less);
+    RUN_TEST(test_unchanged_window_is_not_resent);
+    RUN_TEST(test_solid_fill_is_one_repeat_burst);
+    return UNITY_END();
+}
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+#include "sim.h"
+#include "time_service.h"
+
+// TimeService on the simulator's device clock, in the firmware's zone:
+// minute-by-minute stepping through both of London's 2025 DST changes must
+// read the same as localtime_r() every time, including the skipped and
+// repeated hours
+
+static const char LONDON[] = "GMT0BST,M3.5.0/1,M10.5.0";
+
+// 2025-03-30 01:00 UTC: 01:00 GMT becomes 02:00 BST
+static const time_t SPRING_FORWARD = 1743296400;
+// 2025-10-26 01:00 UTC: 02:00 BST becomes 01:00 GMT
+static const time_t FALL_BACK = 1761440400;
+
+static void setClock(time_t t)
+{
+    Sim::setDeviceUs((int64_t)t * 1000000);
+}
+
+// What localtime_r() says for `t`, as "HH:MM"
+static void expected(time_t t, char *out)
+{
+    struct tm local;
+    localtime_r(&t, &local);
+    strftime(out, 6, "%H:%M", &local);
+}
+
+// Steps from `from` to `to` every `step` seconds, checking each read. Returns
+// the number of minute changes seen.
+static int walk(time_t from, time_t to, time_t step)
+{
+    int changes = 0;
+    for (time_t t = from; t <= to; t += step)
+    {
+        setClock(t);
+        changes += TimeService::update();
+        char want[6];
+        expected(t, want);
+        char where[48];
+        snprintf(where, sizeof(where), "at %lld", (long long)t);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(want, TimeService::timeString(), where);
+        TEST_ASSERT_EQUAL_MESSAGE(atoi(want), TimeService::hour(), where);
+    }
+    return changes;
+}
+
+void setUp()
+{
+    setClock(SPRING_FORWARD - 3600);
+    TimeService::begin(LONDON);
+}
+
+void tearDown()
+{
+}
+
+void test_spring_forward_skips_an_hour()
+{
+    TEST_ASSERT_EQUAL(SPRING_FORWARD, TimeService::nextDstTransition());
+    setClock(SPRING_FORWARD - 61);
+    TimeService::update();
+    TEST_ASSERT_EQUAL_STRING("00:58", TimeService::timeString());
+    setClock(SPRING_FORWARD - 1);
+    TimeService::update();
+    TEST_ASSERT_EQUAL_STRING("00:59", TimeService::timeString());
+    setClock(SPRING_FORWARD);
+    TEST_ASSERT_TRUE(TimeService::update());
+    TEST_ASSERT_EQUAL_STRING("02:00", TimeService::timeString());
+    TEST_ASSERT_EQUAL(FALL_BACK, TimeService::nextDstTransition());
+}
+
+void test_fall_back_repeats_an_hour()
+{
+    // 01:00-01:59 twice: first in BST...
+    setClock(FALL_BACK - 3600);
+    TimeService::update();
+    TEST_ASSERT_EQUAL_STRING("01:00", TimeService::timeString());
+    TEST_ASSERT_EQUAL(FALL_BACK, TimeService::nextDstTransition());
+    setClock(FALL_BACK - 1);
+    TimeService::update();
+    TEST_ASSERT_EQUAL_STRING("01:59", TimeService::timeString());
+    // ...then in GMT
+    setClock(FALL_BACK);
+    TEST_ASSERT_TRUE(TimeService::update());
+    TEST_ASSERT_EQUAL_STRING("01:00", TimeService::timeString());
+    setClock(FALL_BACK + 3599);
+    TimeService::update();
+    TEST_ASSERT_EQUAL_STRING("01:59", TimeService::timeString());
+}
+
+void test_stepping_through_both_changes_matches_localtime()
+{
+    // Every 20 s for two days around each change, so the incremental path
+    // carries the clock across the transition
+    int spring = walk(SPRING_FORWARD - 86400, SPRING_FORWARD + 86400, 20);
+    int fall = walk(FALL_BACK - 86400, FALL_BACK + 86400, 20);
+    // A change per elapsed minute, plus the first read of each walk (a clock step)
+    TEST_ASSERT_EQUAL(2 * 1440 + 1, spring);
+    TEST_ASSERT_EQUAL(2 * 1440 + 1, fall);
+
+    char message[96];
+    snprintf(message, sizeof(message), "%d + %d minute changes across both transitions, all as localtime_r()",
+             spring, fall);
+    TEST_MESSAGE(message);
+}
+
+void test_clock_steps_recompute()
+{
+    setClock(FALL_BACK + 7200);
+    TimeService::update();
+    // An NTP step back by an hour and a half, mid-minute
+    setClock(FALL_BACK + 7200 - 5430);
+    TEST_ASSERT_TRUE(TimeService::update());
+    char want[6];
+    expected(FALL_BACK + 7200 - 5430, want);
+    TEST_ASSERT_EQUAL_STRING(want, TimeService::timeString());
+    // Forward by a day
+    walk(FALL_BACK + 86400, FALL_BACK + 86400 + 600, 7);
+}
+
+void test_zone_without_dst()
+{
+    setClock(SPRING_FORWARD);
+    TimeService::begin("UTC0");
+    TEST_ASSERT_EQUAL_STRING("01:00", TimeService::timeString());
+    // No transition within the search year: checked again a year on
+    TEST_ASSERT_GREATER_OR_EQUAL(SPRING_FORWARD + 365L * 86400, TimeService::nextDstTransition());
+    walk(SPRING_FORWARD, SPRING_FORWARD + 86400, 30);
+    TimeService::begin(LONDON);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_spring_forward_skips_an_hour);
+    RUN_TEST(test_fall_back_repeats_an_hour);
+    RUN_TEST(test_stepping_through_both_changes_matches_localtime);
+    RUN_TEST(test_clock_steps_recompute);
+    RUN_TEST(test_zone_without_dst);
+    return UNITY_END();
+}
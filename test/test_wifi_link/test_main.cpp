@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <new>
+#include <unity.h>
+#include "wifi_link.h"
+
+// WiFiLink against a scripted driver: no radio, no simulator clock, just
+// the state machine stepped at chosen times
+
+class FakeDriver : public WiFiDriver
+{
+public:
+    bool credentials = true;
+    bool connected = false;
+    bool portalOpen = false;
+    bool staleCache = false; // next abort reports a dropped fast-path cache
+    unsigned long attemptBudget = 15000;
+    unsigned long lastConnectMs = 0;
+    int begins = 0;
+    int aborts = 0;
+    int connects = 0;
+    int portals = 0;
+    int powerOffs = 0;
+
+    bool hasCredentials() override { return credentials; }
+
+    unsigned long beginAttempt() override
+    {
+        begins++;
+        return attemptBudget;
+    }
+
+    bool abortAttempt() override
+    {
+        aborts++;
+        bool retry = staleCache;
+        staleCache = false;
+        return retry;
+    }
+
+    bool isConnected() override { return connected; }
+
+    void onConnected(unsigned long attemptMs) override
+    {
+        connects++;
+        lastConnectMs = attemptMs;
+    }
+
+    void beginPortal() override
+    {
+        portals++;
+        portalOpen = true;
+    }
+
+    bool processPortal() override { return portalOpen; }
+
+    void powerOff() override
+    {
+        powerOffs++;
+        connected = false;
+    }
+};
+
+static FakeDriver *driver;
+static WiFiLink *link;
+static unsigned long now;
+
+void setUp()
+{
+    // Fresh ones per test; WiFiLink holds a reference, so can't be assigned
+    alignas(FakeDriver) static uint8_t driverStorage[sizeof(FakeDriver)];
+    alignas(WiFiLink) static uint8_t linkStorage[sizeof(WiFiLink)];
+    driver = new (driverStorage) FakeDriver();
+    link = new (linkStorage) WiFiLink(*driver);
+    now = 1000;
+}
+
+void tearDown()
+{
+}
+
+// Steps the link as loop() would: at each deadline until `ms` have passed
+static void runFor(unsigned long ms)
+{
+    unsigned long end = now + ms;
+    link->update(now);
+    while (now < end)
+    {
+        unsigned long step = link->millisUntilNextStep(now);
+        now = step == WiFiLink::NO_DEADLINE || step > end - now ? end : now + (step ? step : 1);
+        link->update(now);
+    }
+}
+
+void test_connects_and_reports_the_attempt_time()
+{
+    link->begin(now, true);
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_CONNECTING, link->state());
+    TEST_ASSERT_TRUE(link->isBusy());
+    runFor(2500);
+    driver->connected = true;
+    link->update(now);
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_CONNECTED, link->state());
+    TEST_ASSERT_FALSE(link->isBusy());
+    TEST_ASSERT_EQUAL(1, driver->connects);
+    TEST_ASSERT_EQUAL_UINT32(2500, driver->lastConnectMs);
+    TEST_ASSERT_EQUAL_UINT32(WiFiLink::NO_DEADLINE, link->millisUntilNextStep(now));
+}
+
+void test_radio_stays_off_until_requested()
+{
+    link->begin(now, false);
+    runFor(600000);
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_OFF, link->state());
+    TEST_ASSERT_EQUAL(0, driver->begins);
+    link->request(now);
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_CONNECTING, link->state());
+    link->request(now);
+    TEST_ASSERT_EQUAL(1, driver->begins);
+}
+
+void test_parked_link_stays_off_without_counting_a_drop()
+{
+    link->begin(now, true);
+    driver->connected = true;
+    link->update(now);
+    link->park();
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_OFF, link->state());
+    TEST_ASSERT_EQUAL(1, driver->powerOffs);
+    runFor(600000);
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_OFF, link->state());
+    TEST_ASSERT_EQUAL_UINT32(0, link->drops());
+    link->request(now);
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_CONNECTING, link->state());
+
+    // A connect in progress isn't cut short
+    link->park();
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_CONNECTING, link->state());
+    TEST_ASSERT_EQUAL(1, driver->powerOffs);
+}
+
+void test_backoff_doubles_to_the_cap_and_resets_on_connect()
+{
+    static const unsigned long expected[] = {5000, 10000, 20000, 40000, 80000, 160000, 300000, 300000};
+    char message[128];
+    size_t len = snprintf(message, sizeof(message), "backoff s:");
+    link->begin(now, true);
+    for (unsigned long want : expected)
+    {
+        runFor(driver->attemptBudget);
+        TEST_ASSERT_EQUAL(WiFiLink::LINK_BACKOFF, link->state());
+        TEST_ASSERT_EQUAL_UINT32(want, link->millisUntilNextStep(now));
+        len += snprintf(message + len, sizeof(message) - len, " %lu", want / 1000);
+        runFor(want);
+        TEST_ASSERT_EQUAL(WiFiLink::LINK_CONNECTING, link->state());
+    }
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL(9, driver->begins);
+    TEST_ASSERT_EQUAL(8, link->failures());
+    // No amount of failing opens the portal while there are credentials
+    TEST_ASSERT_EQUAL(0, driver->portals);
+
+    driver->connected = true;
+    link->update(now);
+    TEST_ASSERT_EQUAL(0, link->failures());
+    driver->connected = false;
+    runFor(WiFiLink::DROP_GRACE);
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_BACKOFF, link->state());
+    TEST_ASSERT_EQUAL_UINT32(WiFiLink::INITIAL_BACKOFF, link->millisUntilNextStep(now));
+}
+
+void test_stale_cache_retries_at_once()
+{
+    driver->attemptBudget = 3000;
+    driver->staleCache = true;
+    link->begin(now, true);
+    runFor(3000);
+    // Straight into a second attempt, not a backoff, and not counted as a failure
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_CONNECTING, link->state());
+    TEST_ASSERT_EQUAL(2, driver->begins);
+    TEST_ASSERT_EQUAL(0, link->failures());
+}
+
+void test_drop_waits_for_the_drivers_own_reconnect()
+{
+    link->begin(now, true);
+    driver->connected = true;
+    link->update(now);
+
+    driver->connected = false;
+    link->update(now);
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_CONNECTING, link->state());
+    TEST_ASSERT_EQUAL_UINT32(1, link->drops());
+    TEST_ASSERT_EQUAL_UINT32(WiFiLink::DROP_GRACE, link->millisUntilNextStep(now));
+    runFor(WiFiLink::DROP_GRACE - 1000);
+    driver->connected = true;
+    link->update(now);
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_CONNECTED, link->state());
+    // Reconnected within the grace: no attempt of our own
+    TEST_ASSERT_EQUAL(1, driver->begins);
+    TEST_ASSERT_EQUAL(0, driver->aborts);
+
+    driver->connected = false;
+    runFor(WiFiLink::DROP_GRACE);
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_BACKOFF, link->state());
+    TEST_ASSERT_EQUAL(1, driver->aborts);
+    runFor(WiFiLink::INITIAL_BACKOFF);
+    TEST_ASSERT_EQUAL(2, driver->begins);
+}
+
+void test_portal_without_credentials_then_joined_from_it()
+{
+    driver->credentials = false;
+    link->begin(now, true);
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_PORTAL, link->state());
+    TEST_ASSERT_TRUE(link->isBusy());
+    TEST_ASSERT_EQUAL(0, driver->begins);
+    TEST_ASSERT_EQUAL_UINT32(WiFiLink::PORTAL_POLL, link->millisUntilNextStep(now));
+    runFor(60000);
+    TEST_ASSERT_EQUAL(1, driver->portals);
+
+    driver->credentials = true;
+    driver->connected = true;
+    driver->portalOpen = false;
+    link->update(now);
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_CONNECTED, link->state());
+    TEST_ASSERT_EQUAL(1, driver->connects);
+}
+
+void test_portal_on_request_falls_back_to_the_network_when_it_closes()
+{
+    link->begin(now, true);
+    link->openPortal(now);
+    link->openPortal(now);
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_PORTAL, link->state());
+    TEST_ASSERT_EQUAL(1, driver->portals);
+    driver->portalOpen = false;
+    link->update(now);
+    TEST_ASSERT_EQUAL(WiFiLink::LINK_CONNECTING, link->state());
+    TEST_ASSERT_EQUAL(2, driver->begins);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_connects_and_reports_the_attempt_time);
+    RUN_TEST(test_radio_stays_off_until_requested);
+    RUN_TEST(test_parked_link_stays_off_without_counting_a_drop);
+    RUN_TEST(test_backoff_doubles_to_the_cap_and_resets_on_connect);
+    RUN_TEST(test_stale_cache_retries_at_once);
+    RUN_TEST(test_drop_waits_for_the_drivers_own_reconnect);
+    RUN_TEST(test_portal_without_credentials_then_joined_from_it);
+    RUN_TEST(test_portal_on_request_falls_back_to_the_network_when_it_closes);
+    return UNITY_END();
+}
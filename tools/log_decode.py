@@ -0,0 +1,196 @@
+"""Decode a tokenized log stream (include/ft_log.h, FT_LOG_TOKENIZED).
+
+Reads raw serial output, passes plain text through and turns every log
+frame back into the line text logging would have printed:
+
+    pio device monitor --raw | python tools/log_decode.py .pio/build/<env>/log_tokens.csv
+    python tools/log_decode.py log_tokens.csv capture.bin
+    python tools/log_decode.py log_tokens.csv --port /dev/ttyACM0   (needs pyserial)
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from log_tokens import read_csv  # noqa: E402
+
+# Frames longer than this can't come from the firmware; treat them as text
+MAX_FRAME = 512
+
+SPEC = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|j|z|t|L)?([diouxXeEfFgGcsp%])")
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class Args:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def varint(self):
+        value = shift = 0
+        while True:
+            if self.pos >= len(self.data):
+                raise ValueError("argument data ended early")
+            b = self.data[self.pos]
+            self.pos += 1
+            value |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return value
+
+    def integer(self):
+        v = self.varint()
+        return (v >> 1) ^ -(v & 1)
+
+    def real(self):
+        if self.pos + 4 > len(self.data):
+            raise ValueError("argument data ended early")
+        (v,) = struct.unpack_from("<f", self.data, self.pos)
+        self.pos += 4
+        return v
+
+    def string(self):
+        if self.pos >= len(self.data):
+            raise ValueError("argument data ended early")
+        n = self.data[self.pos]
+        self.pos += 1
+        s = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return s.decode("utf-8", "replace")
+
+
+def render(fmt, args):
+    """printf `fmt` with arguments taken from the frame, as the device would."""
+    def one(m):
+        flags, width, prec, length, conv = m.groups()
+        if conv == "%":
+            return "%"
+        if width == "*":
+            width = str(args.integer())
+        if prec == "*":
+            prec = str(args.integer())
+        spec = "%" + flags + (width or "") + ("." + prec if prec is not None else "")
+        if conv in "di":
+            return (spec + "d") % args.integer()
+        if conv in "ouxX":
+            v = args.integer()
+            bits = 64 if length in ("ll", "j") else 32  # long is 32-bit on the ESP32
+            return (spec + conv.replace("u", "d")) % (v & ((1 << bits) - 1))
+        if conv in "eEfFgG":
+            return (spec + conv) % args.real()
+        if conv == "c":
+            return (spec + "c") % chr(args.integer() & 0xFF)
+        if conv == "s":
+            return (spec + "s") % args.string()
+        return "0x%x" % (args.integer() & 0xFFFFFFFF)  # %p
+    return SPEC.sub(one, fmt)
+
+
+def decode_frame(chunk, db):
+    """Line text for one frame, or None if `chunk` isn't a valid frame."""
+    payload = cobs_decode(chunk)
+    if not payload or len(payload) < 6:
+        return None
+    check = 0xA5
+    for b in payload[:-1]:
+        check ^= b
+    if check != payload[-1]:
+        return None
+    (token,) = struct.unpack_from("<I", payload)
+    args = Args(payload[4:-1])
+    try:
+        ms = args.varint()
+    except ValueError:
+        return None
+    prefix = "[%5d.%03d]" % (ms // 1000, ms % 1000)
+    entry = db.get(token)
+    if entry is None:
+        return "%s ? unknown token %08x (%d argument bytes)" % (prefix, token, len(payload) - 5 - args.pos)
+    level, tag, fmt = entry
+    try:
+        text = render(fmt, args)
+    except (ValueError, IndexError, OverflowError) as e:
+        text = "%s [argument decode failed: %s]" % (fmt, e)
+    return "%s %s %s: %s" % (prefix, level, tag, text)
+
+
+class Decoder:
+    """Frames are 00 <COBS> 00; everything else is text. After a frame the
+    next bytes are text up to the following zero, which opens a candidate
+    frame. A candidate that doesn't decode is printed as text."""
+
+    def __init__(self, db, out):
+        self.db = db
+        self.out = out
+        self.candidate = None  # bytearray while inside a possible frame
+
+    def feed(self, data):
+        for b in data:
+            if self.candidate is None:
+                if b == 0:
+                    self.candidate = bytearray()
+                else:
+                    self.out.write(bytes([b]))
+                continue
+            if b != 0:
+                self.candidate.append(b)
+                if len(self.candidate) > MAX_FRAME:
+                    self.out.write(bytes(self.candidate))
+                    self.candidate = None
+                continue
+            if not self.candidate:
+                continue  # 00 00: still at a frame start
+            line = decode_frame(bytes(self.candidate), self.db)
+            if line is None:
+                # Not a frame; this zero may open the real one
+                self.out.write(bytes(self.candidate))
+                self.candidate = bytearray()
+            else:
+                self.out.write((line + "\n").encode("utf-8"))
+                self.candidate = None
+        self.out.flush()
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument("database", help="log_tokens.csv from the build")
+    p.add_argument("capture", nargs="?", help="raw capture file (default: stdin)")
+    p.add_argument("--port", help="read a serial port instead")
+    p.add_argument("--baud", type=int, default=115200)
+    a = p.parse_args()
+
+    decoder = Decoder(read_csv(a.database), sys.stdout.buffer)
+    if a.port:
+        import serial  # pyserial
+        with serial.Serial(a.port, a.baud, timeout=0.1) as port:
+            while True:
+                decoder.feed(port.read(256))
+    source = open(a.capture, "rb") if a.capture else sys.stdin.buffer
+    while True:
+        data = source.read1(4096) if hasattr(source, "read1") else source.read(4096)
+        if not data:
+            break
+        decoder.feed(data)
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,142 @@
+"""Token database for tokenized logging (include/ft_log.h).
+
+Finds every FT_LOGx(tag, "format", ...) call in the sources and writes one
+CSV row per call: token, level letter, tag, format. The token is the same
+FNV-1a hash Log::token() computes at compile time.
+
+As a PlatformIO pre-script (extra_scripts = pre:tools/log_tokens.py) it
+writes $BUILD_DIR/log_tokens.csv before every build. Standalone:
+
+    python tools/log_tokens.py src include > log_tokens.csv
+"""
+
+import csv
+import io
+import os
+import re
+import sys
+
+LEVELS = "-EWIDV"
+
+STRING = r'"(?:[^"\\\n]|\\.)*"'
+# Strings are matched first so "http://..." isn't taken for a comment
+LEXEMES = re.compile(STRING + r"|'(?:[^'\\\n]|\\.)*'|//[^\n]*|/\*.*?\*/", re.S)
+CALL = re.compile(r"\bFT_LOG([EWIDV])\(\s*(\w+|" + STRING + r")\s*,\s*((?:" + STRING + r"\s*)+)")
+TAG = re.compile(r"\bstatic\s+constexpr\s+char\s+(\w+)\s*\[\s*\]\s*=\s*(" + STRING + r")\s*;")
+PIECE = re.compile(STRING)
+ESCAPES = {"n": "\n", "t": "\t", "r": "\r", "0": "\0", "\\": "\\", '"': '"', "'": "'", "a": "\a", "b": "\b",
+           "f": "\f", "v": "\v", "?": "?"}
+
+
+def strip_comments(source):
+    return LEXEMES.sub(lambda m: m.group(0) if m.group(0)[0] in "\"'" else " ", source)
+
+
+def unescape(literal):
+    """Bytes of a C string literal (quotes included)."""
+    out = bytearray()
+    body = literal[1:-1]
+    i = 0
+    while i < len(body):
+        c = body[i]
+        if c != "\\":
+            out += c.encode("utf-8")
+            i += 1
+            continue
+        e = body[i + 1]
+        if e == "x":
+            m = re.match(r"[0-9a-fA-F]+", body[i + 2:])
+            out.append(int(m.group(0), 16) & 0xFF)
+            i += 2 + len(m.group(0))
+        elif e in "01234567":
+            m = re.match(r"[0-7]{1,3}", body[i + 1:])
+            out.append(int(m.group(0), 8) & 0xFF)
+            i += 1 + len(m.group(0))
+        else:
+            out += ESCAPES.get(e, e).encode("utf-8")
+            i += 2
+    return bytes(out)
+
+
+def concat(literals):
+    return b"".join(unescape(p) for p in PIECE.findall(literals))
+
+
+def fnv1a(data, h=2166136261):
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def token(level, tag, fmt):
+    return fnv1a(fmt, (fnv1a(tag, fnv1a(level.encode())) ^ 0x1F) * 16777619 & 0xFFFFFFFF)
+
+
+def scan_file(path):
+    with open(path, encoding="utf-8", errors="replace") as f:
+        source = strip_comments(f.read())
+    tags = {m.group(1): unescape(m.group(2)) for m in TAG.finditer(source)}
+    for m in CALL.finditer(source):
+        level, tag, fmt = m.group(1), m.group(2), concat(m.group(3))
+        if tag.startswith('"'):
+            tag = unescape(tag)
+        elif tag in tags:
+            tag = tags[tag]
+        else:
+            line = source.count("\n", 0, m.start()) + 1
+            sys.stderr.write("%s:%d: tag %s is not a constexpr char array here, skipped\n" % (path, line, tag))
+            continue
+        yield level, tag, fmt
+
+
+def scan(paths):
+    entries = {}
+    for root in paths:
+        files = [root] if os.path.isfile(root) else [
+            os.path.join(d, f) for d, _, names in os.walk(root) for f in sorted(names)
+            if f.endswith((".c", ".cpp", ".h", ".hpp"))]
+        for path in files:
+            for level, tag, fmt in scan_file(path):
+                t = token(level, tag, fmt)
+                entry = (level, tag, fmt)
+                if t in entries and entries[t] != entry:
+                    sys.stderr.write("token collision 0x%08x: %r and %r\n" % (t, entries[t], entry))
+                entries[t] = entry
+    return entries
+
+
+def write_csv(entries, out):
+    w = csv.writer(out, lineterminator="\n")
+    for t in sorted(entries):
+        level, tag, fmt = entries[t]
+        w.writerow(["%08x" % t, level, tag.decode("utf-8", "replace"), fmt.decode("utf-8", "replace")])
+
+
+def read_csv(path):
+    """{token: (level, tag, format)} as written by write_csv()."""
+    with open(path, newline="", encoding="utf-8") as f:
+        return {int(row[0], 16): (row[1], row[2], row[3]) for row in csv.reader(f) if row}
+
+
+def build(paths, db_path):
+    entries = scan(paths)
+    text = io.StringIO()
+    write_csv(entries, text)
+    os.makedirs(os.path.dirname(db_path) or ".", exist_ok=True)
+    # Leave the file alone when nothing changed
+    if not os.path.exists(db_path) or open(db_path, encoding="utf-8").read() != text.getvalue():
+        with open(db_path, "w", encoding="utf-8") as f:
+            f.write(text.getvalue())
+    print("Log token database: %d entries in %s" % (len(entries), db_path))
+
+
+try:
+    Import("env")  # noqa: F821 (PlatformIO/SCons builtin)
+except NameError:
+    env = None
+
+if env is not None:
+    build([env.subst("$PROJECT_SRC_DIR"), env.subst("$PROJECT_INCLUDE_DIR")],
+          os.path.join(env.subst("$BUILD_DIR"), "log_tokens.csv"))
+elif __name__ == "__main__":
+    write_csv(scan(sys.argv[1:] or ["src", "include"]), sys.stdout)
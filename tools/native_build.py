@@ -0,0 +1,14 @@
+"""PlatformIO pre-script for the desktop simulator ([env:native]).
+
+Adafruit GFX ships its SPI and I2C display drivers in the same library as
+the canvas. The simulator only needs the canvas (the panel driver is our
+own, include/panel_bus.h), and those drivers want Adafruit BusIO, which
+doesn't build off the device, so they're left out of the build.
+"""
+
+Import("env")  # noqa: F821 (PlatformIO/SCons builtin)
+
+SKIPPED = ("*/Adafruit_SPITFT.cpp", "*/Adafruit_GrayOLED.cpp")
+
+for pattern in SKIPPED:
+    env.AddBuildMiddleware(lambda node: None, pattern)  # noqa: F821
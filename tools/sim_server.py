@@ -0,0 +1,76 @@
+"""Stand-in HTTP server for the desktop simulator (host/, [env:native]).
+
+The simulator sends every fetch here, whatever the URL's host, and the
+Host header tells the endpoints apart: /v1/forecast gets an Open-Meteo
+reply, anything else a flight.
+
+    python tools/sim_server.py                    # port 8080, built-in flights
+    python tools/sim_server.py --flights flights.json --port 9000
+
+The flights file is a JSON list of objects as the flight endpoint returns
+them; each request gets the next one. Without it the built-in list is used,
+with an occasional "no flight overhead" reply in between.
+"""
+
+import argparse
+import json
+import math
+import time
+from http.server import BaseHTTPRequestHandler, HTTPServer
+
+FLIGHTS = [
+    {"flightDataAvailable": True, "callsign": "IBB8121", "originAirportIata": "TFN",
+     "destinationAirportIata": "SPC", "aircraftCode": "AT76"},
+    {"flightDataAvailable": True, "callsign": "BTI7TK", "originAirportIata": "RIX",
+     "destinationAirportIata": "SPC", "aircraftCode": "BCS3"},
+    {"flightDataAvailable": False},
+    {"flightDataAvailable": True, "callsign": "VLG3270", "originAirportIata": "SPC",
+     "destinationAirportIata": "BCN", "aircraftCode": "A320"},
+    {"flightDataAvailable": True, "callsign": "BNT8NC", "originAirportIata": "SPC",
+     "destinationAirportIata": "LPA", "aircraftCode": "AT75"},
+    {"flightDataAvailable": False},
+]
+
+
+class Handler(BaseHTTPRequestHandler):
+    flights = FLIGHTS
+    served = 0
+
+    def do_GET(self):
+        if self.path.startswith("/v1/forecast"):
+            # A slow drift so consecutive screens differ
+            phase = time.time() / 600.0
+            body = {"current": {"temperature_2m": round(21.0 + 3.0 * math.sin(phase), 1),
+                                "relative_humidity_2m": int(65 + 10 * math.cos(phase))}}
+        else:
+            body = Handler.flights[Handler.served % len(Handler.flights)]
+            Handler.served += 1
+        data = json.dumps(body).encode()
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+
+    def log_message(self, format, *args):
+        print("%s %s" % (self.headers.get("Host", "-"), format % args))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--flights", help="JSON list of flight replies, served in turn")
+    args = parser.parse_args()
+    if args.flights:
+        with open(args.flights, encoding="utf-8") as f:
+            Handler.flights = json.load(f)
+    server = HTTPServer(("127.0.0.1", args.port), Handler)
+    print("Serving the simulator on 127.0.0.1:%d" % args.port)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()